@@ -1349,15 +1349,80 @@ static void mxt_calc_crc24(u32 *crc, u8 firstbyte, u8 secondbyte)
 	*crc = result;
 }
 
+/*
+ * mxt_calc_crc24() applied eight times to a CRC holding only its top byte,
+ * with zero data words. Eight words shifted in never reach bit 23 within
+ * those eight steps, so they are simply xored in at their final position.
+ */
+static const u32 mxt_crc24_table[256] = {
+	0x000000, 0x80001b, 0x80002d, 0x000036, 0x800041, 0x00005a,
+	0x00006c, 0x800077, 0x800099, 0x000082, 0x0000b4, 0x8000af,
+	0x0000d8, 0x8000c3, 0x8000f5, 0x0000ee, 0x800129, 0x000132,
+	0x000104, 0x80011f, 0x000168, 0x800173, 0x800145, 0x00015e,
+	0x0001b0, 0x8001ab, 0x80019d, 0x000186, 0x8001f1, 0x0001ea,
+	0x0001dc, 0x8001c7, 0x800249, 0x000252, 0x000264, 0x80027f,
+	0x000208, 0x800213, 0x800225, 0x00023e, 0x0002d0, 0x8002cb,
+	0x8002fd, 0x0002e6, 0x800291, 0x00028a, 0x0002bc, 0x8002a7,
+	0x000360, 0x80037b, 0x80034d, 0x000356, 0x800321, 0x00033a,
+	0x00030c, 0x800317, 0x8003f9, 0x0003e2, 0x0003d4, 0x8003cf,
+	0x0003b8, 0x8003a3, 0x800395, 0x00038e, 0x800489, 0x000492,
+	0x0004a4, 0x8004bf, 0x0004c8, 0x8004d3, 0x8004e5, 0x0004fe,
+	0x000410, 0x80040b, 0x80043d, 0x000426, 0x800451, 0x00044a,
+	0x00047c, 0x800467, 0x0005a0, 0x8005bb, 0x80058d, 0x000596,
+	0x8005e1, 0x0005fa, 0x0005cc, 0x8005d7, 0x800539, 0x000522,
+	0x000514, 0x80050f, 0x000578, 0x800563, 0x800555, 0x00054e,
+	0x0006c0, 0x8006db, 0x8006ed, 0x0006f6, 0x800681, 0x00069a,
+	0x0006ac, 0x8006b7, 0x800659, 0x000642, 0x000674, 0x80066f,
+	0x000618, 0x800603, 0x800635, 0x00062e, 0x8007e9, 0x0007f2,
+	0x0007c4, 0x8007df, 0x0007a8, 0x8007b3, 0x800785, 0x00079e,
+	0x000770, 0x80076b, 0x80075d, 0x000746, 0x800731, 0x00072a,
+	0x00071c, 0x800707, 0x800909, 0x000912, 0x000924, 0x80093f,
+	0x000948, 0x800953, 0x800965, 0x00097e, 0x000990, 0x80098b,
+	0x8009bd, 0x0009a6, 0x8009d1, 0x0009ca, 0x0009fc, 0x8009e7,
+	0x000820, 0x80083b, 0x80080d, 0x000816, 0x800861, 0x00087a,
+	0x00084c, 0x800857, 0x8008b9, 0x0008a2, 0x000894, 0x80088f,
+	0x0008f8, 0x8008e3, 0x8008d5, 0x0008ce, 0x000b40, 0x800b5b,
+	0x800b6d, 0x000b76, 0x800b01, 0x000b1a, 0x000b2c, 0x800b37,
+	0x800bd9, 0x000bc2, 0x000bf4, 0x800bef, 0x000b98, 0x800b83,
+	0x800bb5, 0x000bae, 0x800a69, 0x000a72, 0x000a44, 0x800a5f,
+	0x000a28, 0x800a33, 0x800a05, 0x000a1e, 0x000af0, 0x800aeb,
+	0x800add, 0x000ac6, 0x800ab1, 0x000aaa, 0x000a9c, 0x800a87,
+	0x000d80, 0x800d9b, 0x800dad, 0x000db6, 0x800dc1, 0x000dda,
+	0x000dec, 0x800df7, 0x800d19, 0x000d02, 0x000d34, 0x800d2f,
+	0x000d58, 0x800d43, 0x800d75, 0x000d6e, 0x800ca9, 0x000cb2,
+	0x000c84, 0x800c9f, 0x000ce8, 0x800cf3, 0x800cc5, 0x000cde,
+	0x000c30, 0x800c2b, 0x800c1d, 0x000c06, 0x800c71, 0x000c6a,
+	0x000c5c, 0x800c47, 0x800fc9, 0x000fd2, 0x000fe4, 0x800fff,
+	0x000f88, 0x800f93, 0x800fa5, 0x000fbe, 0x000f50, 0x800f4b,
+	0x800f7d, 0x000f66, 0x800f11, 0x000f0a, 0x000f3c, 0x800f27,
+	0x000ee0, 0x800efb, 0x800ecd, 0x000ed6, 0x800ea1, 0x000eba,
+	0x000e8c, 0x800e97, 0x800e79, 0x000e62, 0x000e54, 0x800e4f,
+	0x000e38, 0x800e23, 0x800e15, 0x000e0e,
+};
+
 static u32 mxt_calculate_crc(u8 *base, off_t start_off, off_t end_off)
 {
 	u32 crc = 0;
+	u32 data_word;
 	u8 *ptr = base + start_off;
 	u8 *last_val = base + end_off - 1;
+	int i;
 
 	if (end_off < start_off)
 		return -EINVAL;
 
+	/* eight words at a time while at least 16 bytes are left */
+	while (last_val - ptr >= 15) {
+		data_word = 0;
+		for (i = 0; i < 8; i++)
+			data_word ^= ((ptr[2 * i + 1] << 8) | ptr[2 * i]) << (7 - i);
+
+		crc &= 0x00FFFFFF;
+		crc = ((crc << 8) & 0x00FFFFFF) ^
+			mxt_crc24_table[crc >> 16] ^ data_word;
+		ptr += 16;
+	}
+
 	while (ptr < last_val) {
 		mxt_calc_crc24(&crc, *ptr, *(ptr + 1));
 		ptr += 2;
@@ -4012,3 +4077,7 @@ module_i2c_driver(mxt_driver);
 MODULE_AUTHOR("Joonyoung Shim <jy0922.shim@samsung.com>");
 MODULE_DESCRIPTION("Atmel maXTouch Touchscreen driver");
 MODULE_LICENSE("GPL");
+
+#if IS_ENABLED(CONFIG_TOUCHSCREEN_KUNIT_TEST)
+#include "../touch_kunit/tests/atmel_mxt_crc_test.c"
+#endif
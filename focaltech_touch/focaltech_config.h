@@ -213,6 +213,13 @@
  */
 #define FTS_POWER_SOURCE_CUST_EN                1
 
+/*
+ * Read touch data sized by the points of last frame,
+ * top up the rest only when more points follow
+ * default: enable
+ */
+#define FTS_READ_TOUCH_PREDICT_EN               1
+
 /****************************************************/
 
 /********************** Upgrade ****************************/
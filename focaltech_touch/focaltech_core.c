@@ -1832,6 +1832,14 @@ static int fts_read_touchdata(struct fts_ts_data *data)
 {
 	int ret = 0;
 	u8 *buf = data->point_buf;
+#if FTS_READ_TOUCH_PREDICT_EN
+	int i = 0;
+	int pnt_num = 0;
+	int read_len = 0;
+	int total_len = 0;
+	int max_touch_num = data->pdata->max_touch_number;
+	u8 cmd = 0;
+#endif
 
 	memset(buf, 0xFF, data->pnt_buf_size);
 	buf[0] = 0x01;
@@ -1843,11 +1851,47 @@ static int fts_read_touchdata(struct fts_ts_data *data)
 		}
 	}
 
+#if FTS_READ_TOUCH_PREDICT_EN
+	/*
+	 * read one point more than last frame, so the terminator of a frame
+	 * with the same point count falls inside this read
+	 */
+	pnt_num = clamp(data->pnt_predict_num + 1, 1, max_touch_num);
+	read_len = FTS_TOUCH_READ_LEN(pnt_num);
+	ret = fts_read(buf, 1, buf + 1, read_len);
+	if (ret < 0) {
+		FTS_ERROR("read touchdata failed, ret:%d", ret);
+		return ret;
+	}
+	total_len = read_len;
+
+	/* last point read is valid, the rest may carry more points */
+	if ((pnt_num < max_touch_num) && ((buf[FTS_TOUCH_ID_POS +
+		FTS_ONE_TCH_LEN * (pnt_num - 1)] >> 4) < FTS_MAX_ID)) {
+		cmd = buf[0] + read_len;
+		total_len = FTS_TOUCH_READ_LEN(max_touch_num);
+		ret = fts_read(&cmd, 1, buf + 1 + read_len, total_len - read_len);
+		if (ret < 0) {
+			FTS_ERROR("read rest touchdata failed, ret:%d", ret);
+			return ret;
+		}
+		data->touch_read_topup++;
+	}
+
+	for (i = 0; i < max_touch_num; i++) {
+		if ((buf[FTS_TOUCH_ID_POS + FTS_ONE_TCH_LEN * i] >> 4) >= FTS_MAX_ID)
+			break;
+	}
+	data->pnt_predict_num = i;
+	data->touch_read_frames++;
+	data->touch_read_bytes += total_len;
+#else
 	ret = fts_read(buf, 1, buf + 1, data->pnt_buf_size - 1);
 	if (ret < 0) {
 		FTS_ERROR("read touchdata failed, ret:%d", ret);
 		return ret;
 	}
+#endif
 
 	if (data->log_level >= 3) {
 		fts_show_touch_buffer(buf, data->pnt_buf_size);
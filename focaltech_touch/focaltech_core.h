@@ -76,6 +76,8 @@
 #define FTS_KEY_DIM                         10
 #define FTS_ONE_TCH_LEN                     6
 #define FTS_TOUCH_DATA_LEN  (FTS_MAX_POINTS_SUPPORT * FTS_ONE_TCH_LEN + 3)
+/* touch data length read from reg 0x01 for num points */
+#define FTS_TOUCH_READ_LEN(num)             ((num) * FTS_ONE_TCH_LEN + 2)
 
 #define FTS_GESTURE_POINTS_MAX              6
 #define FTS_GESTURE_DATA_LEN               (FTS_GESTURE_POINTS_MAX * 4 + 4)
@@ -274,6 +276,10 @@ struct fts_ts_data {
 	int key_state;
 	int touch_point;
 	int point_num;
+	int pnt_predict_num;    /* valid points in last frame */
+	u64 touch_read_frames;
+	u64 touch_read_bytes;
+	u32 touch_read_topup;
 	struct regulator *vdd;
 	struct regulator *vcc_i2c;
 	bool qts_en;	/* indicate whether qts is enabled or not */
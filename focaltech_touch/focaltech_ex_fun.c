@@ -1065,6 +1065,42 @@ static ssize_t fts_log_level_store(
 	return count;
 }
 
+/* fts_touch_read interface */
+static ssize_t fts_touch_read_show(
+	struct device *dev, struct device_attribute *attr, char *buf)
+{
+	int count = 0;
+	u64 frames = fts_data->touch_read_frames;
+	u64 bytes = fts_data->touch_read_bytes;
+	struct input_dev *input_dev = fts_data->input_dev;
+
+	mutex_lock(&input_dev->mutex);
+	count += snprintf(buf + count, PAGE_SIZE, "frames:%llu\n", frames);
+	count += snprintf(buf + count, PAGE_SIZE, "bytes:%llu\n", bytes);
+	count += snprintf(buf + count, PAGE_SIZE, "bytes per frame:%llu\n",
+			frames ? div64_u64(bytes, frames) : 0);
+	count += snprintf(buf + count, PAGE_SIZE, "top up reads:%u\n",
+			fts_data->touch_read_topup);
+	mutex_unlock(&input_dev->mutex);
+
+	return count;
+}
+
+static ssize_t fts_touch_read_store(
+	struct device *dev,
+	struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct input_dev *input_dev = fts_data->input_dev;
+
+	mutex_lock(&input_dev->mutex);
+	fts_data->touch_read_frames = 0;
+	fts_data->touch_read_bytes = 0;
+	fts_data->touch_read_topup = 0;
+	mutex_unlock(&input_dev->mutex);
+
+	return count;
+}
+
 #ifdef CONFIG_FTS_TRUSTED_TOUCH
 
 static ssize_t trusted_touch_enable_show(struct device *dev,
@@ -1177,6 +1213,7 @@ static DEVICE_ATTR(fts_irq, S_IRUGO | S_IWUSR, fts_irq_show, fts_irq_store);
 static DEVICE_ATTR(fts_boot_mode, S_IRUGO | S_IWUSR, fts_bootmode_show, fts_bootmode_store);
 static DEVICE_ATTR(fts_touch_point, S_IRUGO | S_IWUSR, fts_tpbuf_show, fts_tpbuf_store);
 static DEVICE_ATTR(fts_log_level, S_IRUGO | S_IWUSR, fts_log_level_show, fts_log_level_store);
+static DEVICE_ATTR(fts_touch_read, S_IRUGO | S_IWUSR, fts_touch_read_show, fts_touch_read_store);
 #ifdef CONFIG_FTS_TRUSTED_TOUCH
 static DEVICE_ATTR_RW(trusted_touch_enable);
 static DEVICE_ATTR_RW(trusted_touch_event);
@@ -1194,6 +1231,7 @@ static struct attribute *fts_attributes[] = {
 	&dev_attr_fts_boot_mode.attr,
 	&dev_attr_fts_touch_point.attr,
 	&dev_attr_fts_log_level.attr,
+	&dev_attr_fts_touch_read.attr,
 #ifdef CONFIG_FTS_TRUSTED_TOUCH
 	&dev_attr_trusted_touch_enable.attr,
 	&dev_attr_trusted_touch_event.attr,
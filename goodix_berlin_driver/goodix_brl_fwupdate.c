@@ -14,6 +14,7 @@
  * General Public License for more details.
  *
  */
+#include <linux/crc32.h>
 #include "goodix_ts_core.h"
 
 #define BUS_TYPE_SPI					1
@@ -201,6 +202,22 @@ struct config_data {
 	int size;
 };
 
+/**
+ * fw_flash_record - what was written to one flash area
+ * @valid: record is valid, the area holds the data described below
+ * @type: subsystem type
+ * @size: data size
+ * @flash_addr: flash address
+ * @crc: crc32 of the data
+ */
+struct fw_flash_record {
+	bool valid;
+	u8 type;
+	u32 size;
+	u32 flash_addr;
+	u32 crc;
+};
+
 #pragma pack(1)
 struct goodix_flash_cmd {
 	union {
@@ -248,6 +265,12 @@ enum compare_status {
  * @attr_fwimage: sysfs bin attrs, for storing fw image
  * @fw_data_src: firmware data source form sysfs, request or head file
  * @kobj: pointer to the sysfs kobject
+ * @flash_record: data written to or verified in each flash area, used
+ *   to skip the subsystems that are unchanged or already flashed by an
+ *   interrupted update once a read back confirms them
+ * @diff_update: add UPDATE_MODE_DIFF to the updates started from sysfs
+ * @flashed_num: subsystems flashed by the last update
+ * @skipped_num: subsystems skipped by the last update
  */
 struct fw_update_ctrl {
 	struct mutex mutex;
@@ -264,6 +287,12 @@ struct fw_update_ctrl {
 
 	struct bin_attribute attr_fwimage;
 	struct kobject *kobj;
+
+	/* subsystems flashed so far, index FW_SUBSYS_MAX_NUM is the config */
+	struct fw_flash_record flash_record[FW_SUBSYS_MAX_NUM + 1];
+	bool diff_update;
+	int flashed_num;
+	int skipped_num;
 };
 static struct fw_update_ctrl goodix_fw_update_ctrl;
 
@@ -852,6 +881,135 @@ static int goodix_flash_subsystem(struct fw_subsys_info *subsys)
 	return r;
 }
 
+static struct fw_flash_record *goodix_find_flash_record(
+		struct fw_update_ctrl *fw_ctrl, u32 flash_addr)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(fw_ctrl->flash_record); i++) {
+		if (fw_ctrl->flash_record[i].valid &&
+			fw_ctrl->flash_record[i].flash_addr == flash_addr)
+			return &fw_ctrl->flash_record[i];
+	}
+
+	return NULL;
+}
+
+static void goodix_clear_flash_record(struct fw_update_ctrl *fw_ctrl,
+		u32 flash_addr, u32 size)
+{
+	struct fw_flash_record *record;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(fw_ctrl->flash_record); i++) {
+		record = &fw_ctrl->flash_record[i];
+		if (record->valid && flash_addr < record->flash_addr + record->size &&
+			record->flash_addr < flash_addr + size)
+			record->valid = false;
+	}
+}
+
+/**
+ * goodix_read_flash_crc - read a flash area back through the ISP
+ *  and compute its crc32
+ * @subsys: subsystem information, gives the area to read
+ * @crc: crc32 of the data read back
+ * return: 0 ok, < 0 error
+ */
+static int goodix_read_flash_crc(struct fw_subsys_info *subsys, u32 *crc)
+{
+	u32 isp_buffer_reg = goodix_fw_update_ctrl.update_info->isp_buffer_reg;
+	struct goodix_flash_cmd flash_cmd;
+	u32 data_size, offset;
+	u8 *buf;
+	int r = 0;
+
+	buf = kzalloc(ISP_MAX_BUFFERSIZE, GFP_KERNEL);
+	if (!buf)
+		return -ENOMEM;
+
+	*crc = ~0;
+	for (offset = 0; offset < subsys->size; offset += data_size) {
+		data_size = min_t(u32, subsys->size - offset,
+				ISP_MAX_BUFFERSIZE);
+
+		memset(&flash_cmd, 0, sizeof(flash_cmd));
+		flash_cmd.len = FLASH_CMD_LEN;
+		flash_cmd.cmd = FLASH_CMD_TYPE_READ;
+		flash_cmd.fw_type = subsys->type;
+		flash_cmd.fw_len = cpu_to_le16(data_size);
+		flash_cmd.fw_addr = cpu_to_le32(subsys->flash_addr + offset);
+		goodix_append_checksum(&(flash_cmd.buf[2]),
+				9, CHECKSUM_MODE_U8_LE);
+
+		r = goodix_send_flash_cmd(&flash_cmd);
+		if (!r)
+			r = goodix_reg_read(isp_buffer_reg, buf, data_size);
+		if (r) {
+			ts_err("failed read flash at %08x, size:%u, %d",
+				subsys->flash_addr + offset, data_size, r);
+			break;
+		}
+		*crc = crc32_le(*crc, buf, data_size);
+	}
+
+	kfree(buf);
+	return r;
+}
+
+/**
+ * goodix_flash_subsystem_diff - flash subsystem firmware unless the
+ *  device already holds the same data
+ * @fw_ctrl: pointer to firmware control structure
+ * @subsys: subsystem information
+ * @record: flash record slot of this subsystem
+ *
+ * A record of this update with a different crc means the area must be
+ * written. Otherwise the area is read back and only skipped when its
+ * crc matches, so a record is never trusted on its own and the first
+ * diff update after boot can skip areas without any record.
+ * return: 0 ok, < 0 error
+ */
+static int goodix_flash_subsystem_diff(struct fw_update_ctrl *fw_ctrl,
+		struct fw_subsys_info *subsys, struct fw_flash_record *record)
+{
+	struct fw_flash_record *old;
+	u32 crc, flash_crc;
+	int r;
+
+	crc = crc32_le(~0, subsys->data, subsys->size);
+	old = goodix_find_flash_record(fw_ctrl, subsys->flash_addr);
+	if (old && (old->type != subsys->type ||
+		old->size != subsys->size || old->crc != crc))
+		goto flash;
+
+	if ((old || fw_ctrl->mode & UPDATE_MODE_DIFF) &&
+		!goodix_read_flash_crc(subsys, &flash_crc) && flash_crc == crc) {
+		ts_info("subsystem at %08x unchanged, skip",
+			subsys->flash_addr);
+		fw_ctrl->skipped_num++;
+		goto out;
+	}
+
+flash:
+	/* the area is about to be overwritten */
+	goodix_clear_flash_record(fw_ctrl, subsys->flash_addr, subsys->size);
+	record->valid = false;
+
+	r = goodix_flash_subsystem(subsys);
+	if (r)
+		return r;
+	fw_ctrl->flashed_num++;
+
+out:
+	record->type = subsys->type;
+	record->size = subsys->size;
+	record->flash_addr = subsys->flash_addr;
+	record->crc = crc;
+	record->valid = true;
+	return 0;
+}
+
 /**
  * goodix_flash_firmware - flash firmware
  * @dev: pointer to touch device
@@ -874,6 +1032,8 @@ static int goodix_flash_firmware(struct fw_update_ctrl *fw_ctrl)
 
 	fw_summary = &fw_data->fw_summary;
 	fw_num = fw_summary->subsys_num;
+	fw_ctrl->flashed_num = 0;
+	fw_ctrl->skipped_num = 0;
 
 	/* flash config data first if we have */
 	if (fw_ctrl->ic_config && fw_ctrl->ic_config->len) {
@@ -881,7 +1041,8 @@ static int goodix_flash_firmware(struct fw_update_ctrl *fw_ctrl)
 		subsys_cfg.size = fw_ctrl->ic_config->len;
 		subsys_cfg.flash_addr = config_data_reg;
 		subsys_cfg.type = CONFIG_DATA_TYPE;
-		r = goodix_flash_subsystem(&subsys_cfg);
+		r = goodix_flash_subsystem_diff(fw_ctrl, &subsys_cfg,
+				&fw_ctrl->flash_record[FW_SUBSYS_MAX_NUM]);
 		if (r) {
 			ts_err("failed flash config with ISP, %d", r);
 			return r;
@@ -892,7 +1053,8 @@ static int goodix_flash_firmware(struct fw_update_ctrl *fw_ctrl)
 	for (i = 1; i < fw_num && retry;) {
 		ts_info("--- Start to flash subsystem[%d] ---", i);
 		fw_x = &fw_summary->subsys[i];
-		r = goodix_flash_subsystem(fw_x);
+		r = goodix_flash_subsystem_diff(fw_ctrl, fw_x,
+				&fw_ctrl->flash_record[i]);
 		if (r == 0) {
 			ts_info("--- End flash subsystem[%d]: OK ---", i);
 			i++;
@@ -908,6 +1070,8 @@ static int goodix_flash_firmware(struct fw_update_ctrl *fw_ctrl)
 	}
 
 exit_flash:
+	ts_info("flashed %d subsystems, skipped %d",
+		fw_ctrl->flashed_num, fw_ctrl->skipped_num);
 	return r;
 }
 
@@ -947,6 +1111,14 @@ int goodix_fw_update_proc(struct fw_update_ctrl *fwu_ctrl)
 	if (ret < 0)
 		return ret;
 
+	/*
+	 * Without UPDATE_MODE_DIFF only trust the records written by this
+	 * update, so a retry below resumes at the first unflashed subsystem.
+	 */
+	if (!(fwu_ctrl->mode & UPDATE_MODE_DIFF))
+		memset(fwu_ctrl->flash_record, 0,
+			sizeof(fwu_ctrl->flash_record));
+
 	if (!(fwu_ctrl->mode & UPDATE_MODE_FORCE)) {
 		ret = goodix_fw_version_compare(fwu_ctrl);
 		ts_info("need to upgrade");
@@ -989,6 +1161,21 @@ err_fw_prepare:
 	return ret;
 }
 
+/*
+ * goodix_fw_update_forget_flash: drop the diff update flash records
+ *  after the flash was written outside of this module (e.g. by tools)
+ */
+void goodix_fw_update_forget_flash(void)
+{
+	if (!goodix_fw_update_ctrl.initialized)
+		return;
+
+	mutex_lock(&goodix_fw_update_ctrl.mutex);
+	memset(goodix_fw_update_ctrl.flash_record, 0,
+		sizeof(goodix_fw_update_ctrl.flash_record));
+	mutex_unlock(&goodix_fw_update_ctrl.mutex);
+}
+
 /*
  * goodix_sysfs_update_en_store: start fw update manually
  * @buf: '1'[001] update in blocking mode with fwdata from sysfs
@@ -1029,6 +1216,9 @@ static ssize_t goodix_sysfs_update_en_store(
 		return -EINVAL;
 	}
 
+	if (fw_ctrl->diff_update)
+		mode |= UPDATE_MODE_DIFF;
+
 	ret = goodix_do_fw_update(NULL, mode);
 	if (!ret) {
 		ts_info("success do update work");
@@ -1101,14 +1291,51 @@ static ssize_t goodix_sysfs_result_show(
 	return r;
 }
 
+/* skip the subsystems unchanged since they were flashed */
+static ssize_t goodix_sysfs_diff_update_show(
+		struct kobject *kobj, struct kobj_attribute *attr,
+		char *buf)
+{
+	struct fw_update_ctrl *fw_ctrl = &goodix_fw_update_ctrl;
+
+	return snprintf(buf, PAGE_SIZE, "diff_update:%d flashed:%d skipped:%d\n",
+			fw_ctrl->diff_update, fw_ctrl->flashed_num,
+			fw_ctrl->skipped_num);
+}
+
+static ssize_t goodix_sysfs_diff_update_store(
+		struct kobject *kobj, struct kobj_attribute *attr,
+		const char *buf, size_t count)
+{
+	struct fw_update_ctrl *fw_ctrl = &goodix_fw_update_ctrl;
+	bool enable;
+
+	if (kstrtobool(buf, &enable))
+		return -EINVAL;
+
+	mutex_lock(&fw_ctrl->mutex);
+	fw_ctrl->diff_update = enable;
+	if (!enable)
+		memset(fw_ctrl->flash_record, 0,
+			sizeof(fw_ctrl->flash_record));
+	mutex_unlock(&fw_ctrl->mutex);
+	ts_info("set diff update %d", enable);
+
+	return count;
+}
+
 static struct kobj_attribute goodix_sysfs_update =
 	__ATTR(update_en, 0220, NULL, goodix_sysfs_update_en_store);
 static struct kobj_attribute goodix_sysfs_result =
 	__ATTR(result, 0664, goodix_sysfs_result_show, NULL);
+static struct kobj_attribute goodix_sysfs_diff_update =
+	__ATTR(diff_update, 0664, goodix_sysfs_diff_update_show,
+		goodix_sysfs_diff_update_store);
 
 static struct attribute *goodix_fwu_attrs[] = {
 	&goodix_sysfs_update.attr,
-	&goodix_sysfs_result.attr
+	&goodix_sysfs_result.attr,
+	&goodix_sysfs_diff_update.attr
 };
 
 static int goodix_fw_sysfs_init(struct goodix_ts_core *core_data,
@@ -1125,13 +1125,13 @@ static int goodix_touch_handler(struct goodix_ts_core *cd,
 	struct goodix_ic_info_misc *misc = &cd->ic_info.misc;
 	struct goodix_touch_data *touch_data = &ts_event->touch_data;
 	struct goodix_pen_data *pen_data = &ts_event->pen_data;
-	static u8 buffer[IRQ_EVENT_HEAD_LEN +
-			 BYTES_PER_POINT * GOODIX_MAX_TOUCH + 2];
+	u8 *buffer = cd->touch_event_buf;
 	u8 touch_num = 0;
 	int ret = 0;
 	u8 point_type = 0;
-	static u8 pre_finger_num;
-	static u8 pre_pen_num;
+
+	BUILD_BUG_ON(sizeof(cd->touch_event_buf) < IRQ_EVENT_HEAD_LEN +
+			BYTES_PER_POINT * GOODIX_MAX_TOUCH + 2);
 
 	/* clean event buffer */
 	memset(ts_event, 0, sizeof(*ts_event));
@@ -1189,25 +1189,25 @@ static int goodix_touch_handler(struct goodix_ts_core *cd,
 	if (touch_num > 0 && (point_type == POINT_TYPE_STYLUS
 				|| point_type == POINT_TYPE_STYLUS_HOVER)) {
 		/* stylus info */
-		if (pre_finger_num) {
+		if (cd->pre_finger_num) {
 			ts_event->event_type = EVENT_TOUCH;
 			goodix_parse_finger(touch_data, buffer, 0);
-			pre_finger_num = 0;
+			cd->pre_finger_num = 0;
 		} else {
-			pre_pen_num = 1;
+			cd->pre_pen_num = 1;
 			ts_event->event_type = EVENT_PEN;
 			goodix_parse_pen(pen_data, buffer, touch_num);
 		}
 	} else {
 		/* finger info */
-		if (pre_pen_num) {
+		if (cd->pre_pen_num) {
 			ts_event->event_type = EVENT_PEN;
 			goodix_parse_pen(pen_data, buffer, 0);
-			pre_pen_num = 0;
+			cd->pre_pen_num = 0;
 		} else {
 			ts_event->event_type = EVENT_TOUCH;
 			goodix_parse_finger(touch_data, buffer, touch_num);
-			pre_finger_num = touch_num;
+			cd->pre_finger_num = touch_num;
 		}
 	}
 
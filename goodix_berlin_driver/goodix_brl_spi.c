@@ -32,9 +32,69 @@
 #define SPI_WRITE_FLAG  0xF0
 #define SPI_READ_FLAG   0xF1
 
+#define SPI_XFER_BUF_DEFAULT_SIZE	(GOODIX_MAX_FRAMEDATA_LEN + 64)
+
 static struct platform_device *goodix_pdev;
 struct goodix_bus_interface goodix_spi_bus[MAX_SUPPORTED_TOUCH_PANELS];
 
+/*
+ * per-device transfer buffers, allocated once at probe time and only
+ * reallocated when a transfer larger than the current size is requested,
+ * so the normal event read path does no allocation at all.
+ *
+ * Reads clock out rd_tx_buf, of which only the command, address and
+ * dummy bytes are ever written, so the rest stays zero as it was with a
+ * freshly kzalloc'd buffer. Writes fill tx_buf and never leak into it.
+ */
+struct goodix_spi_xfer {
+	struct mutex lock;
+	u8 *tx_buf;
+	u8 *rd_tx_buf;
+	u8 *rx_buf;
+	unsigned int size;
+};
+
+static void goodix_spi_free_xfer_buf(struct goodix_spi_xfer *xfer)
+{
+	kfree(xfer->tx_buf);
+	kfree(xfer->rd_tx_buf);
+	kfree(xfer->rx_buf);
+	xfer->tx_buf = NULL;
+	xfer->rd_tx_buf = NULL;
+	xfer->rx_buf = NULL;
+	xfer->size = 0;
+}
+
+/**
+ * goodix_spi_get_xfer_buf - make sure the transfer buffers can hold len bytes
+ * @xfer: per-device transfer buffers, lock must be held
+ * @len: total bytes of the transfer, including prefix
+ * return: 0 - ok, -ENOMEM - failed to grow the buffers
+ */
+static int goodix_spi_get_xfer_buf(struct goodix_spi_xfer *xfer,
+		unsigned int len)
+{
+	unsigned int size;
+
+	if (likely(len <= xfer->size))
+		return 0;
+
+	/* kmalloc memory is DMA safe, keep size cacheline aligned */
+	size = ALIGN(max_t(unsigned int, len, SPI_XFER_BUF_DEFAULT_SIZE),
+			L1_CACHE_BYTES);
+	goodix_spi_free_xfer_buf(xfer);
+	xfer->tx_buf = kzalloc(size, GFP_KERNEL);
+	xfer->rd_tx_buf = kzalloc(size, GFP_KERNEL);
+	xfer->rx_buf = kzalloc(size, GFP_KERNEL);
+	if (!xfer->tx_buf || !xfer->rd_tx_buf || !xfer->rx_buf) {
+		ts_err("alloc tx/rx_buf failed, size:%u", size);
+		goodix_spi_free_xfer_buf(xfer);
+		return -ENOMEM;
+	}
+	xfer->size = size;
+	return 0;
+}
+
 /**
  * goodix_spi_read_bra- read device register through spi bus
  * @dev: pointer to device data
@@ -47,19 +107,19 @@ static int goodix_spi_read_bra(struct device *dev, unsigned int addr,
 	unsigned char *data, unsigned int len)
 {
 	struct spi_device *spi = to_spi_device(dev);
+	struct goodix_spi_xfer *xfer = spi_get_drvdata(spi);
 	u8 *rx_buf = NULL;
 	u8 *tx_buf = NULL;
 	struct spi_transfer xfers;
 	struct spi_message spi_msg;
 	int ret = 0;
 
-	rx_buf = kzalloc(SPI_READ_PREFIX_LEN + len, GFP_KERNEL);
-	tx_buf = kzalloc(SPI_READ_PREFIX_LEN + len, GFP_KERNEL);
-	if (!rx_buf || !tx_buf) {
-		ts_err("alloc tx/rx_buf failed, size:%d",
-			SPI_READ_PREFIX_LEN + len);
-		return -ENOMEM;
-	}
+	mutex_lock(&xfer->lock);
+	ret = goodix_spi_get_xfer_buf(xfer, SPI_READ_PREFIX_LEN + len);
+	if (ret < 0)
+		goto exit;
+	rx_buf = xfer->rx_buf;
+	tx_buf = xfer->rd_tx_buf;
 
 	spi_message_init(&spi_msg);
 	memset(&xfers, 0, sizeof(xfers));
@@ -88,8 +148,7 @@ static int goodix_spi_read_bra(struct device *dev, unsigned int addr,
 	memcpy(data, &rx_buf[SPI_READ_PREFIX_LEN], len);
 
 exit:
-	kfree(rx_buf);
-	kfree(tx_buf);
+	mutex_unlock(&xfer->lock);
 	return ret;
 }
 
@@ -97,19 +156,19 @@ static int goodix_spi_read(struct device *dev, unsigned int addr,
 	unsigned char *data, unsigned int len)
 {
 	struct spi_device *spi = to_spi_device(dev);
+	struct goodix_spi_xfer *xfer = spi_get_drvdata(spi);
 	u8 *rx_buf = NULL;
 	u8 *tx_buf = NULL;
 	struct spi_transfer xfers;
 	struct spi_message spi_msg;
 	int ret = 0;
 
-	rx_buf = kzalloc(SPI_READ_PREFIX_LEN - 1 + len, GFP_KERNEL);
-	tx_buf = kzalloc(SPI_READ_PREFIX_LEN - 1 + len, GFP_KERNEL);
-	if (!rx_buf || !tx_buf) {
-		ts_err("alloc tx/rx_buf failed, size:%d",
-			SPI_READ_PREFIX_LEN - 1 + len);
-		return -ENOMEM;
-	}
+	mutex_lock(&xfer->lock);
+	ret = goodix_spi_get_xfer_buf(xfer, SPI_READ_PREFIX_LEN - 1 + len);
+	if (ret < 0)
+		goto exit;
+	rx_buf = xfer->rx_buf;
+	tx_buf = xfer->rd_tx_buf;
 
 	spi_message_init(&spi_msg);
 	memset(&xfers, 0, sizeof(xfers));
@@ -137,8 +196,7 @@ static int goodix_spi_read(struct device *dev, unsigned int addr,
 	memcpy(data, &rx_buf[SPI_READ_PREFIX_LEN - 1], len);
 
 exit:
-	kfree(rx_buf);
-	kfree(tx_buf);
+	mutex_unlock(&xfer->lock);
 	return ret;
 }
 
@@ -154,14 +212,17 @@ static int goodix_spi_write(struct device *dev, unsigned int addr,
 		unsigned char *data, unsigned int len)
 {
 	struct spi_device *spi = to_spi_device(dev);
+	struct goodix_spi_xfer *xfer = spi_get_drvdata(spi);
 	u8 *tx_buf = NULL;
 	struct spi_transfer xfers;
 	struct spi_message spi_msg;
 	int ret = 0;
 
-	tx_buf = kzalloc(SPI_WRITE_PREFIX_LEN + len, GFP_KERNEL);
-	if (!tx_buf)
-		return -ENOMEM;
+	mutex_lock(&xfer->lock);
+	ret = goodix_spi_get_xfer_buf(xfer, SPI_WRITE_PREFIX_LEN + len);
+	if (ret < 0)
+		goto exit;
+	tx_buf = xfer->tx_buf;
 
 	spi_message_init(&spi_msg);
 	memset(&xfers, 0, sizeof(xfers));
@@ -180,7 +241,8 @@ static int goodix_spi_write(struct device *dev, unsigned int addr,
 	if (ret < 0)
 		ts_err("spi transfer error:%d", ret);
 
-	kfree(tx_buf);
+exit:
+	mutex_unlock(&xfer->lock);
 	return ret;
 }
 
@@ -192,7 +254,8 @@ static void goodix_pdev_release(struct device *dev)
 
 static int goodix_spi_probe(struct spi_device *spi)
 {
-	int ret = 0, idx;
+	struct goodix_spi_xfer *xfer;
+	int ret = 0, idx, ic_type;
 
 	ts_info("goodix spi probe in");
 
@@ -207,9 +270,9 @@ static int goodix_spi_probe(struct spi_device *spi)
 	}
 
 	/* get ic type */
-	ret = goodix_get_ic_type(spi->dev.of_node);
-	if (ret < 0)
-		return ret;
+	ic_type = goodix_get_ic_type(spi->dev.of_node);
+	if (ic_type < 0)
+		return ic_type;
 
 	idx = goodix_get_touch_type(spi->dev.of_node);
 	if (idx < 0 || idx >= MAX_SUPPORTED_TOUCH_PANELS) {
@@ -217,7 +280,16 @@ static int goodix_spi_probe(struct spi_device *spi)
 		return -ENODEV;
 	}
 
-	goodix_spi_bus[idx].ic_type = ret;
+	xfer = devm_kzalloc(&spi->dev, sizeof(*xfer), GFP_KERNEL);
+	if (!xfer)
+		return -ENOMEM;
+	mutex_init(&xfer->lock);
+	ret = goodix_spi_get_xfer_buf(xfer, SPI_XFER_BUF_DEFAULT_SIZE);
+	if (ret < 0)
+		return ret;
+	spi_set_drvdata(spi, xfer);
+
+	goodix_spi_bus[idx].ic_type = ic_type;
 	goodix_spi_bus[idx].bus_type = GOODIX_BUS_TYPE_SPI;
 	goodix_spi_bus[idx].dev = &spi->dev;
 	if (goodix_spi_bus[idx].ic_type == IC_TYPE_BERLIN_A)
@@ -227,8 +299,10 @@ static int goodix_spi_probe(struct spi_device *spi)
 	goodix_spi_bus[idx].write = goodix_spi_write;
 	/* ts core device */
 	goodix_pdev = kzalloc(sizeof(struct platform_device), GFP_KERNEL);
-	if (!goodix_pdev)
-		return -ENOMEM;
+	if (!goodix_pdev) {
+		ret = -ENOMEM;
+		goto err_free_buf;
+	}
 
 	if (idx)
 		goodix_pdev->name = GOODIX_CORE_DEVICE_2_NAME;
@@ -260,6 +334,8 @@ static int goodix_spi_probe(struct spi_device *spi)
 err_pdev:
 	kfree(goodix_pdev);
 	goodix_pdev = NULL;
+err_free_buf:
+	goodix_spi_free_xfer_buf(xfer);
 	ts_info("spi probe out, %d", ret);
 	return ret;
 }
@@ -268,11 +344,13 @@ err_pdev:
 	static void goodix_spi_remove(struct spi_device *spi)
 	{
 	platform_device_unregister(goodix_pdev);
+	goodix_spi_free_xfer_buf(spi_get_drvdata(spi));
 	}
 #else
 	static int goodix_spi_remove(struct spi_device *spi)
 	{
 	platform_device_unregister(goodix_pdev);
+	goodix_spi_free_xfer_buf(spi_get_drvdata(spi));
 	return 0;
 	}
 #endif
@@ -315,3 +393,7 @@ void goodix_spi_bus_exit(void)
 	ts_info("Goodix spi driver exit");
 	spi_unregister_driver(&goodix_spi_driver);
 }
+
+#if IS_ENABLED(CONFIG_TOUCHSCREEN_KUNIT_TEST)
+#include "../touch_kunit/tests/goodix_brl_spi_test.c"
+#endif
@@ -20,6 +20,8 @@
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
 #include <linux/uaccess.h>
+#include <linux/rculist.h>
+#include <linux/srcu.h>
 #include <linux/soc/qcom/panel_event_notifier.h>
 
 #if LINUX_VERSION_CODE > KERNEL_VERSION(2, 6, 38)
@@ -60,6 +62,11 @@ static void goodix_register_for_panel_events(struct device_node *dp,
 #endif
 
 struct goodix_module goodix_modules;
+/*
+ * protects the module list walk in the irq thread, irq_event callbacks
+ * may sleep so plain RCU can't be used. Writers still take the mutex.
+ */
+DEFINE_STATIC_SRCU(goodix_modules_srcu);
 int core_module_prob_sate = CORE_MODULE_UNPROBED;
 struct mutex goodix_later_init_tmutex;
 
@@ -105,17 +112,21 @@ static int __do_register_ext_module(struct goodix_ext_module *module)
 		}
 	}
 
+	if (!module->core_data)
+		module->core_data = goodix_modules.core_data;
+
 	if (module->funcs && module->funcs->init) {
-		if (module->funcs->init(goodix_modules.core_data,
+		if (module->funcs->init(module->core_data,
 					module) < 0) {
 			ts_err("Module [%s] init error",
 				module->name ? module->name : " ");
+			module->core_data = NULL;
 			mutex_unlock(&goodix_modules.mutex);
 			return -EFAULT;
 		}
 	}
 
-	list_add(&module->list, insert_point->prev);
+	list_add_rcu(&module->list, insert_point->prev);
 	mutex_unlock(&goodix_modules.mutex);
 
 	ts_info("Module [%s] registered,priority:%u", module->name,
@@ -236,11 +247,14 @@ int goodix_unregister_ext_module(struct goodix_ext_module *module)
 		return 0;
 	}
 
-	list_del(&module->list);
+	list_del_rcu(&module->list);
 	mutex_unlock(&goodix_modules.mutex);
+	/* wait for the irq thread to leave the module */
+	synchronize_srcu(&goodix_modules_srcu);
 
 	if (module->funcs && module->funcs->exit)
-		module->funcs->exit(goodix_modules.core_data, module);
+		module->funcs->exit(module->core_data, module);
+	module->core_data = NULL;
 
 	ts_info("Moudle [%s] unregistered",
 		module->name ? module->name : " ");
@@ -1250,26 +1264,33 @@ static irqreturn_t goodix_ts_threadirq_func(int irq, void *data)
 {
 	struct goodix_ts_core *core_data = data;
 	struct goodix_ts_hw_ops *hw_ops = core_data->hw_ops;
-	struct goodix_ext_module *ext_module, *next;
+	struct goodix_ext_module *ext_module;
 	struct goodix_ts_event *ts_event = &core_data->ts_event;
 	struct goodix_ts_esd *ts_esd = &core_data->ts_esd;
 	int ret;
+	int idx;
 
 	ts_esd->irq_status = true;
 	core_data->irq_trig_cnt++;
-	/* inform external module */
-	mutex_lock(&goodix_modules.mutex);
-	list_for_each_entry_safe(ext_module, next,
-				 &goodix_modules.head, list) {
-		if (!ext_module->funcs->irq_event)
+	/* inform the external modules bound to this core */
+	if (list_empty(&goodix_modules.head))
+		goto read_event;
+
+	idx = srcu_read_lock(&goodix_modules_srcu);
+	list_for_each_entry_srcu(ext_module, &goodix_modules.head, list,
+				 srcu_read_lock_held(&goodix_modules_srcu)) {
+		if (ext_module->core_data != core_data ||
+				!ext_module->funcs->irq_event)
 			continue;
 		ret = ext_module->funcs->irq_event(core_data, ext_module);
 		if (ret == EVT_CANCEL_IRQEVT) {
-			mutex_unlock(&goodix_modules.mutex);
+			srcu_read_unlock(&goodix_modules_srcu, idx);
 			return IRQ_HANDLED;
 		}
 	}
-	mutex_unlock(&goodix_modules.mutex);
+	srcu_read_unlock(&goodix_modules_srcu, idx);
+
+read_event:
 
 	/* read touch data from touch device */
 	ret = hw_ops->event_handler(core_data, ts_event);
@@ -1761,6 +1782,11 @@ static int goodix_ts_suspend(struct goodix_ts_core *core_data)
 	atomic_set(&core_data->suspended, 1);
 	/* disable irq */
 	hw_ops->irq_enable(core_data, false);
+	/*
+	 * the irq thread walks the modules under SRCU only, wait for it so
+	 * no irq_event runs along with the suspend callbacks below
+	 */
+	synchronize_irq(core_data->irq);
 
 	/*
 	 * notify suspend event, inform the esd protector
@@ -1773,7 +1799,8 @@ static int goodix_ts_suspend(struct goodix_ts_core *core_data)
 	if (!list_empty(&goodix_modules.head)) {
 		list_for_each_entry_safe(ext_module, next,
 					 &goodix_modules.head, list) {
-			if (!ext_module->funcs->before_suspend)
+			if (ext_module->core_data != core_data ||
+					!ext_module->funcs->before_suspend)
 				continue;
 
 			ret = ext_module->funcs->before_suspend(core_data, ext_module);
@@ -1796,7 +1823,8 @@ static int goodix_ts_suspend(struct goodix_ts_core *core_data)
 	if (!list_empty(&goodix_modules.head)) {
 		list_for_each_entry_safe(ext_module, next,
 					&goodix_modules.head, list) {
-			if (!ext_module->funcs->after_suspend)
+			if (ext_module->core_data != core_data ||
+					!ext_module->funcs->after_suspend)
 				continue;
 
 			ret = ext_module->funcs->after_suspend(core_data, ext_module);
@@ -1833,12 +1861,15 @@ static int goodix_ts_resume(struct goodix_ts_core *core_data)
 	ts_info("Resume start");
 	atomic_set(&core_data->suspended, 0);
 	hw_ops->irq_enable(core_data, false);
+	/* the gesture irq may still be running, see goodix_ts_suspend */
+	synchronize_irq(core_data->irq);
 
 	mutex_lock(&goodix_modules.mutex);
 	if (!list_empty(&goodix_modules.head)) {
 		list_for_each_entry_safe(ext_module, next,
 					&goodix_modules.head, list) {
-			if (!ext_module->funcs->before_resume)
+			if (ext_module->core_data != core_data ||
+					!ext_module->funcs->before_resume)
 				continue;
 
 			ret = ext_module->funcs->before_resume(core_data, ext_module);
@@ -1859,7 +1890,8 @@ static int goodix_ts_resume(struct goodix_ts_core *core_data)
 	if (!list_empty(&goodix_modules.head)) {
 		list_for_each_entry_safe(ext_module, next,
 					&goodix_modules.head, list) {
-			if (!ext_module->funcs->after_resume)
+			if (ext_module->core_data != core_data ||
+					!ext_module->funcs->after_resume)
 				continue;
 
 			ret = ext_module->funcs->after_resume(core_data, ext_module);
@@ -2589,7 +2621,9 @@ skip_to_power_gpio_setup:
 		goodix_tools_init();
 
 	core_data->init_stage = CORE_INIT_STAGE1;
-	goodix_modules.core_data = core_data;
+	/* external modules are bound to the primary touch core by default */
+	if (is_primary || !goodix_modules.core_data)
+		goodix_modules.core_data = core_data;
 	core_module_prob_sate = CORE_MODULE_PROB_SUCCESS;
 	core_data->ready = true;
 
@@ -2708,3 +2742,7 @@ module_exit(goodix_ts_core_exit);
 MODULE_DESCRIPTION("Goodix Touchscreen Core Module");
 MODULE_AUTHOR("Goodix, Inc.");
 MODULE_LICENSE("GPL v2");
+
+#if IS_ENABLED(CONFIG_TOUCHSCREEN_KUNIT_TEST)
+#include "../touch_kunit/tests/goodix_ts_core_test.c"
+#endif
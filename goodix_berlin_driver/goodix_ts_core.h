@@ -57,6 +57,7 @@
 #define GOODIX_MAX_STR_LABLE_LEN		32
 #define GOODIX_MAX_FRAMEDATA_LEN		1700
 #define GOODIX_GESTURE_DATA_LEN			16
+#define GOODIX_MAX_TOUCH_EVENT_LEN		(8 + 8 * GOODIX_MAX_TOUCH + 2)
 
 #define GOODIX_NORMAL_RESET_DELAY_MS	100
 #define GOODIX_HOLD_CPU_RESET_DELAY_MS  5
@@ -262,7 +263,7 @@ struct ts_rawdata_info {
  * @initilized: whether this struct is initilized
  * @mutex: mutex lock
  * @wq: workqueue to do register work
- * @core_data: core_data pointer
+ * @core_data: primary touch core, modules are bound to it by default
  */
 struct goodix_module {
 	struct list_head head;
@@ -311,6 +312,7 @@ enum goodix_fw_update_mode {
 	UPDATE_MODE_FORCE = (1 << 0), /* force update mode */
 	UPDATE_MODE_BLOCK = (1 << 1), /* update in block mode */
 	UPDATE_MODE_FLASH_CFG = (1 << 2), /* reflash config */
+	UPDATE_MODE_DIFF = (1 << 3), /* skip subsystems unchanged on flash */
 	UPDATE_MODE_SRC_SYSFS = (1 << 4), /* firmware file from sysfs */
 	UPDATE_MODE_SRC_HEAD = (1 << 5), /* firmware file from head file */
 	UPDATE_MODE_SRC_REQUEST = (1 << 6), /* request firmware */
@@ -494,6 +496,10 @@ struct goodix_ts_core {
 	struct input_dev *pen_dev;
 	/* TODO counld we remove this from core data? */
 	struct goodix_ts_event ts_event;
+	/* touch data of current frame and type of previous frame */
+	u8 touch_event_buf[GOODIX_MAX_TOUCH_EVENT_LEN];
+	u8 pre_finger_num;
+	u8 pre_pen_num;
 
 	/* every pointer of this array represent a kind of config */
 	struct goodix_ic_config *ic_configs[GOODIX_MAX_CONFIG_GROUP];
@@ -590,6 +596,8 @@ struct goodix_ext_module_funcs {
  * @priv_data: private data region
  * @kobj: kobject
  * @work: used to queue one work to do registration
+ * @core_data: touch core the module is bound to, the primary core
+ *	unless set before registration
  */
 struct goodix_ext_module {
 	struct list_head list;
@@ -599,6 +607,7 @@ struct goodix_ext_module {
 	void *priv_data;
 	struct kobject kobj;
 	struct work_struct work;
+	struct goodix_ts_core *core_data;
 };
 
 /*
@@ -688,6 +697,7 @@ void goodix_rotate_abcd2cbad(int tx, int rx, s16 *data);
 
 int goodix_fw_update_init(struct goodix_ts_core *core_data);
 void goodix_fw_update_uninit(void);
+void goodix_fw_update_forget_flash(void);
 int goodix_do_fw_update(struct goodix_ic_config *ic_config, int mode);
 
 int goodix_get_ic_type(struct device_node *node);
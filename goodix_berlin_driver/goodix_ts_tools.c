@@ -351,6 +351,8 @@ static long goodix_tools_ioctl(struct file *filp, unsigned int cmd,
 		ret = async_write(dev, (void __user *)arg);
 		if (ret < 0)
 			ts_err("Async data write failed");
+		/* tools flash through raw writes, diff records are stale */
+		goodix_fw_update_forget_flash();
 		break;
 	case GTP_TOOLS_VER:
 		ret = copy_to_user((u8 *)arg, &goodix_tools_ver, sizeof(u16));
@@ -612,8 +612,11 @@ void nvt_extra_proc_deinit(void)
 #define NVT_SPI_HANDSHAKING_HOST_READY 0xBB
 
 #define NVT_SPI_XDATA_SECTOR_SIZE 256
+/* largest whole sectors one nvt_spi_read() can return through rbuf */
+#define NVT_SPI_XDATA_READ_LEN (NVT_SPI_READ_LEN - NVT_SPI_XDATA_SECTOR_SIZE)
 
-static uint8_t nvt_spi_xdata_tmp[5000] = {0};
+/* byte 0 is room for the address byte of the first read */
+static uint8_t nvt_spi_xdata_tmp[5000 + 1] = {0};
 static int32_t nvt_spi_xdata[2500] = {0};
 static int32_t nvt_spi_xdata_pen_tip_x[256] = {0};
 static int32_t nvt_spi_xdata_pen_tip_y[256] = {0};
@@ -761,88 +764,91 @@ uint8_t nvt_spi_get_fw_pipe(void)
 /*
  *******************************************************
  * Description:
- *	Novatek touchscreen read meta data function.
+ *	Novatek touchscreen read xdata function. Reads num
+ *	16-bit values from xdata_addr in NVT_SPI_XDATA_READ_LEN
+ *	transfers straight into nvt_spi_xdata_tmp, then widens
+ *	them into buffer.
  *
  * return:
- *	n.a.
- ******************************************************
+ *	Executive outcomes. 0---succeed. negative---fail.
+ *******************************************************
  */
-static void nvt_spi_read_mdata(uint32_t xdata_addr, uint32_t xdata_btn_addr)
+static int32_t nvt_spi_read_xdata(uint32_t xdata_addr, int32_t *buffer, int32_t num)
 {
 	int32_t i = 0;
-	int32_t j = 0;
-	int32_t k = 0;
-	uint8_t buf[NVT_SPI_BUS_TRANSFER_LENGTH + 2] = {0};
 	uint32_t head_addr = 0;
 	int32_t dummy_len = 0;
-	int32_t data_len = 0;
-	int32_t residual_len = 0;
-	int32_t index, data;
-	struct nvt_spi_data_t *ts = nvt_spi_data;
+	int32_t total_len = 0;
+	int32_t offset = 0;
+	int32_t len = 0;
+	int32_t ret = 0;
+	uint8_t *data = NULL;
+	uint8_t saved;
 
 	//---set xdata sector address & length---
 	head_addr = xdata_addr - (xdata_addr % NVT_SPI_XDATA_SECTOR_SIZE);
 	dummy_len = xdata_addr - head_addr;
-	data_len = ts->x_num * ts->y_num * 2;
-	residual_len = (head_addr + dummy_len + data_len) % NVT_SPI_XDATA_SECTOR_SIZE;
+	total_len = dummy_len + num * 2;
+	if (total_len > (int32_t)sizeof(nvt_spi_xdata_tmp) - 1) {
+		NVT_ERR("xdata length %d exceeds buffer\n", total_len);
+		return -EINVAL;
+	}
 
-	//printk("head_addr=0x%05X, dummy_len=0x%05X, data_len=0x%05X, residual_len=0x%05X\n",
-	//		head_addr, dummy_len, data_len, residual_len);
+	for (offset = 0; offset < total_len; offset += len) {
+		len = min(total_len - offset, NVT_SPI_XDATA_READ_LEN);
 
-	//read xdata : step 1
-	for (i = 0; i < ((dummy_len + data_len) / NVT_SPI_XDATA_SECTOR_SIZE); i++) {
-		//---change xdata index---
-		nvt_spi_set_page(head_addr + NVT_SPI_XDATA_SECTOR_SIZE * i);
+		//---change xdata index, each transfer starts a new sector---
+		ret = nvt_spi_set_page(head_addr + offset);
+		if (ret)
+			break;
 
-		//---read xdata by NVT_SPI_BUS_TRANSFER_LENGTH
-		for (j = 0; j < (NVT_SPI_XDATA_SECTOR_SIZE / NVT_SPI_BUS_TRANSFER_LENGTH); j++) {
-			//---read data---
-			buf[0] = NVT_SPI_BUS_TRANSFER_LENGTH * j;
-			nvt_spi_read(buf, NVT_SPI_BUS_TRANSFER_LENGTH + 1);
-
-			//---copy buf to nvt_spi_xdata_tmp---
-			for (k = 0; k < NVT_SPI_BUS_TRANSFER_LENGTH; k++) {
-				index = NVT_SPI_XDATA_SECTOR_SIZE * i;
-				index += NVT_SPI_BUS_TRANSFER_LENGTH * j + k;
-				nvt_spi_xdata_tmp[index] = buf[k + 1];
-				//printk("0x%02X, 0x%04X\n", buf[k+1], index);
-			}
-		}
-		//printk("addr=0x%05X\n", (head_addr+NVT_SPI_XDATA_SECTOR_SIZE*i));
+		//---read data, the byte before the chunk carries the address---
+		data = &nvt_spi_xdata_tmp[offset];
+		saved = data[0];
+		data[0] = (head_addr + offset) & 0xFF;
+		ret = nvt_spi_read(data, len + 1);
+		data[0] = saved;
+		if (ret)
+			break;
+	}
+	if (ret) {
+		NVT_ERR("read xdata 0x%05X failed, ret = %d\n", head_addr + offset, ret);
+		return ret;
 	}
 
-	//read xdata : step2
-	if (residual_len != 0) {
-		//---change xdata index---
-		nvt_spi_set_page(xdata_addr + data_len - residual_len);
-
-		//---read xdata by NVT_SPI_BUS_TRANSFER_LENGTH
-		for (j = 0; j < (residual_len / NVT_SPI_BUS_TRANSFER_LENGTH + 1); j++) {
-			//---read data---
-			buf[0] = NVT_SPI_BUS_TRANSFER_LENGTH * j;
-			nvt_spi_read(buf, NVT_SPI_BUS_TRANSFER_LENGTH + 1);
+	//---remove dummy data and 2bytes-to-1data---
+	data = &nvt_spi_xdata_tmp[1 + dummy_len];
+	for (i = 0; i < num; i++, data += 2)
+		buffer[i] = (int16_t)(data[0] | (data[1] << 8));
 
-			//---copy buf to nvt_spi_xdata_tmp---
-			for (k = 0; k < NVT_SPI_BUS_TRANSFER_LENGTH; k++) {
-				index = (dummy_len + data_len - residual_len);
-				index += NVT_SPI_BUS_TRANSFER_LENGTH * j + k;
-				nvt_spi_xdata_tmp[index] = buf[k + 1];
-				//printk("0x%02X, 0x%04x\n", buf[k+1], index);
+	return 0;
+}
 
-			}
-		}
-		//printk("addr=0x%05X\n", (xdata_addr+data_len-residual_len));
-	}
+/*
+ *******************************************************
+ * Description:
+ *	Novatek touchscreen read meta data function.
+ *
+ * return:
+ *	Executive outcomes. 0---succeed. negative---fail.
+ ******************************************************
+ */
+static int32_t nvt_spi_read_mdata(uint32_t xdata_addr, uint32_t xdata_btn_addr)
+{
+	struct nvt_spi_data_t *ts = nvt_spi_data;
+	int32_t ret = 0;
+#if NVT_SPI_TOUCH_KEY_NUM > 0
+	int32_t i = 0;
+	uint8_t buf[NVT_SPI_TOUCH_KEY_NUM * 2 + 1] = {0};
+#endif
 
-	//---remove dummy data and 2bytes-to-1data---
-	for (i = 0; i < (data_len / 2); i++) {
-		data = nvt_spi_xdata_tmp[dummy_len + i * 2];
-		data += 256 * nvt_spi_xdata_tmp[dummy_len + i * 2 + 1];
-		nvt_spi_xdata[i] = (int16_t)data;
-	}
+	//read xdata : step 1
+	ret = nvt_spi_read_xdata(xdata_addr, nvt_spi_xdata, ts->x_num * ts->y_num);
+	if (ret)
+		goto out;
 
 #if NVT_SPI_TOUCH_KEY_NUM > 0
-	//read button xdata : step3
+	//read button xdata : step2
 	//---change xdata index---
 	nvt_spi_set_page(xdata_btn_addr);
 
@@ -856,8 +862,11 @@ static void nvt_spi_read_mdata(uint32_t xdata_addr, uint32_t xdata_btn_addr)
 				(int16_t)(buf[1 + i * 2] + 256 * buf[1 + i * 2 + 1]);
 #endif
 
+out:
 	//---set xdata index to EVENT BUF ADDR---
 	nvt_spi_set_page(ts->mmap->EVENT_BUF_ADDR);
+
+	return ret;
 }
 
 /*
@@ -885,84 +894,20 @@ void nvt_spi_get_mdata(int32_t *buf, uint8_t *m_x_num, uint8_t *m_y_num)
  *	Novatek touchscreen read and get number of meta data function.
  *
  * return:
- *	n.a.
+ *	Executive outcomes. 0---succeed. negative---fail.
  *******************************************************
  */
-void nvt_spi_read_get_num_mdata(uint32_t xdata_addr, int32_t *buffer, uint32_t num)
+int32_t nvt_spi_read_get_num_mdata(uint32_t xdata_addr, int32_t *buffer, uint32_t num)
 {
-	int32_t i = 0;
-	int32_t j = 0;
-	int32_t k = 0;
-	uint8_t buf[NVT_SPI_BUS_TRANSFER_LENGTH + 2] = {0};
-	uint32_t head_addr = 0;
-	int32_t dummy_len = 0;
-	int32_t data_len = 0;
-	int32_t residual_len = 0;
-	int32_t index, data;
 	struct nvt_spi_data_t *ts = nvt_spi_data;
+	int32_t ret = 0;
 
-	//---set xdata sector address & length---
-	head_addr = xdata_addr - (xdata_addr % NVT_SPI_XDATA_SECTOR_SIZE);
-	dummy_len = xdata_addr - head_addr;
-	data_len = num * 2;
-	residual_len = (head_addr + dummy_len + data_len) % NVT_SPI_XDATA_SECTOR_SIZE;
-
-	//printk("head_addr=0x%05X, dummy_len=0x%05X, data_len=0x%05X, residual_len=0x%05X\n",
-	//	head_addr, dummy_len, data_len, residual_len);
-
-	//read xdata : step 1
-	for (i = 0; i < ((dummy_len + data_len) / NVT_SPI_XDATA_SECTOR_SIZE); i++) {
-		//---change xdata index---
-		nvt_spi_set_page(head_addr + NVT_SPI_XDATA_SECTOR_SIZE * i);
-
-		//---read xdata by NVT_SPI_BUS_TRANSFER_LENGTH
-		for (j = 0; j < (NVT_SPI_XDATA_SECTOR_SIZE / NVT_SPI_BUS_TRANSFER_LENGTH); j++) {
-			//---read data---
-			buf[0] = NVT_SPI_BUS_TRANSFER_LENGTH * j;
-			nvt_spi_read(buf, NVT_SPI_BUS_TRANSFER_LENGTH + 1);
-
-			//---copy buf to nvt_spi_xdata_tmp---
-			for (k = 0; k < NVT_SPI_BUS_TRANSFER_LENGTH; k++) {
-				index = NVT_SPI_XDATA_SECTOR_SIZE * i;
-				index += NVT_SPI_BUS_TRANSFER_LENGTH * j + k;
-				nvt_spi_xdata_tmp[index] = buf[k + 1];
-			}
-		}
-		//printk("addr=0x%05X\n", (head_addr+NVT_SPI_XDATA_SECTOR_SIZE*i));
-	}
-
-	//read xdata : step2
-	if (residual_len != 0) {
-		//---change xdata index---
-		nvt_spi_set_page(xdata_addr + data_len - residual_len);
-
-		//---read xdata by NVT_SPI_BUS_TRANSFER_LENGTH
-		for (j = 0; j < (residual_len / NVT_SPI_BUS_TRANSFER_LENGTH + 1); j++) {
-			//---read data---
-			buf[0] = NVT_SPI_BUS_TRANSFER_LENGTH * j;
-			nvt_spi_read(buf, NVT_SPI_BUS_TRANSFER_LENGTH + 1);
-
-			//---copy buf to nvt_spi_xdata_tmp---
-			for (k = 0; k < NVT_SPI_BUS_TRANSFER_LENGTH; k++) {
-				index = (dummy_len + data_len - residual_len);
-				index += NVT_SPI_BUS_TRANSFER_LENGTH * j + k;
-				nvt_spi_xdata_tmp[index] = buf[k + 1];
-				//printk("0x%02X, 0x%04x\n", buf[k+1], index));
-
-			}
-		}
-		//printk("addr=0x%05X\n", (xdata_addr+data_len-residual_len));
-	}
-
-	//---remove dummy data and 2bytes-to-1data---
-	for (i = 0; i < (data_len / 2); i++) {
-		data = nvt_spi_xdata_tmp[dummy_len + i * 2];
-		data += 256 * nvt_spi_xdata_tmp[dummy_len + i * 2 + 1];
-		buffer[i] = (int16_t)data;
-	}
+	ret = nvt_spi_read_xdata(xdata_addr, buffer, num);
 
 	//---set xdata index to EVENT BUF ADDR---
 	nvt_spi_set_page(ts->mmap->EVENT_BUF_ADDR);
+
+	return ret;
 }
 
 /*
@@ -1207,7 +1152,11 @@ static int32_t nvt_spi_baseline_open(struct inode *inode, struct file *file)
 		return -EAGAIN;
 	}
 
-	nvt_spi_read_mdata(ts->mmap->BASELINE_ADDR, ts->mmap->BASELINE_BTN_ADDR);
+	if (nvt_spi_read_mdata(ts->mmap->BASELINE_ADDR, ts->mmap->BASELINE_BTN_ADDR)) {
+		nvt_spi_change_mode(NVT_SPI_NORMAL_MODE);
+		mutex_unlock(&ts->lock);
+		return -EAGAIN;
+	}
 
 	nvt_spi_change_mode(NVT_SPI_NORMAL_MODE);
 
@@ -1237,6 +1186,7 @@ static const struct proc_ops nvt_spi_baseline_fops = {
 static int32_t nvt_spi_raw_open(struct inode *inode, struct file *file)
 {
 	struct nvt_spi_data_t *ts = nvt_spi_data;
+	int32_t ret = 0;
 
 	if (mutex_lock_interruptible(&ts->lock))
 		return -ERESTARTSYS;
@@ -1265,9 +1215,15 @@ static int32_t nvt_spi_raw_open(struct inode *inode, struct file *file)
 	}
 
 	if (nvt_spi_get_fw_pipe() == 0)
-		nvt_spi_read_mdata(ts->mmap->RAW_PIPE0_ADDR, ts->mmap->RAW_BTN_PIPE0_ADDR);
+		ret = nvt_spi_read_mdata(ts->mmap->RAW_PIPE0_ADDR, ts->mmap->RAW_BTN_PIPE0_ADDR);
 	else
-		nvt_spi_read_mdata(ts->mmap->RAW_PIPE1_ADDR, ts->mmap->RAW_BTN_PIPE1_ADDR);
+		ret = nvt_spi_read_mdata(ts->mmap->RAW_PIPE1_ADDR, ts->mmap->RAW_BTN_PIPE1_ADDR);
+
+	if (ret) {
+		nvt_spi_change_mode(NVT_SPI_NORMAL_MODE);
+		mutex_unlock(&ts->lock);
+		return -EAGAIN;
+	}
 
 	nvt_spi_change_mode(NVT_SPI_NORMAL_MODE);
 
@@ -1297,6 +1253,7 @@ static const struct proc_ops nvt_spi_raw_fops = {
 static int32_t nvt_spi_diff_open(struct inode *inode, struct file *file)
 {
 	struct nvt_spi_data_t *ts = nvt_spi_data;
+	int32_t ret = 0;
 
 	if (mutex_lock_interruptible(&ts->lock))
 		return -ERESTARTSYS;
@@ -1325,9 +1282,15 @@ static int32_t nvt_spi_diff_open(struct inode *inode, struct file *file)
 	}
 
 	if (nvt_spi_get_fw_pipe() == 0)
-		nvt_spi_read_mdata(ts->mmap->DIFF_PIPE0_ADDR, ts->mmap->DIFF_BTN_PIPE0_ADDR);
+		ret = nvt_spi_read_mdata(ts->mmap->DIFF_PIPE0_ADDR, ts->mmap->DIFF_BTN_PIPE0_ADDR);
 	else
-		nvt_spi_read_mdata(ts->mmap->DIFF_PIPE1_ADDR, ts->mmap->DIFF_BTN_PIPE1_ADDR);
+		ret = nvt_spi_read_mdata(ts->mmap->DIFF_PIPE1_ADDR, ts->mmap->DIFF_BTN_PIPE1_ADDR);
+
+	if (ret) {
+		nvt_spi_change_mode(NVT_SPI_NORMAL_MODE);
+		mutex_unlock(&ts->lock);
+		return -EAGAIN;
+	}
 
 	nvt_spi_change_mode(NVT_SPI_NORMAL_MODE);
 
@@ -1358,6 +1321,7 @@ static int32_t nvt_spi_pen_diff_open(struct inode *inode, struct file *file)
 {
 	uint32_t addr;
 	struct nvt_spi_data_t *ts = nvt_spi_data;
+	int32_t ret = 0;
 
 	if (mutex_lock_interruptible(&ts->lock))
 		return -ERESTARTSYS;
@@ -1396,16 +1360,19 @@ static int32_t nvt_spi_pen_diff_open(struct inode *inode, struct file *file)
 	}
 
 	addr = ts->mmap->PEN_1D_DIFF_TIP_X_ADDR;
-	nvt_spi_read_get_num_mdata(addr, nvt_spi_xdata_pen_tip_x, ts->x_num);
+	ret = nvt_spi_read_get_num_mdata(addr, nvt_spi_xdata_pen_tip_x, ts->x_num);
 
 	addr = ts->mmap->PEN_1D_DIFF_TIP_Y_ADDR;
-	nvt_spi_read_get_num_mdata(addr, nvt_spi_xdata_pen_tip_y, ts->y_num);
+	if (!ret)
+		ret = nvt_spi_read_get_num_mdata(addr, nvt_spi_xdata_pen_tip_y, ts->y_num);
 
 	addr = ts->mmap->PEN_1D_DIFF_RING_X_ADDR;
-	nvt_spi_read_get_num_mdata(addr, nvt_spi_xdata_pen_ring_x, ts->x_num);
+	if (!ret)
+		ret = nvt_spi_read_get_num_mdata(addr, nvt_spi_xdata_pen_ring_x, ts->x_num);
 
 	addr = ts->mmap->PEN_1D_DIFF_RING_Y_ADDR;
-	nvt_spi_read_get_num_mdata(addr, nvt_spi_xdata_pen_ring_y, ts->y_num);
+	if (!ret)
+		ret = nvt_spi_read_get_num_mdata(addr, nvt_spi_xdata_pen_ring_y, ts->y_num);
 
 	nvt_spi_change_mode(NVT_SPI_NORMAL_MODE);
 
@@ -1415,6 +1382,9 @@ static int32_t nvt_spi_pen_diff_open(struct inode *inode, struct file *file)
 
 	mutex_unlock(&ts->lock);
 
+	if (ret)
+		return -EAGAIN;
+
 	NVT_LOG("--\n");
 
 	return seq_open(file, &nvt_spi_pen_diff_seq_ops);
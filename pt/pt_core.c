@@ -119,6 +119,7 @@ struct pt_hid_report {
 
 struct atten_node {
 	struct list_head node;
+	struct rcu_head rcu;
 	char *id;
 	struct device *dev;
 
@@ -7542,23 +7543,26 @@ static void pt_queue_restart(struct pt_core_data *cd)
 static void call_atten_cb(struct pt_core_data *cd,
 		enum pt_atten_type type, int mode)
 {
-	struct atten_node *atten, *atten_n;
+	struct atten_node *atten;
+	int idx;
 
 	pt_debug(cd->dev, DL_DEBUG, "%s: check list type=%d mode=%d\n",
 		__func__, type, mode);
-	spin_lock(&cd->spinlock);
-	list_for_each_entry_safe(atten, atten_n,
-			&cd->atten_list[type], node) {
+	/*
+	 * Callbacks may sleep and may unsubscribe themselves, so walk the
+	 * list under SRCU; removed nodes are freed after the walk ends.
+	 */
+	idx = srcu_read_lock(&cd->atten_srcu);
+	list_for_each_entry_srcu(atten, &cd->atten_list[type], node,
+			srcu_read_lock_held(&cd->atten_srcu)) {
 		if (!mode || atten->mode & mode) {
-			spin_unlock(&cd->spinlock);
 			pt_debug(cd->dev, DL_DEBUG,
 				"%s: attention for '%s'",
 				__func__, dev_name(atten->dev));
 			atten->func(atten->dev);
-			spin_lock(&cd->spinlock);
 		}
 	}
-	spin_unlock(&cd->spinlock);
+	srcu_read_unlock(&cd->atten_srcu, idx);
 }
 
 /*******************************************************************************
@@ -8638,6 +8642,22 @@ irqreturn_t pt_irq(int irq, void *handle)
 }
 
 
+/*******************************************************************************
+ * FUNCTION: pt_free_atten_node
+ *
+ * SUMMARY: SRCU callback to free an attention node once no call_atten_cb()
+ *	walk can still see it
+ *
+ * RETURN: void
+ *
+ * PARAMETERS:
+ *	*rcu - pointer to the rcu_head of the attention node
+ ******************************************************************************/
+static void pt_free_atten_node(struct rcu_head *rcu)
+{
+	kfree(container_of(rcu, struct atten_node, rcu));
+}
+
 /*******************************************************************************
  * FUNCTION: _pt_subscribe_attention
  *
@@ -8669,10 +8689,10 @@ int _pt_subscribe_attention(struct device *dev,
 	pt_debug(cd->dev, DL_INFO, "%s from '%s'\n", __func__,
 		dev_name(cd->dev));
 
-	spin_lock(&cd->spinlock);
+	mutex_lock(&cd->atten_lock);
 	list_for_each_entry(atten, &cd->atten_list[type], node) {
 		if (atten->id == id && atten->mode == mode) {
-			spin_unlock(&cd->spinlock);
+			mutex_unlock(&cd->atten_lock);
 			kfree(atten_new);
 			pt_debug(cd->dev, DL_INFO, "%s: %s=%p %s=%d\n",
 				 __func__,
@@ -8688,8 +8708,8 @@ int _pt_subscribe_attention(struct device *dev,
 	atten_new->mode = mode;
 	atten_new->func = func;
 
-	list_add(&atten_new->node, &cd->atten_list[type]);
-	spin_unlock(&cd->spinlock);
+	list_add_rcu(&atten_new->node, &cd->atten_list[type]);
+	mutex_unlock(&cd->atten_lock);
 
 	return 0;
 }
@@ -8716,22 +8736,24 @@ int _pt_unsubscribe_attention(struct device *dev,
 	int mode)
 {
 	struct pt_core_data *cd = dev_get_drvdata(dev);
-	struct atten_node *atten, *atten_n;
+	struct atten_node *atten;
 
-	spin_lock(&cd->spinlock);
-	list_for_each_entry_safe(atten, atten_n, &cd->atten_list[type], node) {
+	mutex_lock(&cd->atten_lock);
+	list_for_each_entry(atten, &cd->atten_list[type], node) {
 		if (atten->id == id && atten->mode == mode) {
-			list_del(&atten->node);
-			spin_unlock(&cd->spinlock);
+			list_del_rcu(&atten->node);
+			mutex_unlock(&cd->atten_lock);
 			pt_debug(cd->dev, DL_DEBUG, "%s: %s=%p %s=%d\n",
 				__func__,
 				"unsub for atten->dev", atten->dev,
 				"atten->mode", atten->mode);
-			kfree(atten);
+			/* may be called from within call_atten_cb() */
+			call_srcu(&cd->atten_srcu, &atten->rcu,
+				pt_free_atten_node);
 			return 0;
 		}
 	}
-	spin_unlock(&cd->spinlock);
+	mutex_unlock(&cd->atten_lock);
 
 	return -ENODEV;
 }
@@ -17947,6 +17969,12 @@ int pt_probe(const struct pt_bus_ops *ops, struct device *dev,
 	mutex_init(&cd->ttdl_restart_lock);
 	mutex_init(&cd->firmware_class_lock);
 	spin_lock_init(&cd->spinlock);
+	mutex_init(&cd->atten_lock);
+	rc = init_srcu_struct(&cd->atten_srcu);
+	if (rc) {
+		dev_err(dev, "Failed to init attention srcu: rc=%d\n", rc);
+		goto error_alloc_data;
+	}
 
 	/* Initialize module list */
 	INIT_LIST_HEAD(&cd->module_list);
@@ -17975,7 +18003,7 @@ int pt_probe(const struct pt_bus_ops *ops, struct device *dev,
 	rc = pt_get_regulator(cd, true);
 	if (rc) {
 		dev_err(&client->dev, "Failed to get voltage regulators\n");
-		goto error_alloc_data;
+		goto error_init_srcu;
 	}
 
 	rc = pt_enable_regulator(cd, true);
@@ -18311,6 +18339,9 @@ error_enable_regulator:
 	pt_enable_regulator(cd, false);
 error_get_regulator:
 	pt_get_regulator(cd, false);
+error_init_srcu:
+	srcu_barrier(&cd->atten_srcu);
+	cleanup_srcu_struct(&cd->atten_srcu);
 error_alloc_data:
 	kfree(cd);
 error_no_pdata:
@@ -18591,6 +18622,8 @@ int pt_release(struct pt_core_data *cd)
 	pt_enable_regulator(cd, false);
 	pt_get_regulator(cd, false);
 	pt_free_si_ptrs(cd);
+	srcu_barrier(&cd->atten_srcu);
+	cleanup_srcu_struct(&cd->atten_srcu);
 	kfree(cd);
 	return 0;
 }
@@ -18600,3 +18633,7 @@ EXPORT_SYMBOL_GPL(pt_release);
 MODULE_LICENSE("GPL");
 MODULE_DESCRIPTION("Parade TrueTouch(R) Standard Product Core Driver");
 MODULE_AUTHOR("Parade Technologies <ttdrivers@paradetech.com>");
+
+#if IS_ENABLED(CONFIG_TOUCHSCREEN_KUNIT_TEST)
+#include "../touch_kunit/tests/pt_atten_test.c"
+#endif
@@ -34,6 +34,7 @@
 
 #define PT_I2C_DATA_SIZE  (2 * 256)
 #define PT_I2C_NAME "pt_i2c_adapter"
+#define PT_I2C_PREDICT_HEADROOM 16
 
 /*******************************************************************************
  * FUNCTION: pt_i2c_read_default
@@ -59,12 +60,66 @@ static int pt_i2c_read_default(struct device *dev, void *buf, int size)
 	return (rc < 0) ? rc : rc != read_size ? -EIO : 0;
 }
 
+/*******************************************************************************
+ * FUNCTION: pt_i2c_read_predict
+ *
+ * SUMMARY: Read from the I2C bus in one transaction using the last seen
+ *	packet size plus some headroom. A follow-up read of the whole packet
+ *	is only issued when the HID packet size (2 bytes) says more bytes
+ *	remain than were predicted.
+ *
+ * PARAMETERS:
+ *      *dev  - pointer to Device structure
+ *      *cd   - pointer to core data
+ *      *buf  - pointer to buffer where the data read will be stored
+ *       max  - max size that can be read
+ ******************************************************************************/
+static int pt_i2c_read_predict(struct device *dev, struct pt_core_data *cd,
+		u8 *buf, u32 max)
+{
+	struct i2c_client *client = to_i2c_client(dev);
+	int rc;
+	u32 size;
+	u32 predict;
+
+	predict = cd->predict_read_size + PT_I2C_PREDICT_HEADROOM;
+	predict = clamp_t(u32, predict, 2, max);
+
+	rc = i2c_master_recv(client, buf, predict);
+	if (rc < 0 || rc != (int)predict)
+		return (rc < 0) ? rc : -EIO;
+
+	size = get_unaligned_le16(&buf[0]);
+	if (!size || size == 2 || size >= PT_PIP_1P7_EMPTY_BUF) {
+		/*
+		 * Before PIP 1.7, empty buffer is 0x0002;
+		 * From PIP 1.7, empty buffer is 0xFFXX
+		 */
+		cd->predict_read_hit++;
+		return 0;
+	}
+
+	if (size > max)
+		return -EINVAL;
+
+	cd->predict_read_size = size;
+	if (size <= predict) {
+		cd->predict_read_hit++;
+		return 0;
+	}
+
+	cd->predict_read_miss++;
+	rc = i2c_master_recv(client, buf, size);
+	return (rc < 0) ? rc : rc != (int)size ? -EIO : 0;
+}
+
 /*******************************************************************************
  * FUNCTION: pt_i2c_read_default_nosize
  *
  * SUMMARY: Read from the I2C bus in two transactions first reading the HID
  *	packet size (2 bytes) followed by reading the rest of the packet based
- *	on the size initially read.
+ *	on the size initially read. When predictive read is enabled for the
+ *	device, pt_i2c_read_predict() is used instead.
  *	NOTE: The empty buffer 'size' was redefined in PIP version 1.7.
  *
  * PARAMETERS:
@@ -75,6 +130,7 @@ static int pt_i2c_read_default(struct device *dev, void *buf, int size)
 static int pt_i2c_read_default_nosize(struct device *dev, u8 *buf, u32 max)
 {
 	struct i2c_client *client = to_i2c_client(dev);
+	struct pt_core_data *cd = dev_get_drvdata(dev);
 	struct i2c_msg msgs[2];
 	u8 msg_count = 1;
 	int rc;
@@ -83,6 +139,9 @@ static int pt_i2c_read_default_nosize(struct device *dev, u8 *buf, u32 max)
 	if (!buf)
 		return -EINVAL;
 
+	if (cd && cd->predictive_read)
+		return pt_i2c_read_predict(dev, cd, buf, max);
+
 	msgs[0].addr = client->addr;
 	msgs[0].flags = (client->flags & I2C_M_TEN) | I2C_M_RD;
 	msgs[0].len = 2;
@@ -159,6 +218,105 @@ static int pt_i2c_write_read_specific(struct device *dev, u16 write_len,
 	return rc;
 }
 
+/*******************************************************************************
+ * FUNCTION: pt_i2c_predictive_read_show
+ *
+ * SUMMARY: Show method for the predictive_read sysfs node that reports if
+ *	the single transaction predictive read is enabled.
+ *
+ * PARAMETERS:
+ *      *dev  - pointer to device structure
+ *      *attr - pointer to device attributes
+ *      *buf  - pointer to output buffer
+ ******************************************************************************/
+static ssize_t pt_i2c_predictive_read_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct pt_core_data *cd = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n", cd->predictive_read);
+}
+
+/*******************************************************************************
+ * FUNCTION: pt_i2c_predictive_read_store
+ *
+ * SUMMARY: Store method for the predictive_read sysfs node that enables or
+ *	disables the single transaction predictive read. The hit and miss
+ *	counters are cleared on every write.
+ *
+ * PARAMETERS:
+ *      *dev  - pointer to device structure
+ *      *attr - pointer to device attributes
+ *      *buf  - pointer to buffer that hold the command parameters
+ *       size - size of buf
+ ******************************************************************************/
+static ssize_t pt_i2c_predictive_read_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t size)
+{
+	struct pt_core_data *cd = dev_get_drvdata(dev);
+	bool enable;
+	int rc;
+
+	rc = kstrtobool(buf, &enable);
+	if (rc) {
+		pt_debug(dev, DL_ERROR, "%s: Invalid value\n", __func__);
+		return rc;
+	}
+
+	mutex_lock(&cd->system_lock);
+	cd->predictive_read = false;
+	cd->predict_read_size = 0;
+	cd->predict_read_hit = 0;
+	cd->predict_read_miss = 0;
+	cd->predictive_read = enable;
+	mutex_unlock(&cd->system_lock);
+
+	pt_debug(dev, DL_INFO, "%s: Predictive read %s\n", __func__,
+		enable ? "enabled" : "disabled");
+
+	return size;
+}
+static DEVICE_ATTR(predictive_read, 0644, pt_i2c_predictive_read_show,
+	pt_i2c_predictive_read_store);
+
+/*******************************************************************************
+ * FUNCTION: pt_i2c_predictive_read_stats_show
+ *
+ * SUMMARY: Show method for the predictive_read_stats sysfs node that reports
+ *	how many reads completed in one transaction (hit) and how many needed
+ *	a follow-up read (miss).
+ *
+ * PARAMETERS:
+ *      *dev  - pointer to device structure
+ *      *attr - pointer to device attributes
+ *      *buf  - pointer to output buffer
+ ******************************************************************************/
+static ssize_t pt_i2c_predictive_read_stats_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct pt_core_data *cd = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE,
+		"%s: %u\n"
+		"%s: %u\n"
+		"%s: %u\n",
+		"Hit", cd->predict_read_hit,
+		"Miss", cd->predict_read_miss,
+		"Last size", cd->predict_read_size);
+}
+static DEVICE_ATTR(predictive_read_stats, 0444,
+	pt_i2c_predictive_read_stats_show, NULL);
+
+static struct attribute *pt_i2c_attrs[] = {
+	&dev_attr_predictive_read.attr,
+	&dev_attr_predictive_read_stats.attr,
+	NULL,
+};
+
+static const struct attribute_group pt_i2c_attr_group = {
+	.attrs = pt_i2c_attrs,
+};
+
 static struct pt_bus_ops pt_i2c_bus_ops = {
 	.bustype = BUS_I2C,
 	.read_default = pt_i2c_read_default,
@@ -191,6 +349,7 @@ static int pt_i2c_probe(struct i2c_client *client,
 #ifdef CONFIG_TOUCHSCREEN_PARADE_DEVICETREE_SUPPORT
 	const struct of_device_id *match;
 #endif
+	struct pt_core_data *cd;
 	int rc;
 	if (!i2c_check_functionality(client->adapter, I2C_FUNC_I2C)) {
 		pt_debug(dev, DL_ERROR, "I2C functionality not Supported\n");
@@ -208,6 +367,16 @@ static int pt_i2c_probe(struct i2c_client *client,
 	rc = pt_probe(&pt_i2c_bus_ops, &client->dev, client->irq,
 			  PT_I2C_DATA_SIZE);
 
+	if (!rc) {
+		cd = dev_get_drvdata(dev);
+		cd->predictive_read = of_property_read_bool(dev->of_node,
+				"parade,predictive-read");
+		if (sysfs_create_group(&dev->kobj, &pt_i2c_attr_group))
+			pt_debug(dev, DL_WARN,
+				"%s: create predictive read attrs failed\n",
+				__func__);
+	}
+
 #ifdef CONFIG_TOUCHSCREEN_PARADE_DEVICETREE_SUPPORT
 	if (rc && match)
 		pt_devtree_clean_pdata(dev);
@@ -231,6 +400,7 @@ static int pt_i2c_remove(struct i2c_client *client)
 	struct device *dev = &client->dev;
 	struct pt_core_data *cd = i2c_get_clientdata(client);
 
+	sysfs_remove_group(&dev->kobj, &pt_i2c_attr_group);
 	pt_release(cd);
 
 #ifdef CONFIG_TOUCHSCREEN_PARADE_DEVICETREE_SUPPORT
@@ -326,3 +496,7 @@ module_exit(pt_i2c_exit);
 MODULE_LICENSE("GPL");
 MODULE_DESCRIPTION("Parade TrueTouch(R) Standard Product I2C driver");
 MODULE_AUTHOR("Parade Technologies <ttdrivers@paradetech.com>");
+
+#if IS_ENABLED(CONFIG_TOUCHSCREEN_KUNIT_TEST)
+#include "../touch_kunit/tests/pt_i2c_test.c"
+#endif
@@ -73,8 +73,10 @@
 #include <linux/of_device.h>
 #include <linux/of.h>
 #include <linux/pm_runtime.h>
+#include <linux/rculist.h>
 #include <linux/sched.h>
 #include <linux/slab.h>
+#include <linux/srcu.h>
 #include <linux/suspend.h>
 #include <linux/stringify.h>
 #include <linux/types.h>
@@ -1458,6 +1460,8 @@ struct pt_core_data {
 	struct work_struct	resume_work;
 
 	struct list_head atten_list[PT_ATTEN_NUM_ATTEN];
+	struct mutex atten_lock;	/* serializes atten_list updates */
+	struct srcu_struct atten_srcu;	/* protects atten_list walks */
 	struct list_head param_list;
 	struct mutex module_list_lock;
 	struct mutex system_lock;
@@ -1598,6 +1602,11 @@ struct pt_core_data {
 	bool touch_offload;
 	bool vdd_is_enabled;
 	bool vcc_i2c_is_enabled;
+	/* Predictive single transaction read, used by the I2C bus module */
+	bool predictive_read;
+	u16 predict_read_size;
+	u32 predict_read_hit;
+	u32 predict_read_miss;
 };
 
 struct gd_sensor {
@@ -245,15 +245,64 @@ static void qts_irq_enable(struct qts_data *qts_data, bool en)
 	}
 }
 
+static bool qts_irq_owned(struct qts_data *qts_data)
+{
+#ifdef CONFIG_ARCH_QTI_VM
+	return atomic_read(&qts_data->trusted_touch_enabled);
+#else
+	return !atomic_read(&qts_data->trusted_touch_enabled);
+#endif
+}
+
+/*
+ * Called with transition_lock held for an interrupt latched while the lock
+ * was busy. The frame is handed to the vendor driver unless the touch
+ * controller is suspended, a trusted touch transition is in progress or
+ * the interrupt now belongs to the other VM.
+ */
+static void qts_irq_replay(struct qts_data *qts_data)
+{
+	if (qts_data->suspended || !qts_irq_owned(qts_data) ||
+			atomic_read(&qts_data->trusted_touch_transition)) {
+		atomic_inc(&qts_data->irq_discarded_cnt);
+		pr_debug("pending irq discarded\n");
+		return;
+	}
+
+	atomic_inc(&qts_data->irq_replayed_cnt);
+	qts_data->vendor_ops.irq_handler(qts_data->irq, qts_data->vendor_data);
+}
+
+/*
+ * Release transition_lock and replay an interrupt that arrived while it was
+ * held. If the lock is taken again by someone else in the meantime, the new
+ * holder replays the latched interrupt when it releases the lock.
+ */
+static void qts_transition_unlock(struct qts_data *qts_data)
+{
+	mutex_unlock(&qts_data->transition_lock);
+
+	while (atomic_read(&qts_data->irq_pending)) {
+		if (!mutex_trylock(&qts_data->transition_lock))
+			return;
+		if (atomic_xchg(&qts_data->irq_pending, 0))
+			qts_irq_replay(qts_data);
+		mutex_unlock(&qts_data->transition_lock);
+	}
+}
+
 static irqreturn_t  qts_irq_handler(int irq, void *data)
 {
 	struct qts_data *qts_data = data;
 
+	/* latch first, so a concurrent unlock can not miss this interrupt */
+	atomic_set(&qts_data->irq_pending, 1);
 	if (!mutex_trylock(&qts_data->transition_lock))
 		return IRQ_HANDLED;
 
-	qts_data->vendor_ops.irq_handler(irq, qts_data->vendor_data);
-	mutex_unlock(&qts_data->transition_lock);
+	if (atomic_xchg(&qts_data->irq_pending, 0))
+		qts_data->vendor_ops.irq_handler(irq, qts_data->vendor_data);
+	qts_transition_unlock(qts_data);
 	return IRQ_HANDLED;
 }
 
@@ -396,7 +445,7 @@ static void qts_trusted_touch_tvm_vm_mode_enable(struct qts_data *qts_data)
 		pr_info("All lend notifications not received\n");
 		qts_trusted_touch_event_notify(qts_data,
 				TRUSTED_TOUCH_EVENT_NOTIFICATIONS_PENDING);
-		mutex_unlock(&qts_data->transition_lock);
+		qts_transition_unlock(qts_data);
 		return;
 	}
 
@@ -485,7 +534,7 @@ static void qts_trusted_touch_tvm_vm_mode_enable(struct qts_data *qts_data)
 
 	pr_info("Irq, iomem are accepted and trusted touch enabled\n");
 
-	mutex_unlock(&qts_data->transition_lock);
+	qts_transition_unlock(qts_data);
 	return;
 sgl_cmp_fail:
 	kfree(expected_sgl_desc);
@@ -496,7 +545,7 @@ acl_fail:
 accept_fail:
 	qts_trusted_touch_abort_handler(qts_data,
 			TRUSTED_TOUCH_EVENT_ACCEPT_FAILURE);
-	mutex_unlock(&qts_data->transition_lock);
+	qts_transition_unlock(qts_data);
 }
 
 static void qts_vm_irq_on_lend_callback(void *data,
@@ -585,7 +634,7 @@ static void qts_trusted_touch_tvm_vm_mode_disable(struct qts_data *qts_data)
 	mutex_lock(&qts_data->transition_lock);
 	if (atomic_read(&qts_data->trusted_touch_abort_status)) {
 		qts_trusted_touch_abort_tvm(qts_data);
-		mutex_unlock(&qts_data->transition_lock);
+		qts_transition_unlock(qts_data);
 		return;
 	}
 
@@ -628,12 +677,12 @@ static void qts_trusted_touch_tvm_vm_mode_disable(struct qts_data *qts_data)
 		qts_data->vendor_ops.post_le_tui_disable(qts_data->vendor_data);
 
 	pr_info("Irq, iomem are released and trusted touch disabled\n");
-	mutex_unlock(&qts_data->transition_lock);
+	qts_transition_unlock(qts_data);
 	return;
 error:
 	qts_trusted_touch_abort_handler(qts_data,
 			TRUSTED_TOUCH_EVENT_RELEASE_FAILURE);
-	mutex_unlock(&qts_data->transition_lock);
+	qts_transition_unlock(qts_data);
 }
 
 static int qts_handle_trusted_touch_tvm(struct qts_data *qts_data, int value)
@@ -1126,9 +1175,12 @@ static int qts_trusted_touch_pvm_vm_mode_enable(struct qts_data *qts_data)
 	if (qts_data->vendor_ops.post_la_tui_enable)
 		qts_data->vendor_ops.post_la_tui_enable(qts_data->vendor_data);
 
-	mutex_unlock(&qts_data->transition_lock);
-	atomic_set(&qts_data->trusted_touch_transition, 0);
+	/* the irq belongs to the TVM now, drop anything latched during the lend */
 	atomic_set(&qts_data->trusted_touch_enabled, 1);
+	if (atomic_xchg(&qts_data->irq_pending, 0))
+		atomic_inc(&qts_data->irq_discarded_cnt);
+	qts_transition_unlock(qts_data);
+	atomic_set(&qts_data->trusted_touch_transition, 0);
 	pr_info("Irq, iomem are lent and trusted touch enabled\n");
 	return rc;
 
@@ -1136,7 +1188,7 @@ abort_handler:
 	qts_trusted_touch_abort_handler(qts_data, TRUSTED_TOUCH_EVENT_LEND_FAILURE);
 
 error:
-	mutex_unlock(&qts_data->transition_lock);
+	qts_transition_unlock(qts_data);
 	return rc;
 }
 
@@ -1469,6 +1521,30 @@ static ssize_t trusted_touch_device_path_show(struct kobject *kobj,
 	return scnprintf(buf, PAGE_SIZE, "%s", path ? path : "");
 }
 
+static ssize_t irq_replayed_show(struct kobject *kobj,
+			struct kobj_attribute *attr, char *buf)
+{
+	struct qts_data *qts_data;
+	u32 idx = qts_ts_is_primary(kobj) ? 0 : 1;
+
+	qts_data = &qts_data_entries->info[idx];
+
+	return scnprintf(buf, PAGE_SIZE, "%d",
+			atomic_read(&qts_data->irq_replayed_cnt));
+}
+
+static ssize_t irq_discarded_show(struct kobject *kobj,
+			struct kobj_attribute *attr, char *buf)
+{
+	struct qts_data *qts_data;
+	u32 idx = qts_ts_is_primary(kobj) ? 0 : 1;
+
+	qts_data = &qts_data_entries->info[idx];
+
+	return scnprintf(buf, PAGE_SIZE, "%d",
+			atomic_read(&qts_data->irq_discarded_cnt));
+}
+
 static struct kobj_attribute trusted_touch_enable_attr =
 	__ATTR(trusted_touch_enable, 0664, trusted_touch_enable_show, trusted_touch_enable_store);
 
@@ -1481,11 +1557,19 @@ static struct kobj_attribute trusted_touch_type_attr =
 static struct kobj_attribute trusted_touch_device_path_attr =
 	__ATTR(trusted_touch_device_path, 0444, trusted_touch_device_path_show, NULL);
 
+static struct kobj_attribute irq_replayed_attr =
+	__ATTR(irq_replayed, 0444, irq_replayed_show, NULL);
+
+static struct kobj_attribute irq_discarded_attr =
+	__ATTR(irq_discarded, 0444, irq_discarded_show, NULL);
+
 static struct attribute *qts_attributes[] = {
 	&trusted_touch_enable_attr.attr,
 	&trusted_touch_event_attr.attr,
 	&trusted_touch_type_attr.attr,
 	&trusted_touch_device_path_attr.attr,
+	&irq_replayed_attr.attr,
+	&irq_discarded_attr.attr,
 	NULL,
 };
 
@@ -1637,7 +1721,7 @@ static void qts_ts_suspend(struct qts_data *qts_data)
 		pr_err("suspend failed, rc = %d\n", rc);
 
 	qts_data->suspended = true;
-	mutex_unlock(&qts_data->transition_lock);
+	qts_transition_unlock(qts_data);
 }
 
 static void qts_ts_resume(struct qts_data *qts_data)
@@ -1660,7 +1744,7 @@ static void qts_ts_resume(struct qts_data *qts_data)
 		pr_err("resume failed, rc = %d\n", rc);
 
 	qts_data->suspended = false;
-	mutex_unlock(&qts_data->transition_lock);
+	qts_transition_unlock(qts_data);
 }
 
 static void qts_resume_work(struct work_struct *work)
@@ -1823,6 +1907,9 @@ int qts_client_register(struct qts_vendor_data qts_vendor_data)
 		qts_create_sysfs(qts_data);
 
 	mutex_init(&qts_data->transition_lock);
+	atomic_set(&qts_data->irq_pending, 0);
+	atomic_set(&qts_data->irq_replayed_cnt, 0);
+	atomic_set(&qts_data->irq_discarded_cnt, 0);
 	qts_ts_register_for_panel_events(qts_data);
 	qts_vendor_data.notifier_cookie = qts_data->notifier_cookie;
 
@@ -1881,3 +1968,7 @@ EXPORT_SYMBOL_GPL(qts_client_unregister);
 
 MODULE_DESCRIPTION("Qualcomm Technologies, Inc. Touchscreen driver");
 MODULE_LICENSE("GPL");
+
+#if IS_ENABLED(CONFIG_TOUCHSCREEN_KUNIT_TEST)
+#include "../touch_kunit/tests/qts_core_test.c"
+#endif
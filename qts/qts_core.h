@@ -135,6 +135,10 @@ struct qts_data {
 
 	struct mutex transition_lock;
 	bool suspended;
+	/* irq latched while transition_lock was busy */
+	atomic_t irq_pending;
+	atomic_t irq_replayed_cnt;
+	atomic_t irq_discarded_cnt;
 
 	/* vendor callback ops */
 	struct qts_vendor_callback_ops vendor_ops;
@@ -269,6 +269,7 @@ ERROR_EXIT:
 
 void gpio_touch_reset_pin_control(unsigned char u8_high)
 {
+	g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 
 	if (u8_high)
 		gpio_set_value(ts->rst_gpio, 1);
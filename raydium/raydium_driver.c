@@ -73,6 +73,7 @@ const struct attribute_group raydium_attr_group;
 unsigned char g_u8_addr;
 unsigned char g_u8_raydium_flag;
 unsigned char g_u8_i2c_mode;
+unsigned char g_u8_pda2_page;
 unsigned char g_u8_upgrade_type;
 unsigned char g_u8_raw_data_type;
 unsigned int g_u32_raw_data_len;    /* 128 bytes*/
@@ -103,6 +104,7 @@ static void raydium_variable_init(void)
 	g_u8_addr = RAYDIUM_PDA2_PDA_CFG_ADDR;
 	g_u8_raydium_flag = NORMAL_MODE;
 	g_u8_i2c_mode = PDA2_MODE;
+	g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 	g_u8_upgrade_type = 0;
 	g_u8_raw_data_type = RAYDIUM_FT_UPDATE;
 	g_u32_raw_data_len = 64 * 2;    /* 128 bytes*/
@@ -172,6 +174,7 @@ static int raydium_gpio_configure(bool on)
 			}
 
 			i32_err = gpio_direction_output(g_raydium_ts->rst_gpio, 1);
+			g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 			if (i32_err) {
 				LOGD(LOG_ERR,
 				     "[touch]set_direction for irq gpio failed\n");
@@ -267,6 +270,7 @@ static int raydium_hw_reset_fun(struct i2c_client *client)
 	gpio_set_value(g_raydium_ts->rst_gpio, 1);
 
 	g_u8_i2c_mode = PDA2_MODE;
+	g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 
 	i32_ret = wait_irq_state(client, 300, 2000);
 	if (i32_ret != ERROR)
@@ -311,6 +315,7 @@ int raydium_i2c_write_pda_via_pda2(struct i2c_client *client,
 	if (u16_length > MAX_WRITE_PACKET_SIZE)
 		return -EINVAL;
 	g_u8_i2c_mode = PDA2_MODE;
+	g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 
 	u8_buf[0] = RAYDIUM_I2C_PDA_CMD;
 	u8_buf[1] = (unsigned char)u32_addr;
@@ -368,6 +373,7 @@ int raydium_i2c_read_pda_via_pda2(struct i2c_client *client,
 		u8_mode = I2C_PDA2_BYTE_MODE;
 
 	g_u8_i2c_mode = PDA2_MODE;
+	g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 	u8_buf[0] = RAYDIUM_I2C_PDA_CMD;
 	u8_buf[1] = (unsigned char)u32_addr;
 	u8_buf[2] = (unsigned char)(u32_addr >> 8);
@@ -399,6 +405,7 @@ int raydium_i2c_pda_set_address(unsigned int u32_address,
 	unsigned char u8_buf[RAD_I2C_PDA_ADDRESS_LENGTH];
 	struct i2c_client *client = g_raydium_ts->client;
 
+	g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 	client->addr = RAYDIUM_I2C_EID;
 	u8_buf[0] = (u32_address & 0x0000FF00) >> 8;
 	u8_buf[1] = (u32_address & 0x00FF0000) >> 16;
@@ -606,9 +613,31 @@ int raydium_i2c_pda2_set_page(struct i2c_client *client,
 		i32_ret = -EIO;
 	}
 
+	/* pages from RAYDIUM_PDA2_ENABLE_PDA on only last for one access */
+	if (i32_ret == RAYDIUM_I2C_PDA2_PAGE_LENGTH &&
+	    u8_page < RAYDIUM_PDA2_ENABLE_PDA)
+		g_u8_pda2_page = u8_page;
+	else
+		g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
+
 	return i32_ret;
 }
 
+/*
+ * Same as raydium_i2c_pda2_set_page(), but skips the bus write when the
+ * page is already selected. Anything that may move the IC off the cached
+ * page (reset, PDA access, i2c mode change) invalidates g_u8_pda2_page.
+ */
+int raydium_i2c_pda2_select_page(struct i2c_client *client,
+				 unsigned int is_suspend,
+				 unsigned char u8_page)
+{
+	if (g_u8_pda2_page == u8_page)
+		return RAYDIUM_I2C_PDA2_PAGE_LENGTH;
+
+	return raydium_i2c_pda2_set_page(client, is_suspend, u8_page);
+}
+
 int raydium_i2c_pda2_read(struct i2c_client *client,
 			  unsigned char u8_addr,
 			  unsigned char *u8_r_data,
@@ -750,6 +779,7 @@ unsigned char raydium_disable_i2c_deglitch(void)
 	}
 
 	g_u8_i2c_mode = PDA_MODE;
+	g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 	u8_retry = 100;
 	while (u8_retry--) {
 		u8_check = 0;
@@ -816,6 +846,7 @@ unsigned char raydium_disable_i2c_deglitch(void)
 	raydium_i2c_pda_set_address(0x50000628, DISABLE);
 
 	g_u8_i2c_mode = PDA2_MODE;
+	g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 
 	return SUCCESS;
 }
@@ -853,6 +884,7 @@ int raydium_i2c_mode_control(struct i2c_client *client,
 		raydium_i2c_pda2_set_page(client,
 					  g_raydium_ts->is_suspend, RAYDIUM_PDA2_2_PDA);
 		g_u8_i2c_mode = PDA_MODE;
+		g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 		LOGD(LOG_INFO, "[touch]Disable PDA2_MODE\n");
 		break;
 	case 8:
@@ -862,6 +894,7 @@ int raydium_i2c_mode_control(struct i2c_client *client,
 		raydium_i2c_pda_set_address(RAYDIUM_PDA_I2CREG, DISABLE);
 
 		g_u8_i2c_mode = PDA2_MODE;
+		g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 		LOGD(LOG_INFO, "[touch]Enable PDA2_MODE\n");
 		break;
 	}
@@ -1088,20 +1121,19 @@ int raydium_read_touchdata(unsigned char *p_u8_tp_status,  unsigned char *p_u8_b
 	unsigned char u8_retry;
 	unsigned char u8_read_size;
 	unsigned char u8_read_buf[MAX_REPORT_PACKET_SIZE];
-	unsigned char u8_retry_temp;
-	u8_retry = 100;
-	u8_retry_temp = u8_retry;
+	u8_retry = RAYDIUM_PAGE_RETRY_TIMES;
 
 	mutex_lock(&g_raydium_ts->lock);
 	while (u8_retry != 0) {
-		i32_ret = raydium_i2c_pda2_set_page(g_raydium_ts->client,
+		i32_ret = raydium_i2c_pda2_select_page(g_raydium_ts->client,
 						    g_raydium_ts->is_suspend, RAYDIUM_PDA2_PAGE_0);
 		if (i32_ret < 0) {
-			if ((!g_raydium_ts->is_retry) && (u8_retry < (u8_retry_temp - 1))) {
+			if ((!g_raydium_ts->is_retry) && (u8_retry < (RAYDIUM_PAGE_RETRY_TIMES - 1))) {
 				LOGD(LOG_INFO, "[touch]%s: g_raydium_ts->is_retry=%d, break\n", __func__, g_raydium_ts->is_retry);
 				break;
 			}
-			msleep(250);
+			usleep_range(RAYDIUM_PAGE_RETRY_DELAY_US,
+				     RAYDIUM_PAGE_RETRY_DELAY_US * 2);
 			u8_retry--;
 		} else
 			break;
@@ -1113,10 +1145,9 @@ int raydium_read_touchdata(unsigned char *p_u8_tp_status,  unsigned char *p_u8_b
 		goto reset_error;
 	}
 
-	memset(u8_read_buf, 0, MAX_REPORT_PACKET_SIZE);
 	memset(p_u8_buf, 0, MAX_REPORT_PACKET_SIZE);
 	memset(p_u8_tp_status, 0, MAX_TCH_STATUS_PACKET_SIZE);
-	u8_read_size = 4 + MAX_TOUCH_NUM * LEN_PT + 1;
+	u8_read_size = MAX_TCH_STATUS_PACKET_SIZE + MAX_TOUCH_NUM * LEN_PT + 1;
 	/*read touch point information*/
 	i32_ret = raydium_i2c_pda2_read(g_raydium_ts->client,
 					RAYDIUM_PDA2_TCH_RPT_STATUS_ADDR,
@@ -1124,6 +1155,7 @@ int raydium_read_touchdata(unsigned char *p_u8_tp_status,  unsigned char *p_u8_b
 	if (i32_ret < 0) {
 		LOGD(LOG_ERR, "[touch]%s: failed to read data: %d\n",
 		     __func__, __LINE__);
+		g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 		goto exit_error;
 	}
 	memcpy(p_u8_tp_status, &u8_read_buf[0], MAX_TCH_STATUS_PACKET_SIZE);
@@ -1356,6 +1388,7 @@ static int raydium_check_i2c_ready(unsigned short *u16_i2c_data)
 		if (u8_buf[3] != 0xF3) {
 			LOGD(LOG_ERR, "[touch]PDA2 read i2c fail\n");
 			g_u8_i2c_mode = PDA_MODE;
+			g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 			i32_ret = handle_i2c_pda_read(g_raydium_ts->client,
 						      RAYDIUM_CHK_I2C_CMD, u8_buf, 4);
 			if (i32_ret < 0)
@@ -1395,6 +1428,9 @@ static void raydium_ts_do_suspend(void)
 	raydium_irq_control(DISABLE);
 	/*#endif*/
 
+	/* the IC may lose its page selection while suspended */
+	g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
+
 	/*clear workqueue*/
 	if (!cancel_work_sync(&g_raydium_ts->work))
 		LOGD(LOG_DEBUG, "[touch]workqueue is empty!\n");
@@ -1526,6 +1562,7 @@ static int raydium_ts_open(struct input_dev *input_dev)
 			gpio_set_value(g_raydium_ts->rst_gpio, 1);
 			msleep(RAYDIUM_RESET_DELAY_MSEC);/*100ms*/
 			g_u8_i2c_mode = PDA2_MODE;
+			g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 		}
 		mutex_unlock(&g_raydium_ts->lock);
 		raydium_irq_control(ENABLE);
@@ -48,6 +48,9 @@
 #define RAYDIUM_I2C_WRITE       I2C_SMBUS_WRITE
 #define RAYDIUM_I2C_READ        I2C_SMBUS_READ
 #define SYN_I2C_RETRY_TIMES     1
+/* set page retry before a touch report read */
+#define RAYDIUM_PAGE_RETRY_TIMES        5
+#define RAYDIUM_PAGE_RETRY_DELAY_US     1000
 #define MAX_WRITE_PACKET_SIZE   128
 #define MAX_READ_PACKET_SIZE    128
 
@@ -112,6 +115,8 @@
 /* Page 0 ~ Page 9 will be directed to Page 0 */
 #define RAYDIUM_PDA2_PAGE_ADDR              0x0A
 #define RAYDIUM_PDA2_PAGE_0                 0x00
+/* no page known to be selected, see g_u8_pda2_page */
+#define RAYDIUM_PDA2_PAGE_INVALID           0xFF
 /* temporary switch to PDA once */
 #define RAYDIUM_PDA2_ENABLE_PDA             0x0A
 /* permanently switch to PDA mode */
@@ -429,6 +434,9 @@ extern int raydium_i2c_pda2_write(struct i2c_client *client,
 extern int raydium_i2c_pda2_set_page(struct i2c_client *client,
 				     unsigned int is_suspend,
 				     unsigned char u8_page);
+extern int raydium_i2c_pda2_select_page(struct i2c_client *client,
+				     unsigned int is_suspend,
+				     unsigned char u8_page);
 extern int raydium_i2c_write_pda_via_pda2(struct i2c_client *client,
 		unsigned int u32_addr, unsigned char *u8_w_data,
 		unsigned short u16_length);
@@ -459,6 +467,7 @@ extern const struct attribute_group raydium_attr_group;
 extern unsigned char g_u8_raydium_flag;
 extern unsigned char g_u8_addr;
 extern unsigned char g_u8_i2c_mode;
+extern unsigned char g_u8_pda2_page;
 extern unsigned char g_u8_upgrade_type;
 extern unsigned char g_u8_raw_data_type;
 extern unsigned int g_u32_raw_data_len;    /* 128 bytes*/
@@ -492,6 +492,7 @@ unsigned char raydium_stop_mcu_3x(unsigned char u8_is_tp_reset)
 		gpio_set_value(g_raydium_ts->rst_gpio, 1);
 
 		g_u8_i2c_mode = PDA2_MODE;
+		g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 		msleep(35);
 		if (raydium_disable_i2c_deglitch() == ERROR) {
 			LOGD(LOG_ERR, "[touch] disable_i2c_deglitch_3x NG!\r\n");
@@ -832,6 +833,7 @@ static int raydium_fw_upgrade_3X(struct i2c_client *client,
 			goto exit_upgrade;
 
 		g_u8_i2c_mode = PDA2_MODE;
+		g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 
 
 		LOGD(LOG_INFO, "[touch]Burn FW finish!\n");
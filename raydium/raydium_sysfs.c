@@ -201,6 +201,7 @@ static ssize_t raydium_hw_reset_show(struct device *dev,
 	}
 
 	g_u8_i2c_mode = PDA2_MODE;
+	g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 	if (raydium_disable_i2c_deglitch() == ERROR)
 		LOGD(LOG_ERR, "[touch]disable_i2c_deglitch_3x NG!\r\n");
 
@@ -269,6 +270,7 @@ static int raydium_ts_gpio_config(bool on)
 			}
 
 			i32_err = gpio_direction_output(g_raydium_ts->rst_gpio, 1);
+			g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 			if (i32_err) {
 				LOGD(LOG_ERR,
 				     "[touch]set_direction for irq gpio failed\n");
@@ -1426,6 +1428,7 @@ static ssize_t raydium_reset_control_store(struct device *dev,
 		return i32_ret;
 
 	g_u8_i2c_mode = PDA2_MODE;
+	g_u8_pda2_page = RAYDIUM_PDA2_PAGE_INVALID;
 	g_u8_resetflag = true;
 
 	if (u8_high) {
@@ -3939,6 +3939,8 @@ static void fts_controller_ready_event_handler(struct fts_ts_info *info,
 	setSystemResettedUp(1);
 	setSystemResettedDown(1);
 	error = fts_mode_handler(info, 0);
+	/* a spontaneous reset leaves the IC interrupt disabled, re-arm it */
+	error |= fts_enableInterrupt();
 	if (error < OK) {
 		logError(1,
 			"%s %s Cannot restore the device status ERROR %08X\n",
@@ -4166,44 +4168,106 @@ gesture_done:
 /* EventId : 0x05 */
 #define fts_motion_pointer_event_handler fts_enter_pointer_event_handler
 
+/*
+ * Dispatch one event read from the FIFO,
+ * return false once there is no more event
+ */
+static bool fts_dispatch_event(struct fts_ts_info *info, unsigned char *data)
+{
+	struct event_dispatch_handler_t event_handler;
+	unsigned char eventId = data[0];
+
+	if (eventId == EVENTID_NO_EVENT)
+		return false;
+
+	if (eventId < EVENTID_LAST) {
+		event_handler = info->event_dispatch_table[eventId];
+		event_handler.handler(info, (data));
+	}
+
+	return true;
+}
+
+/*
+ * Read FIFO_BURST_EVENTS events per transaction, the events not
+ * available are returned as EVENTID_NO_EVENT by the firmware.
+ * Return the number of events dispatched, or the error if the very
+ * first burst failed.
+ */
+static int fts_read_fifo_burst(struct fts_ts_info *info)
+{
+	int error = 0, count = 0, i;
+	unsigned char regAdd = FIFO_CMD_READALL;
+	unsigned char data[FIFO_EVENT_SIZE * FIFO_BURST_EVENTS] = {0};
+
+	while (count < FIFO_DEPTH) {
+		error = fts_readCmd(&regAdd, sizeof(regAdd), data,
+				sizeof(data));
+		if (error < OK)
+			return count ? count : error;
+
+		for (i = 0; i < FIFO_BURST_EVENTS; i++, count++) {
+			if (!fts_dispatch_event(info,
+					&data[i * FIFO_EVENT_SIZE]))
+				return count;
+		}
+	}
+
+	return count;
+}
+
+/*
+ * Check if the firmware running supports FIFO_CMD_READALL,
+ * the minimum version is given by the device tree
+ */
+static void fts_update_fifo_burst(struct fts_ts_info *info)
+{
+	u32 min_ver = info->bdata->fifo_burst_fw_ver;
+
+	info->fifo_burst = min_ver && ftsInfo.u16_fwVer >= min_ver;
+
+	logError(0, "%s %s: fw ver %x, fifo burst read %s\n", tag, __func__,
+		ftsInfo.u16_fwVer, info->fifo_burst ? "ON" : "OFF");
+}
+
 /*
  * This handler is called each time there is at least
- * one new event in the FIFO
+ * one new event in the FIFO, straight from the threaded IRQ
+ * or from the event work when operating in polling mode
  */
-static void fts_event_handler(struct work_struct *work)
+static void fts_event_handler(struct fts_ts_info *info)
 {
-	struct fts_ts_info *info;
 	int error = 0, count = 0;
 	unsigned char regAdd;
 	unsigned char data[FIFO_EVENT_SIZE] = {0};
-	unsigned char eventId;
-
-	struct event_dispatch_handler_t event_handler;
 
-	info = container_of(work, struct fts_ts_info, work);
 	/*
 	 * read all the FIFO and parsing events
 	 */
 
 	__pm_wakeup_event(info->wakeup_source, HZ);
+
+	if (info->fifo_burst) {
+		error = fts_read_fifo_burst(info);
+		if (error >= OK)
+			goto sync;
+
+		logError(1, "%s %s: burst read failed, fall back! ERROR %08X\n",
+			tag, __func__, error);
+		info->fifo_burst = false;
+	}
+
 	regAdd = FIFO_CMD_READONE;
 
 	for (count = 0; count < FIFO_DEPTH; count++) {
 		error = fts_readCmd(&regAdd, sizeof(regAdd), data,
 				FIFO_EVENT_SIZE);
-		if (error == OK && data[0] != EVENTID_NO_EVENT)
-			eventId = data[0];
-		else
+		if (error != OK || !fts_dispatch_event(info, data))
 			break;
-
-		if (eventId < EVENTID_LAST) {
-			event_handler = info->event_dispatch_table[eventId];
-			event_handler.handler(info, (data));
-		}
 	}
-	input_sync(info->input_dev);
 
-	fts_interrupt_enable(info);
+sync:
+	input_sync(info->input_dev);
 }
 
 static void fts_fw_update_auto(struct work_struct *work)
@@ -4375,6 +4439,17 @@ static int fts_chip_initialization(struct fts_ts_info *info)
 
 #ifdef FTS_USE_POLLING_MODE
 
+static void fts_event_work(struct work_struct *work)
+{
+	struct fts_ts_info *info;
+
+	info = container_of(work, struct fts_ts_info, work);
+
+	fts_event_handler(info);
+
+	fts_interrupt_enable(info);
+}
+
 static enum hrtimer_restart fts_timer_func(struct hrtimer *timer)
 {
 	struct fts_ts_info *info =
@@ -4404,9 +4479,11 @@ static irqreturn_t fts_interrupt_handler(int irq, void *handle)
 	}
 #endif
 #endif
-	disable_irq_nosync(info->client->irq);
-
-	queue_work(info->event_wq, &info->work);
+	/*
+	 * the line stays masked by IRQF_ONESHOT until we return,
+	 * so the FIFO is drained here without bouncing to event_wq
+	 */
+	fts_event_handler(info);
 
 	return IRQ_HANDLED;
 }
@@ -4673,6 +4750,8 @@ static int fts_init_afterProbe(struct fts_ts_info *info)
 {
 	int error = 0;
 
+	fts_update_fifo_burst(info);
+
 	/* system reset */
 	error = cleanUp(0);
 
@@ -5445,6 +5524,11 @@ static int parse_dt(struct device *dev,
 	bdata->x_flip = of_property_read_bool(np, "st,x-flip");
 	bdata->y_flip = of_property_read_bool(np, "st,y-flip");
 
+	/* firmware version from which FIFO_CMD_READALL is supported */
+	if (of_property_read_u32(np, "st,fifo-burst-fw-ver",
+			&bdata->fifo_burst_fw_ver))
+		bdata->fifo_burst_fw_ver = 0;
+
 	return OK;
 }
 
@@ -5672,7 +5756,9 @@ static int fts_probe_internal(struct i2c_client *client,
 		goto ProbeErrorExit_4;
 	}
 
-	INIT_WORK(&info->work, fts_event_handler);
+#ifdef FTS_USE_POLLING_MODE
+	INIT_WORK(&info->work, fts_event_work);
+#endif
 
 	INIT_WORK(&info->resume_work, fts_resume_work);
 	INIT_WORK(&info->suspend_work, fts_suspend_work);
@@ -6076,3 +6162,7 @@ module_exit(fts_driver_exit);
 
 MODULE_DESCRIPTION("STMicroelectronics MultiTouch IC Driver");
 MODULE_LICENSE("GPL v2");
+
+#if IS_ENABLED(CONFIG_TOUCHSCREEN_KUNIT_TEST)
+#include "../touch_kunit/tests/fts_fifo_test.c"
+#endif
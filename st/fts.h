@@ -198,6 +198,7 @@ struct fts_i2c_platform_data {
 	const char *pwr_reg_name;
 	const char *bus_reg_name;
 	bool pwr_on_suspend;
+	u32 fifo_burst_fw_ver;
 };
 
 /*
@@ -244,7 +245,7 @@ struct trusted_touch_vm_info {
  * @dev:                  Pointer to the structure device
  * @client:               I2C client structure
  * @input_dev             Input device structure
- * @work                  Work thread
+ * @work                  Event work, only used in polling mode
  * @event_wq              Event queue for work thread
  * @event_dispatch_table  Event dispatch table handlers
  * @attrs                 SysFS attributes
@@ -344,6 +345,9 @@ struct fts_ts_info {
 	uint8_t *i2c_data;
 	uint8_t i2c_data_len;
 
+	/* read FIFO_BURST_EVENTS events per FIFO_CMD_READALL transaction */
+	bool fifo_burst;
+
 	struct device *aoi_cmd_dev;
 	bool aoi_notify_enabled;
 	bool aoi_wake_on_suspend;
@@ -192,6 +192,7 @@
 #define FIFO_CMD_READALL               0x86
 #define FIFO_CMD_LAST                  0x87
 #define FIFO_CMD_FLUSH                 0xA1
+#define FIFO_BURST_EVENTS              8
 
 
 //CONSTANT TOTAL CX
@@ -52,6 +52,10 @@
 #endif
 #include "../xiaomi/xiaomi_touch.h"
 #include <uapi/linux/sched/types.h>
+#if defined(ENABLE_ISR_LATENCY_STATS)
+#include <linux/jump_label.h>
+#include <linux/math64.h>
+#endif
 
 /**
  * @section: USE_CUSTOM_TOUCH_REPORT_CONFIG
@@ -777,6 +781,291 @@ exit:
 	return retval;
 }
 
+#if defined(ENABLE_ISR_LATENCY_STATS)
+static DEFINE_STATIC_KEY_FALSE(syna_isr_latency_key);
+
+static const char * const isr_latency_stage_str[ISR_STAGE_MAX] = {
+	[ISR_STAGE_WAKEUP] = "wakeup",
+	[ISR_STAGE_READ] = "read",
+	[ISR_STAGE_PARSE] = "parse",
+	[ISR_STAGE_REPORT] = "report",
+	[ISR_STAGE_THP] = "thp",
+	[ISR_STAGE_TOTAL] = "total",
+};
+
+/**
+ * syna_dev_isr_latency_bucket()
+ *
+ * Map a latency to its histogram bucket. Below 8 us every microsecond
+ * has its own bucket, above that each power of two is split into 8.
+ *
+ * @param
+ *    [ in] us: latency in microseconds
+ *
+ * @return
+ *    index of the bucket
+ */
+static unsigned int syna_dev_isr_latency_bucket(unsigned int us)
+{
+	unsigned int shift;
+	unsigned int idx;
+
+	if (us < 8)
+		return us;
+
+	shift = fls(us) - 4;
+	idx = 8 + shift * 8 + ((us >> shift) & 0x7);
+
+	return min_t(unsigned int, idx, ISR_LATENCY_BUCKETS - 1);
+}
+
+/**
+ * syna_dev_isr_latency_bucket_max()
+ *
+ * Get the largest latency being counted in the given bucket.
+ *
+ * @param
+ *    [ in] idx: index of the bucket
+ *
+ * @return
+ *    latency in microseconds
+ */
+static unsigned int syna_dev_isr_latency_bucket_max(unsigned int idx)
+{
+	unsigned int shift;
+
+	if (idx < 8)
+		return idx;
+
+	if (idx == ISR_LATENCY_BUCKETS - 1)
+		return UINT_MAX;
+
+	shift = (idx - 8) / 8;
+
+	return ((9 + (idx - 8) % 8) << shift) - 1;
+}
+
+/**
+ * syna_dev_isr_latency_record()
+ *
+ * Add the stage timestamps of one ISR pass to the histograms.
+ * The stages whose end timestamp is zero are not recorded.
+ *
+ * @param
+ *    [ in] tcm:   the driver handle
+ *    [ in] stamp: timestamps ending each stage, with stamp[ISR_STAGE_MAX]
+ *                 being the start of the threaded handler
+ *
+ * @return
+ *    none.
+ */
+static void syna_dev_isr_latency_record(struct syna_tcm *tcm,
+		ktime_t *stamp)
+{
+	struct syna_isr_latency *latency = &tcm->isr_latency;
+	struct syna_isr_latency_hist *hist;
+	ktime_t start[ISR_STAGE_MAX];
+	unsigned long flags;
+	s64 delta;
+	unsigned int us;
+	int i;
+
+	start[ISR_STAGE_WAKEUP] = latency->hardirq_time;
+	start[ISR_STAGE_READ] = stamp[ISR_STAGE_MAX];
+	start[ISR_STAGE_PARSE] = stamp[ISR_STAGE_READ];
+	start[ISR_STAGE_REPORT] = stamp[ISR_STAGE_PARSE];
+	start[ISR_STAGE_THP] = stamp[ISR_STAGE_READ];
+	start[ISR_STAGE_TOTAL] = latency->hardirq_time;
+
+	spin_lock_irqsave(&latency->lock, flags);
+	for (i = 0; i < ISR_STAGE_MAX; i++) {
+		if (!stamp[i] || !start[i])
+			continue;
+
+		delta = ktime_us_delta(stamp[i], start[i]);
+		us = (delta < 0) ? 0 : (unsigned int)min_t(s64, delta, UINT_MAX);
+
+		hist = &latency->hist[i];
+		if (hist->count == 0 || us < hist->min_us)
+			hist->min_us = us;
+		if (us > hist->max_us)
+			hist->max_us = us;
+		hist->sum_us += us;
+		hist->count++;
+		hist->bucket[syna_dev_isr_latency_bucket(us)]++;
+	}
+	spin_unlock_irqrestore(&latency->lock, flags);
+}
+
+/**
+ * syna_dev_isr_latency_reset()
+ *
+ * Clear the collected ISR latency histograms.
+ *
+ * @param
+ *    [ in] tcm: the driver handle
+ *
+ * @return
+ *    none.
+ */
+void syna_dev_isr_latency_reset(struct syna_tcm *tcm)
+{
+	struct syna_isr_latency *latency = &tcm->isr_latency;
+	unsigned long flags;
+
+	spin_lock_irqsave(&latency->lock, flags);
+	memset(latency->hist, 0x00, sizeof(latency->hist));
+	spin_unlock_irqrestore(&latency->lock, flags);
+}
+
+/**
+ * syna_dev_isr_latency_enable()
+ *
+ * Start or stop collecting the ISR latency.
+ *
+ * @param
+ *    [ in] tcm:    the driver handle
+ *    [ in] enable: true to start; false to stop
+ *
+ * @return
+ *    none.
+ */
+void syna_dev_isr_latency_enable(struct syna_tcm *tcm, bool enable)
+{
+	struct syna_isr_latency *latency = &tcm->isr_latency;
+
+	if (latency->enabled == enable)
+		return;
+
+	latency->hardirq_time = 0;
+	latency->enabled = enable;
+	/* the key is shared, it stays on while any device collects */
+	if (enable)
+		static_branch_inc(&syna_isr_latency_key);
+	else
+		static_branch_dec(&syna_isr_latency_key);
+
+	LOGI("ISR latency stats %s\n", (enable) ? "enabled" : "disabled");
+}
+
+/**
+ * syna_dev_isr_latency_show()
+ *
+ * Print min/avg/p99/max of each ISR stage into the given buffer.
+ * The p99 is the upper bound of the histogram bucket it falls in.
+ *
+ * @param
+ *    [ in] tcm:  the driver handle
+ *    [out] buf:  string buffer
+ *    [ in] size: size of buffer
+ *
+ * @return
+ *    number of characters being output.
+ */
+int syna_dev_isr_latency_show(struct syna_tcm *tcm, char *buf, int size)
+{
+	struct syna_isr_latency *latency = &tcm->isr_latency;
+	struct syna_isr_latency_hist *hist;
+	unsigned long long target;
+	unsigned long long acc;
+	unsigned int p99;
+	unsigned int avg;
+	int count = 0;
+	int i, j;
+
+	hist = kmalloc(sizeof(latency->hist), GFP_KERNEL);
+	if (!hist)
+		return -ENOMEM;
+
+	spin_lock_irq(&latency->lock);
+	memcpy(hist, latency->hist, sizeof(latency->hist));
+	spin_unlock_irq(&latency->lock);
+
+	count += scnprintf(buf + count, size - count,
+			"enabled: %d\n%-8s %10s %8s %8s %8s %8s (us)\n",
+			latency->enabled, "stage", "count",
+			"min", "avg", "p99", "max");
+
+	for (i = 0; i < ISR_STAGE_MAX; i++) {
+		avg = 0;
+		p99 = 0;
+		if (hist[i].count) {
+			avg = (unsigned int)div64_u64(hist[i].sum_us,
+					hist[i].count);
+			target = div64_u64(hist[i].count * 99 + 99, 100);
+			for (j = 0, acc = 0; j < ISR_LATENCY_BUCKETS; j++) {
+				acc += hist[i].bucket[j];
+				if (acc >= target)
+					break;
+			}
+			p99 = min(syna_dev_isr_latency_bucket_max(j),
+					hist[i].max_us);
+		}
+
+		count += scnprintf(buf + count, size - count,
+				"%-8s %10llu %8u %8u %8u %8u\n",
+				isr_latency_stage_str[i], hist[i].count,
+				hist[i].min_us, avg, p99, hist[i].max_us);
+	}
+
+	kfree(hist);
+
+	return count;
+}
+
+/**
+ * syna_dev_hardirq()
+ *
+ * Primary handler of the interrupt. Only take the timestamp of the
+ * hard irq and then wake up the threaded handler.
+ *
+ * @param
+ *    [ in] irq:  interrupt line
+ *    [ in] data: private data being passed to the handler function
+ *
+ * @return
+ *    IRQ_WAKE_THREAD.
+ */
+static irqreturn_t syna_dev_hardirq(int irq, void *data)
+{
+	struct syna_tcm *tcm = data;
+
+	if (static_branch_unlikely(&syna_isr_latency_key))
+		tcm->isr_latency.hardirq_time = ktime_get();
+
+	return IRQ_WAKE_THREAD;
+}
+
+#define syna_dev_isr_stamp(stamp, stage) \
+	do { \
+		if (static_branch_unlikely(&syna_isr_latency_key)) \
+			stamp[stage] = ktime_get(); \
+	} while (0)
+#else
+#define syna_dev_hardirq NULL
+#define syna_dev_isr_stamp(stamp, stage)
+#endif
+
+/**
+ * syna_dev_isr_set_rt()
+ *
+ * Run the irq thread of this device at the highest SCHED_FIFO priority.
+ * Called from the irq thread itself, the first time it runs.
+ *
+ * @param
+ *    [ in] tcm: the driver handle
+ *
+ * @return
+ *    none.
+ */
+static void syna_dev_isr_set_rt(struct syna_tcm *tcm)
+{
+	struct sched_param par = { .sched_priority = MAX_RT_PRIO - 1};
+
+	tcm->isr_task = current;
+	sched_setscheduler_nocheck(current, SCHED_FIFO, &par);
+}
+
 /**
  * syna_dev_isr()
  *
@@ -797,14 +1086,17 @@ static irqreturn_t syna_dev_isr(int irq, void *data)
 	unsigned char code = 0;
 	struct syna_tcm *tcm = data;
 	struct syna_hw_attn_data *attn = &tcm->hw_if->bdata_attn;
-	static struct task_struct *touch_task = NULL;
-	struct sched_param par = { .sched_priority = MAX_RT_PRIO - 1};
 	s64 irq_start_time = ktime_get();
+#if defined(ENABLE_ISR_LATENCY_STATS)
+	/* end of each stage, the last one is the start of this handler */
+	ktime_t stamp[ISR_STAGE_MAX + 1] = { 0 };
 
-	if (touch_task == NULL) {
-		touch_task = current;
-		sched_setscheduler_nocheck(touch_task, SCHED_FIFO, &par);
-	}
+	if (static_branch_unlikely(&syna_isr_latency_key))
+		stamp[ISR_STAGE_MAX] = stamp[ISR_STAGE_WAKEUP] = irq_start_time;
+#endif
+
+	if (unlikely(tcm->isr_task != current))
+		syna_dev_isr_set_rt(tcm);
 	/*cpu_latency_qos_add_request(&tcm->pm_qos_req_irq, 0);*/
 	if (unlikely(gpio_get_value(attn->irq_gpio) != attn->irq_on_state))
 		goto exit;
@@ -818,6 +1110,7 @@ static irqreturn_t syna_dev_isr(int irq, void *data)
 		LOGE("Fail to get event data\n");
 		goto exit;
 	}
+	syna_dev_isr_stamp(stamp, ISR_STAGE_READ);
 #ifdef TOUCH_SENSORHUB_SUPPORT
 	if (xiaomi_get_sensorhub_status(0) != 0) {
 		LOGE("sensorhub enabled,irq may read by sensorhub\n");
@@ -837,8 +1130,11 @@ static irqreturn_t syna_dev_isr(int irq, void *data)
 	}
 #endif
 #ifdef TOUCH_THP_SUPPORT
-	if (tcm->enable_touch_raw && (tcm->pwr_state == PWR_ON) && (code == REPORT_THP))
+	if ((code == REPORT_THP) && (tcm->thp_slot ||
+			(tcm->enable_touch_raw && (tcm->pwr_state == PWR_ON)))) {
 		syna_tcm_report_thp_frame(tcm, irq_start_time);
+		syna_dev_isr_stamp(stamp, ISR_STAGE_THP);
+	}
 #endif
 	/* report input event only when receiving a touch report */
 	if (code == REPORT_TOUCH) {
@@ -851,11 +1147,20 @@ static irqreturn_t syna_dev_isr(int irq, void *data)
 			LOGE("Fail to parse touch report\n");
 			goto exit;
 		}
+		syna_dev_isr_stamp(stamp, ISR_STAGE_PARSE);
 		/* forward the touch event to system */
 		syna_dev_report_input_events(tcm);
+		syna_dev_isr_stamp(stamp, ISR_STAGE_REPORT);
 	}
 
 exit:
+#if defined(ENABLE_ISR_LATENCY_STATS)
+	if (static_branch_unlikely(&syna_isr_latency_key) &&
+		tcm->isr_latency.enabled && stamp[ISR_STAGE_READ]) {
+		stamp[ISR_STAGE_TOTAL] = ktime_get();
+		syna_dev_isr_latency_record(tcm, stamp);
+	}
+#endif
 /*	cpu_latency_qos_remove_request(&tcm->pm_qos_req_irq);*/
 	return IRQ_HANDLED;
 }
@@ -897,14 +1202,14 @@ static int syna_dev_request_irq(struct syna_tcm *tcm)
 #ifdef DEV_MANAGED_API
 	retval = devm_request_threaded_irq(dev,
 			attn->irq_id,
-			NULL,
+			syna_dev_hardirq,
 			syna_dev_isr,
 			attn->irq_flags,
 			"xiaomi_tp" PLATFORM_DRIVER_NAME,
 			tcm);
 #else /* Legacy API */
 	retval = request_threaded_irq(attn->irq_id,
-			NULL,
+			syna_dev_hardirq,
 			syna_dev_isr,
 			attn->irq_flags,
 			"xiaomi_tp" PLATFORM_DRIVER_NAME,
@@ -960,6 +1265,8 @@ static void syna_dev_release_irq(struct syna_tcm *tcm)
 
 	attn->irq_id = 0;
 	attn->irq_enabled = false;
+	/* the next request gets a new irq thread */
+	tcm->isr_task = NULL;
 
 	LOGI("Interrupt handler released\n");
 }
@@ -1910,6 +2217,9 @@ static int syna_dev_probe(struct platform_device *pdev)
 	syna_tcm_buf_init(&tcm->event_data);
 
 	syna_pal_mutex_alloc(&tcm->tp_event_mutex);
+#if defined(ENABLE_ISR_LATENCY_STATS)
+	spin_lock_init(&tcm->isr_latency.lock);
+#endif
 
 #ifdef USE_CUSTOM_TOUCH_REPORT_CONFIG
 	tcm->has_custom_tp_config = true;
@@ -2211,3 +2521,6 @@ MODULE_AUTHOR("Synaptics, Inc.");
 MODULE_DESCRIPTION("Synaptics TCM Touch Driver");
 MODULE_LICENSE("GPL v2");
 
+#if IS_ENABLED(CONFIG_TOUCHSCREEN_KUNIT_TEST)
+#include "../touch_kunit/tests/syna_tcm2_isr_test.c"
+#endif
@@ -273,6 +273,19 @@
 /* #define ENABLE_HELPER */
 #define TOUCH_ID	(0)
 
+/**
+ * @brief ENABLE_ISR_LATENCY_STATS
+ *        Open if willing to collect the time spent in each stage of
+ *        the ISR, from the hard irq to input_sync, and show it through
+ *        sysfs. Collection stays off until it is turned on through the
+ *        sysfs node, and costs a static branch per stage till then.
+ *
+ *        Set "enable" in default
+ */
+#if defined(HAS_SYSFS_INTERFACE)
+#define ENABLE_ISR_LATENCY_STATS
+#endif
+
 /**
  * @brief: Power States
  *
@@ -303,6 +316,85 @@ struct syna_tcm_helper {
 };
 #endif
 
+#if defined(ENABLE_ISR_LATENCY_STATS)
+/**
+ * @brief: Stages of the ISR being timed
+ *
+ * ISR_STAGE_WAKEUP: hard irq to the start of the threaded handler
+ * ISR_STAGE_READ:   handler start to syna_tcm_get_event_data() done
+ * ISR_STAGE_PARSE:  bus read done to syna_tcm_parse_touch_report() done
+ * ISR_STAGE_REPORT: parse done to input_sync()
+ * ISR_STAGE_THP:    bus read done to syna_tcm_report_thp_frame() done
+ * ISR_STAGE_TOTAL:  hard irq to the end of the handler
+ */
+enum isr_latency_stage {
+	ISR_STAGE_WAKEUP = 0,
+	ISR_STAGE_READ,
+	ISR_STAGE_PARSE,
+	ISR_STAGE_REPORT,
+	ISR_STAGE_THP,
+	ISR_STAGE_TOTAL,
+	ISR_STAGE_MAX,
+};
+
+/* 8 linear buckets below 8 us, then 8 buckets per power of two */
+#define ISR_LATENCY_BUCKETS (128)
+
+struct syna_isr_latency_hist {
+	unsigned int min_us;
+	unsigned int max_us;
+	unsigned long long sum_us;
+	unsigned long long count;
+	unsigned int bucket[ISR_LATENCY_BUCKETS];
+};
+
+struct syna_isr_latency {
+	bool enabled;
+	ktime_t hardirq_time;
+	spinlock_t lock;
+	struct syna_isr_latency_hist hist[ISR_STAGE_MAX];
+};
+#endif
+
+#ifdef TOUCH_THP_SUPPORT
+/* distinct sub-commands that can be pending in the MultiFunction queue */
+#define SYNA_MF_QUEUE_SLOTS (8)
+/* largest sub-command, including its code or the 0xC8 packet header */
+#define SYNA_MF_CMD_MAX_SIZE (11)
+/* largest payload of one packed CMD_MultiFunction transaction */
+#define SYNA_MF_PACKET_MAX_SIZE (32)
+
+/**
+ * @brief: sub-command waiting in the MultiFunction queue
+ *
+ * no_resp: data is a raw 0xC8 packet written without waiting for a
+ *          response, otherwise data is packed into CMD_MultiFunction
+ */
+struct syna_mf_cmd {
+	bool pending;
+	bool no_resp;
+	unsigned char size;
+	unsigned char data[SYNA_MF_CMD_MAX_SIZE];
+};
+
+/**
+ * @brief: queue of MultiFunction mode commands
+ *
+ * A newer write to a sub-command still pending replaces the older one,
+ * the pending ones are sent from the work in as few transactions as
+ * possible.
+ */
+struct syna_mf_queue {
+	struct mutex lock;
+	struct mutex flush_lock;
+	struct work_struct work;
+	struct syna_mf_cmd cmd[SYNA_MF_QUEUE_SLOTS];
+	unsigned long long submitted;
+	unsigned long long merged;
+	unsigned long long transactions;
+};
+#endif
+
 /**
  * @brief: context of the synaptics linux-based driver
  *
@@ -328,9 +420,13 @@ struct syna_tcm {
 
 	/* Hardware interface layer */
 	struct syna_hw_interface *hw_if;
+	/* bytes copied through the bus bounce buffers */
+	unsigned long long bus_bytes_copied;
 
 	/* ISR-related variables */
 	pid_t isr_pid;
+	/* irq thread already running as SCHED_FIFO */
+	struct task_struct *isr_task;
 	bool irq_wake;
 
 	/* cdev and sysfs nodes creation */
@@ -376,8 +472,7 @@ struct syna_tcm {
 #endif
 
 	/* fifo to pass the data to userspace */
-	unsigned int fifo_remaining_frame;
-	struct list_head frame_fifo_queue;
+	struct syna_cdev_fifo *frame_fifo;
 	wait_queue_head_t wait_frame;
 	unsigned char report_to_queue[REPORT_TYPES];
 
@@ -479,6 +574,23 @@ struct syna_tcm {
 	unsigned int gesture_type;
 #ifdef TOUCH_THP_SUPPORT
 	bool enable_touch_raw;
+	struct syna_mf_queue mf_queue;
+	/*
+	 * report rate: pinned by userspace, else requested by the HAL, else
+	 * following the panel fps (0 when not set)
+	 */
+	struct mutex report_rate_lock;
+	int report_rate;
+	int report_rate_pinned;
+	int report_rate_requested;
+	int panel_fps;
+	unsigned int report_rate_switches;
+	/* raw data slot the THP report was read into, if any */
+	void *thp_slot;
+	unsigned int thp_slot_length;
+	u64 thp_frames_in_slot;
+	u64 thp_frames_copied;
+	u64 thp_crc_errors;
 #endif
 	/* for factory testing */
 	int (*testing_xiaomi_self_test)(char *buf);
@@ -493,6 +605,9 @@ struct syna_tcm {
 	struct dentry *debugfs;
 #endif
 	struct pm_qos_request pm_qos_req_irq;
+#if defined(ENABLE_ISR_LATENCY_STATS)
+	struct syna_isr_latency isr_latency;
+#endif
 };
 
 /**
@@ -520,6 +635,19 @@ void syna_sysfs_remove_dir(struct syna_tcm *tcm);
 
 #endif
 
+#if defined(ENABLE_ISR_LATENCY_STATS)
+/**
+ * @brief: Helpers for the ISR latency statistics
+ *
+ * These functions are implemented in syna_tcm2.c
+ */
+void syna_dev_isr_latency_enable(struct syna_tcm *tcm, bool enable);
+
+void syna_dev_isr_latency_reset(struct syna_tcm *tcm);
+
+int syna_dev_isr_latency_show(struct syna_tcm *tcm, char *buf, int size);
+#endif
+
 /* add by xiaomi */
 int xiaomi_parse_dt(struct device *dev);
 const char *xiaomi_get_firmware_image_name(void);
@@ -528,6 +656,12 @@ void syna_xiaomi_touch_probe(struct syna_tcm *syna_tcm);
 void syna_xiaomi_touch_remove(struct syna_tcm *syna_tcm);
 int syna_tcm_report_thp_frame(struct syna_tcm *tcm_hcd, s64 irq_start_time);
 int syna_tcm_set_gesture_type(struct syna_tcm *tcm, u8 val);
+#ifdef TOUCH_THP_SUPPORT
+int syna_tcm_mf_queue_show(struct syna_tcm *tcm, char *buf, int size);
+int syna_tcm_report_rate_show(struct syna_tcm *tcm, char *buf, int size);
+void syna_tcm_report_rate_pin(struct syna_tcm *tcm, int value);
+int syna_tcm_thp_frame_show(struct syna_tcm *tcm, char *buf, int size);
+#endif
 int xiaomi_get_super_resolution_factor(void);
 int xiaomi_get_x_resolution(void);
 int xiaomi_get_y_resolution(void);
@@ -36,6 +36,11 @@
  */
 
 #include <linux/string.h>
+#include <linux/kref.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
+#include <linux/sizes.h>
+#include <linux/vmalloc.h>
 
 #include "syna_tcm2.h"
 #include "syna_tcm2_cdev.h"
@@ -51,10 +56,6 @@
 #define USE_COMPAT_IOCTL
 #endif
 
-#if (KERNEL_VERSION(5, 4, 0) <= LINUX_VERSION_CODE)
-#define REPLACE_KTIME
-#endif
-
 
 /* #define ENABLE_PID_TASK */
 
@@ -109,6 +110,11 @@ struct syna_cdev_data {
 	 * is equal to FIFO_QUEUE_MAX_FRAMES.
 	 */
 	unsigned int fifo_depth;
+	/* This is used to define the behavior once the kernel FIFO is full.
+	 * This value can be set via the field of feature.fifo_overflow_policy
+	 * inside struct drv_param.
+	 */
+	unsigned int fifo_overflow_policy;
 	/* In case that the write/read chunk size will be changed at the runtime,
 	 * these variables are used to keep the original values
 	 */
@@ -121,117 +127,474 @@ static struct syna_cdev_data g_cdev_data;
 /* a buffer to record the streaming report
  * considering touch report and another reports may be co-enabled
  * at the same time, give a little buffer here (3 sec x 300 fps)
+ *
+ * the frames are placed back to back in the data area, so a frame of
+ * any size up to FIFO_QUEUE_DATA_SIZE can be queued; the number of
+ * slots must be a power of two and not less than FIFO_QUEUE_MAX_FRAMES
  */
 #define FIFO_QUEUE_MAX_FRAMES		(1200)
+#define FIFO_QUEUE_SLOTS		(2048)
+#define FIFO_QUEUE_DATA_SIZE		(SZ_1M)
 #define SEND_MESSAGE_HEADER_LENGTH	(3)
 
 /* Indicate the interrupt status especially for sysfs using */
 #define SYSFS_DISABLED_INTERRUPT		(0)
 #define SYSFS_ENABLED_INTERRUPT			(1)
 
-/* Define a data structure that contains a list_head */
-struct fifo_queue {
-	struct list_head next;
-	unsigned char *fifo_data;
-	unsigned int data_length;
-#ifdef REPLACE_KTIME
-	struct timespec64 timestamp;
-#else
-	struct timeval timestamp;
-#endif
+/* kernel side of the fifo
+ *
+ * The pages mapped to userspace only carry a copy of the geometry, the
+ * slots and the head/tail counters. Kernel works on the copy kept here
+ * and never trusts the shared pages, except for the tail moved by the
+ * consumer, which is taken only if it stays within the queued frames.
+ *
+ * The fifo is freed once the driver and every mapping have dropped it.
+ */
+struct syna_cdev_fifo {
+	struct kref kref;
+	/* area mapped to userspace */
+	struct frame_ring_info *shared;
+	struct frame_ring_slot *shared_slots;
+	unsigned char *data;
+	/* authoritative copy of the slots */
+	struct frame_ring_slot *slots;
+	unsigned int slot_count;
+	unsigned int data_size;
+	/* free-running counters, changed with queue_mutex held */
+	unsigned int head;
+	unsigned int tail;
+	/* offset in the data area where the next frame is placed */
+	unsigned int data_head;
+	unsigned int dropped_frames;
+	unsigned int oversized_frames;
+	unsigned int irq_stops;
 };
 
+/**
+ * syna_cdev_fifo_slot()
+ *
+ * Return the frame slot at the given position of kernel fifo.
+ *
+ * @param
+ *    [ in] fifo: kernel fifo
+ *    [ in] pos:  free-running head or tail counter
+ *
+ * @return
+ *    pointer to the kernel copy of the frame slot.
+ */
+static inline struct frame_ring_slot *syna_cdev_fifo_slot(
+		struct syna_cdev_fifo *fifo, unsigned int pos)
+{
+	return &fifo->slots[pos & (fifo->slot_count - 1)];
+}
+/**
+ * syna_cdev_fifo_data()
+ *
+ * Return the frame data described by the given slot.
+ *
+ * @param
+ *    [ in] fifo: kernel fifo
+ *    [ in] slot: the kernel copy of the frame slot
+ *
+ * @return
+ *    pointer to the frame data.
+ */
+static inline unsigned char *syna_cdev_fifo_data(
+		struct syna_cdev_fifo *fifo, struct frame_ring_slot *slot)
+{
+	return fifo->data + slot->data_start;
+}
+/**
+ * syna_cdev_fifo_sync_tail()
+ *
+ * Take the tail moved by the consumer through the mapping. A value out
+ * of the range of queued frames is refused and the shared tail is put
+ * back to the kernel one.
+ *
+ * This function shall be called with queue_mutex held.
+ *
+ * @param
+ *    [ in] fifo: kernel fifo
+ *
+ * @return
+ *    the tail counter.
+ */
+static unsigned int syna_cdev_fifo_sync_tail(struct syna_cdev_fifo *fifo)
+{
+	unsigned int tail = READ_ONCE(fifo->shared->tail);
+
+	if (tail - fifo->tail <= fifo->head - fifo->tail)
+		fifo->tail = tail;
+	else
+		cmpxchg(&fifo->shared->tail, tail, fifo->tail);
+
+	return fifo->tail;
+}
+/**
+ * syna_cdev_fifo_frames()
+ *
+ * Return the number of frames queued in kernel fifo.
+ *
+ * @param
+ *    [ in] tcm: the driver handle
+ *
+ * @return
+ *    number of queued frames.
+ */
+static unsigned int syna_cdev_fifo_frames(struct syna_tcm *tcm)
+{
+	struct syna_cdev_fifo *fifo = tcm->frame_fifo;
+	unsigned int head;
+	unsigned int tail;
+	unsigned int ktail;
+
+	if (!fifo)
+		return 0;
+
+	head = smp_load_acquire(&fifo->head);
+	ktail = READ_ONCE(fifo->tail);
+	tail = READ_ONCE(fifo->shared->tail);
+	if (tail - ktail > head - ktail)
+		tail = ktail;
+
+	return head - tail;
+}
+/**
+ * syna_cdev_fifo_capacity()
+ *
+ * Return the number of frames allowed to be queued in kernel fifo.
+ *
+ * @return
+ *    capacity of kernel fifo.
+ */
+static unsigned int syna_cdev_fifo_capacity(void)
+{
+	if (g_cdev_data.fifo_depth != 0)
+		return g_cdev_data.fifo_depth;
+
+	return FIFO_QUEUE_MAX_FRAMES;
+}
+/**
+ * syna_cdev_fifo_stop_irq()
+ *
+ * Check whether the irq shall be stopped once kernel fifo is full.
+ *
+ * @return
+ *    true if irq shall be stopped; otherwise, the oldest frame is dropped.
+ */
+static bool syna_cdev_fifo_stop_irq(void)
+{
+	switch (g_cdev_data.fifo_overflow_policy) {
+	case FIFO_OVERFLOW_STOP_IRQ:
+		return true;
+	case FIFO_OVERFLOW_DROP:
+		return false;
+	default:
+		return (g_cdev_data.fifo_depth != 0);
+	}
+}
+/**
+ * syna_cdev_fifo_publish_info()
+ *
+ * Copy the policy in effect and the counters of kernel fifo to the
+ * mapped info page.
+ *
+ * @param
+ *    [ in] tcm: the driver handle
+ *
+ * @return
+ *    none.
+ */
+static void syna_cdev_fifo_publish_info(struct syna_tcm *tcm)
+{
+	struct syna_cdev_fifo *fifo = tcm->frame_fifo;
+	struct frame_ring_info *shared;
+
+	if (!fifo)
+		return;
+
+	shared = fifo->shared;
+	WRITE_ONCE(shared->overflow_policy, (syna_cdev_fifo_stop_irq()) ?
+		FIFO_OVERFLOW_STOP_IRQ : FIFO_OVERFLOW_DROP);
+	WRITE_ONCE(shared->dropped_frames, fifo->dropped_frames);
+	WRITE_ONCE(shared->oversized_frames, fifo->oversized_frames);
+	WRITE_ONCE(shared->irq_stops, fifo->irq_stops);
+}
+/**
+ * syna_cdev_fifo_resume_irq()
+ *
+ * Re-activate the irq stopped by a full kernel fifo once there is room
+ * again. Frames consumed through the mapping are seen here, so either
+ * IOCTL_STD_GET_FRAME or IOCTL_STD_CHECK_FRAMES brings the irq back.
+ *
+ * This function shall be called with queue_mutex held.
+ *
+ * @param
+ *    [ in] tcm: the driver handle
+ *
+ * @return
+ *    none.
+ */
+static void syna_cdev_fifo_resume_irq(struct syna_tcm *tcm)
+{
+	struct syna_cdev_fifo *fifo = tcm->frame_fifo;
+
+	if (!fifo || !syna_cdev_fifo_stop_irq())
+		return;
+
+	syna_cdev_fifo_sync_tail(fifo);
+	if (fifo->head - fifo->tail >= syna_cdev_fifo_capacity())
+		return;
+
+	if (!tcm->hw_if->bdata_attn.irq_enabled) {
+		if (tcm->hw_if->ops_enable_irq)
+			tcm->hw_if->ops_enable_irq(tcm->hw_if, true);
+	}
+}
+/**
+ * syna_cdev_fifo_release()
+ *
+ * Free kernel fifo once the last reference is dropped.
+ *
+ * @param
+ *    [ in] kref: reference of kernel fifo
+ *
+ * @return
+ *    none.
+ */
+static void syna_cdev_fifo_release(struct kref *kref)
+{
+	struct syna_cdev_fifo *fifo =
+		container_of(kref, struct syna_cdev_fifo, kref);
+
+	vfree(fifo->shared);
+	kfree(fifo->slots);
+	kfree(fifo);
+}
 
 #ifdef ENABLE_EXTERNAL_FRAME_PROCESS
+/**
+ * syna_cdev_alloc_fifo()
+ *
+ * Allocate the kernel fifo, a ring of frame slots and the data area
+ * holding the frames, which can be mapped to userspace.
+ *
+ * @param
+ *    [ in] tcm:      the driver handle
+ *
+ * @return
+ *    on success, 0; otherwise, negative value on error.
+ */
+static int syna_cdev_alloc_fifo(struct syna_tcm *tcm)
+{
+	struct syna_cdev_fifo *fifo;
+	struct frame_ring_info *shared;
+	unsigned int slots_size;
+
+	BUILD_BUG_ON(!is_power_of_2(FIFO_QUEUE_SLOTS));
+	BUILD_BUG_ON(FIFO_QUEUE_SLOTS < FIFO_QUEUE_MAX_FRAMES);
+	BUILD_BUG_ON(sizeof(struct frame_ring_info) > PAGE_SIZE);
+
+	fifo = kzalloc(sizeof(*fifo), GFP_KERNEL);
+	if (!fifo) {
+		LOGE("Fail to allocate kernel fifo\n");
+		return -ENOMEM;
+	}
+
+	fifo->slots = kcalloc(FIFO_QUEUE_SLOTS, sizeof(*fifo->slots),
+			GFP_KERNEL);
+	if (!fifo->slots) {
+		LOGE("Fail to allocate the slots of kernel fifo\n");
+		kfree(fifo);
+		return -ENOMEM;
+	}
+
+	slots_size = PAGE_ALIGN(FIFO_QUEUE_SLOTS *
+			sizeof(struct frame_ring_slot));
+
+	shared = vmalloc_user(PAGE_SIZE + slots_size + FIFO_QUEUE_DATA_SIZE);
+	if (!shared) {
+		LOGE("Fail to allocate the mapped area of kernel fifo\n");
+		kfree(fifo->slots);
+		kfree(fifo);
+		return -ENOMEM;
+	}
+
+	shared->slot_count = FIFO_QUEUE_SLOTS;
+	shared->slot_offset = PAGE_SIZE;
+	shared->data_offset = PAGE_SIZE + slots_size;
+	shared->data_size = FIFO_QUEUE_DATA_SIZE;
+
+	kref_init(&fifo->kref);
+	fifo->shared = shared;
+	fifo->shared_slots = (struct frame_ring_slot *)
+			((unsigned char *)shared + PAGE_SIZE);
+	fifo->data = (unsigned char *)shared + PAGE_SIZE + slots_size;
+	fifo->slot_count = FIFO_QUEUE_SLOTS;
+	fifo->data_size = FIFO_QUEUE_DATA_SIZE;
+
+	tcm->frame_fifo = fifo;
+	syna_cdev_fifo_publish_info(tcm);
+
+	return 0;
+}
+/**
+ * syna_cdev_fifo_find_space()
+ *
+ * Find the room for a frame in the data area of kernel fifo.
+ *
+ * The queued frames take a contiguous, possibly wrapped, range from
+ * the data of the oldest frame to data_head. A frame is never split;
+ * if it does not fit at the end, it starts over from offset 0.
+ *
+ * @param
+ *    [ in] fifo:     kernel fifo
+ *    [ in] length:   data length
+ *    [out] start:    offset of the frame in the data area
+ *
+ * @return
+ *    true if the frame fits; otherwise, false.
+ */
+static bool syna_cdev_fifo_find_space(struct syna_cdev_fifo *fifo,
+		unsigned int length, unsigned int *start)
+{
+	unsigned int wr = fifo->data_head;
+	unsigned int rd;
+
+	if (fifo->head == fifo->tail) {
+		*start = 0;
+		return true;
+	}
+
+	rd = syna_cdev_fifo_slot(fifo, fifo->tail)->data_start;
+	if (rd < wr) {
+		if (wr + length <= fifo->data_size) {
+			*start = wr;
+			return true;
+		}
+		if (length <= rd) {
+			*start = 0;
+			return true;
+		}
+		return false;
+	}
+
+	if (wr + length <= rd) {
+		*start = wr;
+		return true;
+	}
+
+	return false;
+}
 /**
  * syna_cdev_insert_fifo()
  *
- * Insert/Push the data to the queue.
+ * Reserve a frame slot and the room of its data to push the data to
+ * the queue.
  *
- * This function is called by syna_cdev_update_report_queue(),
- * where the event data will be placed as the below format in byte
- * and use this function to store the data in queue.
- *     [0        ] : status / report code
- *     [1 :   2  ] : length of data frame
- *     [3 : N + 3] : N bytes of data payload
+ * This function is called by syna_cdev_update_report_queue() with
+ * queue_mutex held. Once the frame is filled in the returned slot,
+ * syna_cdev_commit_fifo() shall be called to publish it.
+ *
+ * If kernel fifo is full, either in frames or in data, the oldest
+ * frames are dropped or the current one is, depending on the overflow
+ * policy.
  *
  * @param
  *    [ in] tcm:      the driver handle
- *    [ in] buf_ptr:  points to a data going to push
  *    [ in] length:   data length
  *
  * @return
- *    on success, 0; otherwise, negative value on error.
+ *    pointer to the kernel copy of the frame slot; NULL if no slot is
+ *    available.
  */
-static int syna_cdev_insert_fifo(struct syna_tcm *tcm,
-		unsigned char *buf_ptr, unsigned int length)
+static struct frame_ring_slot *syna_cdev_insert_fifo(struct syna_tcm *tcm,
+		unsigned int length)
 {
-	int retval = 0;
-	struct fifo_queue *pfifo_data;
-	struct fifo_queue *pfifo_data_temp;
-	static int pre_remaining_frames = -1;
-
-	syna_pal_mutex_lock(&g_cdev_data.queue_mutex);
+	struct syna_cdev_fifo *fifo = tcm->frame_fifo;
+	struct frame_ring_slot *slot;
+	unsigned int tail;
+	unsigned int start;
+
+	if (length > fifo->data_size) {
+		fifo->oversized_frames++;
+		syna_cdev_fifo_publish_info(tcm);
+		LOGE("Frame size %d exceeds the fifo size %d\n",
+			length, fifo->data_size);
+		return NULL;
+	}
 
 	/* check queue buffer limit */
-	if (tcm->fifo_remaining_frame >= FIFO_QUEUE_MAX_FRAMES) {
-		if (tcm->fifo_remaining_frame != pre_remaining_frames)
-			LOGI("FIFO is full drop the first frame\n");
-
-		pfifo_data_temp = list_first_entry(&tcm->frame_fifo_queue,
-						struct fifo_queue, next);
-
-		list_del(&pfifo_data_temp->next);
-		kfree(pfifo_data_temp->fifo_data);
-		kfree(pfifo_data_temp);
-		pre_remaining_frames = tcm->fifo_remaining_frame;
-		tcm->fifo_remaining_frame--;
-	} else if (pre_remaining_frames >= FIFO_QUEUE_MAX_FRAMES) {
-		LOGI("FIFO is still full\n");
-		pre_remaining_frames = tcm->fifo_remaining_frame;
-	}
-
-	pfifo_data = kmalloc(sizeof(*pfifo_data), GFP_KERNEL);
-	if (!(pfifo_data)) {
-		LOGE("Failed to allocate memory\n");
-		LOGE("Allocation size = %zu\n", (sizeof(*pfifo_data)));
-		retval = -ENOMEM;
-		goto exit;
-	}
+	for (;;) {
+		tail = syna_cdev_fifo_sync_tail(fifo);
+		if ((fifo->head - tail < syna_cdev_fifo_capacity()) &&
+			syna_cdev_fifo_find_space(fifo, length, &start))
+			break;
 
-	pfifo_data->fifo_data = kmalloc(length, GFP_KERNEL);
-	if (!(pfifo_data->fifo_data)) {
-		LOGE("Failed to allocate memory, size = %d\n", length);
-		retval = -ENOMEM;
-		goto exit;
+		if (syna_cdev_fifo_stop_irq()) {
+			fifo->dropped_frames++;
+			syna_cdev_fifo_publish_info(tcm);
+			LOGD("FIFO is full drop the current frame\n");
+			return NULL;
+		}
+
+		LOGD("FIFO is full drop the first frame\n");
+		/* the consumer may move tail concurrently, resync if so */
+		if (cmpxchg(&fifo->shared->tail, tail, tail + 1) == tail) {
+			fifo->tail = tail + 1;
+			fifo->dropped_frames++;
+		}
 	}
+	syna_cdev_fifo_publish_info(tcm);
 
-	pfifo_data->data_length = length;
+	slot = syna_cdev_fifo_slot(fifo, fifo->head);
+	slot->data_start = start;
+
+	return slot;
+}
+/**
+ * syna_cdev_commit_fifo()
+ *
+ * Publish the frame filled in the slot reserved by syna_cdev_insert_fifo().
+ *
+ * @param
+ *    [ in] tcm:      the driver handle
+ *    [ in] slot:     the frame slot being filled
+ *    [ in] length:   data length
+ *
+ * @return
+ *    none.
+ */
+static void syna_cdev_commit_fifo(struct syna_tcm *tcm,
+		struct frame_ring_slot *slot, unsigned int length)
+{
+	struct syna_cdev_fifo *fifo = tcm->frame_fifo;
+	unsigned int head = fifo->head;
+	struct timespec64 ts;
+
+	ktime_get_real_ts64(&ts);
+	slot->data_length = length;
+	slot->tv_sec = ts.tv_sec;
+	slot->tv_nsec = ts.tv_nsec;
+	fifo->data_head = slot->data_start + length;
+
+	fifo->shared_slots[head & (fifo->slot_count - 1)] = *slot;
 
-	memcpy((void *)pfifo_data->fifo_data, (void *)buf_ptr, length);
-#ifdef REPLACE_KTIME
-	ktime_get_real_ts64(&(pfifo_data->timestamp));
-#else
-	do_gettimeofday(&(pfifo_data->timestamp));
-#endif
 	/* append the data to the tail for FIFO queueing */
-	list_add_tail(&pfifo_data->next, &tcm->frame_fifo_queue);
-	tcm->fifo_remaining_frame++;
-	retval = 0;
+	smp_store_release(&fifo->head, head + 1);
+	smp_store_release(&fifo->shared->head, head + 1);
 
-	LOGD("Frames %d queued in FIFO\n", tcm->fifo_remaining_frame);
+	LOGD("Frames %d queued in FIFO\n", syna_cdev_fifo_frames(tcm));
 
 	/* once reaching the queue size, stop to queue data in FIFO */
-	if (g_cdev_data.fifo_depth != 0) {
-		if (tcm->fifo_remaining_frame >= g_cdev_data.fifo_depth) {
-			if (tcm->hw_if->ops_enable_irq)
-				tcm->hw_if->ops_enable_irq(tcm->hw_if, false);
+	if (syna_cdev_fifo_stop_irq() &&
+		(fifo->head - fifo->tail >= syna_cdev_fifo_capacity())) {
+		if (tcm->hw_if->ops_enable_irq) {
+			fifo->irq_stops++;
+			syna_cdev_fifo_publish_info(tcm);
+			tcm->hw_if->ops_enable_irq(tcm->hw_if, false);
 		}
 	}
-
-exit:
-	syna_pal_mutex_unlock(&g_cdev_data.queue_mutex);
-	return retval;
 }
 #endif
 /**
@@ -449,10 +812,15 @@ static int syna_cdev_ioctl_check_frame(struct syna_tcm *tcm,
 	timeout = syna_pal_le4_to_uint(&data[0]);
 	LOGD("Time out: %d\n", timeout);
 
-	if (list_empty(&tcm->frame_fifo_queue)) {
+	/* frames consumed through the mapping may leave room again */
+	syna_pal_mutex_lock(&g_cdev_data.queue_mutex);
+	syna_cdev_fifo_resume_irq(tcm);
+	syna_pal_mutex_unlock(&g_cdev_data.queue_mutex);
+
+	if (syna_cdev_fifo_frames(tcm) == 0) {
 		LOGD("The queue is empty, wait for the frames\n");
 		result = wait_event_interruptible_timeout(tcm->wait_frame,
-				(tcm->fifo_remaining_frame > 0),
+				(syna_cdev_fifo_frames(tcm) > 0),
 				msecs_to_jiffies(timeout));
 		if (result == 0) {
 			LOGD("Queue waiting timed out after %dms\n", timeout);
@@ -466,7 +834,7 @@ static int syna_cdev_ioctl_check_frame(struct syna_tcm *tcm,
 
 exit:
 	if (retval > 0) {
-		frames = tcm->fifo_remaining_frame;
+		frames = syna_cdev_fifo_frames(tcm);
 		data[0] = (unsigned char)(frames & 0xff);
 		data[1] = (unsigned char)((frames >> 8) & 0xff);
 		data[2] = (unsigned char)((frames >> 16) & 0xff);
@@ -497,20 +865,17 @@ exit:
  */
 static void syna_cdev_clean_queue(struct syna_tcm *tcm)
 {
-	struct fifo_queue *pfifo_data;
-	unsigned int frames_to_del = tcm->fifo_remaining_frame;
+	struct syna_cdev_fifo *fifo = tcm->frame_fifo;
+	unsigned int frames_to_del;
+
+	if (!fifo)
+		return;
 
 	syna_pal_mutex_lock(&g_cdev_data.queue_mutex);
 
-	while (!list_empty(&tcm->frame_fifo_queue)) {
-		pfifo_data = list_first_entry(&tcm->frame_fifo_queue,
-				struct fifo_queue, next);
-		list_del(&pfifo_data->next);
-		kfree(pfifo_data->fifo_data);
-		kfree(pfifo_data);
-		if (tcm->fifo_remaining_frame != 0)
-			tcm->fifo_remaining_frame--;
-	}
+	frames_to_del = syna_cdev_fifo_frames(tcm);
+	fifo->tail = fifo->head;
+	WRITE_ONCE(fifo->shared->tail, fifo->head);
 
 	LOGD("Kernel fifo cleaned, %d frames removed\n", frames_to_del);
 
@@ -543,7 +908,10 @@ static int syna_cdev_ioctl_get_frame(struct syna_tcm *tcm,
 	int retval = 0;
 	int timeout = 0;
 	unsigned char timeout_data[4] = {0};
-	struct fifo_queue *pfifo_data;
+	struct syna_cdev_fifo *fifo;
+	struct frame_ring_slot *pslot;
+	unsigned char *pdata;
+	unsigned int tail;
 
 	if (!tcm->is_connected) {
 		LOGE("Not connected\n");
@@ -578,10 +946,10 @@ static int syna_cdev_ioctl_get_frame(struct syna_tcm *tcm,
 	LOGD("Wait time: %dms\n", timeout);
 
 	/* wait for the available frame if fifo is empty */
-	if (list_empty(&tcm->frame_fifo_queue)) {
+	if (syna_cdev_fifo_frames(tcm) == 0) {
 		LOGD("The queue is empty, wait for the frame\n");
 		retval = wait_event_interruptible_timeout(tcm->wait_frame,
-				(tcm->fifo_remaining_frame > 0),
+				(syna_cdev_fifo_frames(tcm) > 0),
 				msecs_to_jiffies(timeout));
 		if (retval == 0) {
 			LOGD("Queue waiting timed out after %dms\n", timeout);
@@ -591,69 +959,64 @@ static int syna_cdev_ioctl_get_frame(struct syna_tcm *tcm,
 		}
 	}
 
+	/* start to pop up a frame from fifo */
+	syna_pal_mutex_lock(&g_cdev_data.queue_mutex);
+
     /* confirm the queue is not empty */
-	if (list_empty(&tcm->frame_fifo_queue)) {
+	if (syna_cdev_fifo_frames(tcm) == 0) {
 		LOGD("Is queue empty? The remaining frame = %d\n",
-			tcm->fifo_remaining_frame);
+			syna_cdev_fifo_frames(tcm));
 		retval = -ENODATA;
-		goto exit;
+		goto exit_unlock;
 	}
 
-	/* start to pop up a frame from fifo */
-	syna_pal_mutex_lock(&g_cdev_data.queue_mutex);
-
-	pfifo_data = list_first_entry(&tcm->frame_fifo_queue,
-			struct fifo_queue, next);
+	fifo = tcm->frame_fifo;
+	tail = syna_cdev_fifo_sync_tail(fifo);
+	pslot = syna_cdev_fifo_slot(fifo, tail);
+	pdata = syna_cdev_fifo_data(fifo, pslot);
 
 	LOGD("Popping data from the queue, data size:%d\n",
-		pfifo_data->data_length);
+		pslot->data_length);
 
-	if (buf_size >= pfifo_data->data_length) {
+	if (buf_size >= pslot->data_length) {
 		retval = copy_to_user((void *)ubuf_ptr,
-				pfifo_data->fifo_data,
-				pfifo_data->data_length);
+				pdata,
+				pslot->data_length);
 		if (retval) {
 			LOGE("Fail to copy data to user space, size:%d\n",
 				retval);
 			retval = -EBADE;
 		}
 
-		*frame_size = pfifo_data->data_length;
+		*frame_size = pslot->data_length;
 
 	} else {
 		LOGE("No enough space for data copy, buf_size:%d data:%d\n",
-			buf_size, pfifo_data->data_length);
+			buf_size, pslot->data_length);
 
 		retval = -EOVERFLOW;
-		goto exit;
+		goto exit_unlock;
 	}
 
 	LOGD("Data popped: 0x%02x, 0x%02x, 0x%02x ...\n",
-		pfifo_data->fifo_data[0], pfifo_data->fifo_data[1],
-		pfifo_data->fifo_data[2]);
-
-	list_del(&pfifo_data->next);
+		pdata[0], pdata[1], pdata[2]);
 
 	if (retval >= 0)
-		retval = pfifo_data->data_length;
+		retval = pslot->data_length;
 
-	kfree(pfifo_data->fifo_data);
-	kfree(pfifo_data);
-	if (tcm->fifo_remaining_frame != 0)
-		tcm->fifo_remaining_frame--;
+	/* the frame may be consumed through mmap in the meantime */
+	if (cmpxchg(&fifo->shared->tail, tail, tail + 1) == tail)
+		fifo->tail = tail + 1;
+	else
+		syna_cdev_fifo_sync_tail(fifo);
 
 	/* re-activate kernel FIFO if it was full */
-	if (tcm->fifo_remaining_frame < g_cdev_data.fifo_depth) {
-		if (!tcm->hw_if->bdata_attn.irq_enabled) {
-			if (tcm->hw_if->ops_enable_irq)
-				tcm->hw_if->ops_enable_irq(tcm->hw_if, true);
-		}
-	}
+	syna_cdev_fifo_resume_irq(tcm);
 
-	LOGD("Frames %d remaining in FIFO\n", tcm->fifo_remaining_frame);
+	LOGD("Frames %d remaining in FIFO\n", syna_cdev_fifo_frames(tcm));
 
+exit_unlock:
 	syna_pal_mutex_unlock(&g_cdev_data.queue_mutex);
-
 exit:
 	return retval;
 }
@@ -1315,6 +1678,8 @@ static int syna_cdev_ioctl_get_config_params(struct syna_tcm *tcm,
 	param->feature.predict_reads = (tcm->tcm_dev->msg_data.predict_reads & 0x01);
 	param->feature.extra_bytes_to_read = (unsigned char)g_cdev_data.extra_bytes;
 	param->feature.depth_of_fifo = (g_cdev_data.fifo_depth >> 2);
+	param->feature.fifo_overflow_policy =
+		(unsigned char)g_cdev_data.fifo_overflow_policy;
 
 	/* copy the info to user-space */
 	retval = copy_to_user((void *)ubuf_ptr,
@@ -1432,6 +1797,15 @@ static int syna_cdev_ioctl_set_config(struct syna_tcm *tcm,
 			g_cdev_data.fifo_depth = 0;
 		if (g_cdev_data.fifo_depth != 0)
 			LOGI("request to adjust kernel fifo size to %d\n", g_cdev_data.fifo_depth);
+		/* change the overflow policy of kernel fifo */
+		if (g_cdev_data.fifo_overflow_policy !=
+			param->feature.fifo_overflow_policy) {
+			g_cdev_data.fifo_overflow_policy =
+				param->feature.fifo_overflow_policy;
+			LOGI("request to %s once kernel fifo is full\n",
+				(syna_cdev_fifo_stop_irq()) ? "stop irq" : "drop frames");
+		}
+		syna_cdev_fifo_publish_info(tcm);
 
 	}
 
@@ -1857,6 +2231,7 @@ static int syna_cdev_open(struct inode *inp, struct file *filp)
 
 	g_cdev_data.io_polling_interval = 0;
 	g_cdev_data.fifo_depth = 0;
+	g_cdev_data.fifo_overflow_policy = FIFO_OVERFLOW_DEFAULT;
 	g_cdev_data.extra_bytes = 0;
 
 	g_cdev_data.origin_max_rd_size = tcm->tcm_dev->max_rd_size;
@@ -1868,6 +2243,7 @@ static int syna_cdev_open(struct inode *inp, struct file *filp)
 #ifdef ENABLE_EXTERNAL_FRAME_PROCESS
 	syna_cdev_clean_queue(tcm);
 #endif
+	syna_cdev_fifo_publish_info(tcm);
 	syna_pal_mutex_unlock(&g_cdev_data.mutex);
 
 	LOGI("CDevice open\n");
@@ -1908,7 +2284,9 @@ static int syna_cdev_release(struct inode *inp, struct file *filp)
 
 	g_cdev_data.io_polling_interval = 0;
 	g_cdev_data.fifo_depth = 0;
+	g_cdev_data.fifo_overflow_policy = FIFO_OVERFLOW_DEFAULT;
 	g_cdev_data.extra_bytes = 0;
+	syna_cdev_fifo_publish_info(tcm);
 
 	LOGI("CDevice close\n");
 
@@ -1921,6 +2299,94 @@ static int syna_cdev_release(struct inode *inp, struct file *filp)
 	return 0;
 }
 
+/**
+ * syna_cdev_vm_open()
+ *
+ * Take a reference of kernel fifo for a copy of the mapping.
+ *
+ * @param
+ *    [ in] vma:  virtual memory area mapping kernel fifo
+ *
+ * @return
+ *    none.
+ */
+static void syna_cdev_vm_open(struct vm_area_struct *vma)
+{
+	struct syna_cdev_fifo *fifo = vma->vm_private_data;
+
+	kref_get(&fifo->kref);
+}
+/**
+ * syna_cdev_vm_close()
+ *
+ * Drop the reference of kernel fifo held by the mapping.
+ *
+ * @param
+ *    [ in] vma:  virtual memory area mapping kernel fifo
+ *
+ * @return
+ *    none.
+ */
+static void syna_cdev_vm_close(struct vm_area_struct *vma)
+{
+	struct syna_cdev_fifo *fifo = vma->vm_private_data;
+
+	kref_put(&fifo->kref, syna_cdev_fifo_release);
+}
+
+static const struct vm_operations_struct syna_cdev_vm_ops = {
+	.open = syna_cdev_vm_open,
+	.close = syna_cdev_vm_close,
+};
+
+/**
+ * syna_cdev_mmap()
+ *
+ * Map the kernel fifo to userspace, so the frames can be consumed
+ * without the copy through IOCTL_STD_GET_FRAME.
+ *
+ * @param
+ *    [ in] filp: represents the file descriptor
+ *    [ in] vma:  virtual memory area to map
+ *
+ * @return
+ *    on success, 0; otherwise, negative value on error.
+ */
+static int syna_cdev_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct syna_tcm *tcm = platform_get_drvdata(g_cdev_data.dev);
+	struct syna_cdev_fifo *fifo;
+	int retval;
+
+	if (vma->vm_pgoff != 0) {
+		LOGE("Invalid offset of mapping, %lu\n", vma->vm_pgoff);
+		return -EINVAL;
+	}
+
+	syna_pal_mutex_lock(&g_cdev_data.mutex);
+
+	fifo = tcm->frame_fifo;
+	if (!fifo) {
+		LOGE("Kernel fifo is not available\n");
+		retval = -ENODEV;
+		goto exit;
+	}
+
+	retval = remap_vmalloc_range(vma, fifo->shared, 0);
+	if (retval < 0)
+		goto exit;
+
+	/* the fifo stays until the last mapping is gone */
+	kref_get(&fifo->kref);
+	vma->vm_private_data = fifo;
+	vma->vm_ops = &syna_cdev_vm_ops;
+
+exit:
+	syna_pal_mutex_unlock(&g_cdev_data.mutex);
+
+	return retval;
+}
+
 /**
  * Declare the operations of TouchCom device file
  */
@@ -1937,6 +2403,7 @@ static const struct file_operations device_fops = {
 	.llseek = syna_cdev_llseek,
 	.read = syna_cdev_read,
 	.write = syna_cdev_write,
+	.mmap = syna_cdev_mmap,
 	.open = syna_cdev_open,
 	.release = syna_cdev_release,
 };
@@ -1971,11 +2438,10 @@ void syna_cdev_update_report_queue(struct syna_tcm *tcm,
 {
 	int retval;
 	struct tcm_dev *tcm_dev = tcm->tcm_dev;
+	struct frame_ring_slot *pslot;
 	unsigned char *frame_buffer = NULL;
 	unsigned int size = 0;
 	unsigned short val;
-	unsigned char *extrabytes = NULL;
-	unsigned char *extraptr = NULL;
 	int offset;
 	const int header_size = 3;
 
@@ -1984,6 +2450,11 @@ void syna_cdev_update_report_queue(struct syna_tcm *tcm,
 		return;
 	}
 
+	if (!tcm->frame_fifo) {
+		LOGE("Kernel fifo is not available\n");
+		return;
+	}
+
 	size = pevent_data->data_length + header_size;
 	if (g_cdev_data.extra_bytes > 0)
 		size += g_cdev_data.extra_bytes;
@@ -1991,27 +2462,17 @@ void syna_cdev_update_report_queue(struct syna_tcm *tcm,
 	LOGD("Pushing data size:%d, total:%d\n",
 		pevent_data->data_length, size);
 
-	frame_buffer = (unsigned char *)syna_pal_mem_alloc(size,
-					sizeof(unsigned char));
-	if (!frame_buffer) {
-		LOGE("Fail to allocate buffer, size: %d, data_length: %d\n",
-			size, pevent_data->data_length);
-		return;
-	}
-
-	if (g_cdev_data.extra_bytes > 0) {
-		extrabytes = (unsigned char *)syna_pal_mem_alloc(
-					g_cdev_data.extra_bytes,
-					sizeof(unsigned char));
-		if (!extrabytes) {
-			syna_pal_mem_free((void *)frame_buffer);
+	syna_pal_mutex_lock(&g_cdev_data.queue_mutex);
 
-			LOGE("Fail to allocate extra buffer, size: %d\n",
-				g_cdev_data.extra_bytes);
-			return;
-		}
+	/* fill the frame in the slot of kernel fifo directly */
+	pslot = syna_cdev_insert_fifo(tcm, size);
+	if (!pslot) {
+		LOGD("Fail to push data to fifo\n");
+		goto exit;
 	}
 
+	frame_buffer = syna_cdev_fifo_data(tcm->frame_fifo, pslot);
+
 	frame_buffer[0] = code;
 	frame_buffer[1] = (unsigned char)pevent_data->data_length;
 	frame_buffer[2] = (unsigned char)(pevent_data->data_length >> 8);
@@ -2029,42 +2490,38 @@ void syna_cdev_update_report_queue(struct syna_tcm *tcm,
 		}
 	}
 
+	if (g_cdev_data.extra_bytes > 0) {
+		offset = pevent_data->data_length + header_size;
+		syna_pal_mem_set(&frame_buffer[offset], 0x00,
+				g_cdev_data.extra_bytes);
+	}
+
 	if (g_cdev_data.extra_bytes >= TCM_MSG_CRC_LENGTH) {
+		offset = pevent_data->data_length + header_size;
+
 		val = tcm_dev->msg_data.crc_bytes;
-		extrabytes[0] = (unsigned char)val;
-		extrabytes[1] = (unsigned char)(val >> 8);
+		frame_buffer[offset] = (unsigned char)val;
+		frame_buffer[offset + 1] = (unsigned char)(val >> 8);
 
 		val = g_cdev_data.extra_bytes - TCM_MSG_CRC_LENGTH;
 		if (val >= TCM_EXTRA_RC_LENGTH)
-			extrabytes[TCM_MSG_CRC_LENGTH] = tcm_dev->msg_data.rc_byte;
-
-		offset = pevent_data->data_length + header_size;
-		extraptr = &frame_buffer[offset];
-		retval = syna_pal_mem_cpy(extraptr,
-				(size - offset),
-				extrabytes,
-				g_cdev_data.extra_bytes,
-				g_cdev_data.extra_bytes);
-		if (retval < 0) {
-			LOGE("Fail to copy extra bytes to buffer\n");
-			goto exit;
-		}
+			frame_buffer[offset + TCM_MSG_CRC_LENGTH] =
+				tcm_dev->msg_data.rc_byte;
 	}
 
 	LOGD("Pushing data starting by code 0x%02x to queue (size:%d)\n",
 		code, size);
 
-	retval = syna_cdev_insert_fifo(tcm, frame_buffer, size);
-	if (retval < 0) {
-		LOGE("Fail to push data to fifo\n");
-		goto exit;
-	}
+	syna_cdev_commit_fifo(tcm, pslot, size);
+
+	syna_pal_mutex_unlock(&g_cdev_data.queue_mutex);
 
 	wake_up_interruptible(&(tcm->wait_frame));
 
+	return;
+
 exit:
-	syna_pal_mem_free((void *)extrabytes);
-	syna_pal_mem_free((void *)frame_buffer);
+	syna_pal_mutex_unlock(&g_cdev_data.queue_mutex);
 }
 #endif
 /**
@@ -2180,7 +2637,10 @@ int syna_cdev_create(struct syna_tcm *tcm,
 	g_cdev_data.extra_bytes = 0;
 
 #ifdef ENABLE_EXTERNAL_FRAME_PROCESS
-	INIT_LIST_HEAD(&tcm->frame_fifo_queue);
+	retval = syna_cdev_alloc_fifo(tcm);
+	if (retval < 0)
+		goto err_alloc_fifo;
+
 	init_waitqueue_head(&tcm->wait_frame);
 #endif
 	syna_pal_mem_set(tcm->report_to_queue, 0, REPORT_TYPES);
@@ -2197,8 +2657,13 @@ int syna_cdev_create(struct syna_tcm *tcm,
 
 #ifdef HAS_SYSFS_INTERFACE
 err_create_dir:
-	device_destroy(device_class, tcm->char_dev_num);
 #endif
+#ifdef ENABLE_EXTERNAL_FRAME_PROCESS
+	kref_put(&tcm->frame_fifo->kref, syna_cdev_fifo_release);
+	tcm->frame_fifo = NULL;
+err_alloc_fifo:
+#endif
+	device_destroy(device_class, tcm->char_dev_num);
 err_create_device:
 	class_destroy(device_class);
 err_create_class:
@@ -2235,6 +2700,14 @@ void syna_cdev_remove(struct syna_tcm *tcm)
 	syna_cdev_clean_queue(tcm);
 	syna_pal_mutex_free(&g_cdev_data.queue_mutex);
 
+	/* the mappings still alive keep their reference */
+	syna_pal_mutex_lock(&g_cdev_data.mutex);
+	if (tcm->frame_fifo) {
+		kref_put(&tcm->frame_fifo->kref, syna_cdev_fifo_release);
+		tcm->frame_fifo = NULL;
+	}
+	syna_pal_mutex_unlock(&g_cdev_data.mutex);
+
 	tcm->char_dev_ref_count = 0;
 	tcm->proc_pid = 0;
 
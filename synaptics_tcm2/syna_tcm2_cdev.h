@@ -176,7 +176,7 @@ struct drv_param_power {
  *
  *       Description       BYTE |    BIT 7    |    BIT 6    |    BIT 5    |    BIT 4    |    BIT 3    |    BIT 2    |    BIT 1    |    BIT 0    |
  * --------------------------------------------------------------------------------------------------------------------------------------------------
- *      Features           [ 0] |                   reserved                                                        |Legacy V2 FW |Predict Read |
+ *      Features           [ 0] |                   reserved                            |  FIFO overflow policy     |Legacy V2 FW |Predict Read |
  *                              ---------------------------------------------------------------------------------------------------------------------
  *                         [ 1] |           Extra bytes to read                                                                                 |
  *                              ---------------------------------------------------------------------------------------------------------------------
@@ -207,7 +207,8 @@ struct drv_param_feature {
 			/* features : 12 bytes */
 			unsigned char predict_reads:1;
 			unsigned char legacy_firmware:1;
-			unsigned char reserve_b2__7:6;
+			unsigned char fifo_overflow_policy:2;
+			unsigned char reserve_b4__7:4;
 			unsigned char extra_bytes_to_read:8;
 			unsigned char depth_of_fifo:8;
 			unsigned char reserve_b24__31:8;
@@ -238,6 +239,65 @@ struct drv_param {
 };
 
 
+/* Define the overflow policy of kernel fifo, the field of
+ * feature.fifo_overflow_policy inside struct drv_param.
+ *
+ * FIFO_OVERFLOW_DEFAULT  : stop irq when reaching the depth of kernel fifo
+ *                          if it is set; otherwise, drop the oldest frame
+ * FIFO_OVERFLOW_DROP     : drop the oldest frame
+ * FIFO_OVERFLOW_STOP_IRQ : disable irq until the frames are consumed
+ */
+enum fifo_overflow_policy {
+	FIFO_OVERFLOW_DEFAULT = 0,
+	FIFO_OVERFLOW_DROP,
+	FIFO_OVERFLOW_STOP_IRQ,
+};
+
+/* Define the layout of kernel fifo, which can be mapped to userspace
+ * through mmap() on the device file.
+ *
+ * The first page contains struct frame_ring_info. The array of
+ * slot_count struct frame_ring_slot starts from slot_offset, and the
+ * data area of data_size bytes starts from data_offset. Each slot
+ * gives the offset of its frame in the data area, data_start, and the
+ * frame is stored there in the format of IOCTL_STD_GET_FRAME.
+ *
+ * head and tail are free-running counters, the slot index is given by
+ * (counter & (slot_count - 1)). Kernel only advances head; the consumer
+ * advances tail after reading a slot. When the oldest frame is dropped
+ * on overflow, kernel advances tail with an atomic compare-and-swap, so
+ * userspace shall also use a compare-and-swap to move tail forward, and
+ * discard the copied frame if it fails.
+ *
+ * Kernel keeps its own copy of the geometry, the slots and the counters,
+ * so tail is the only field userspace may write. A tail moved backward
+ * or past head is put back by kernel.
+ *
+ * overflow_policy tells the policy in effect, FIFO_OVERFLOW_DROP or
+ * FIFO_OVERFLOW_STOP_IRQ. When the irq is stopped, it is re-activated by
+ * IOCTL_STD_GET_FRAME or IOCTL_STD_CHECK_FRAMES once there is room again,
+ * so a consumer working on the mapping shall wait through the latter.
+ */
+struct frame_ring_info {
+	unsigned int head;
+	unsigned int tail;
+	unsigned int slot_count;
+	unsigned int slot_offset;
+	unsigned int data_offset;
+	unsigned int data_size;
+	unsigned int overflow_policy;
+	unsigned int dropped_frames;
+	unsigned int oversized_frames;
+	unsigned int irq_stops;
+};
+
+struct frame_ring_slot {
+	unsigned int data_length;
+	unsigned int data_start;
+	long long tv_sec;
+	long long tv_nsec;
+};
+
 
 /**
  * syna_cdev_ioctl_get_name()
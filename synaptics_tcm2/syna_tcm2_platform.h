@@ -107,6 +107,9 @@ struct syna_hw_bus_data {
 	unsigned int spi_mode;
 	unsigned int spi_byte_delay_us;
 	unsigned int spi_block_delay_us;
+	/* bytes per transfer and controller word_delay under byte delay */
+	unsigned int spi_byte_delay_chunk;
+	bool spi_word_delay;
 	/* mutex to protect the i/o, if needed */
 	syna_pal_mutex_t io_mutex;
 	/* parameters for io switch, if needed */
@@ -196,6 +199,25 @@ struct syna_hw_interface {
 	int (*ops_read_data)(struct syna_hw_interface *hw_if,
 			unsigned char *rd_data, unsigned int rd_len);
 
+	/* Operation to read data from bus into a DMA-safe buffer
+	 *
+	 * This is an optional operation.
+	 *
+	 * The caller guarantees rd_data is a heap buffer of at least
+	 * rd_len bytes, so the data can land in it without a bounce
+	 * buffer. Assign the pointer NULL to use ops_read_data instead.
+	 *
+	 * @param
+	 *    [ in] hw_if:   the handle of hw interface
+	 *    [out] rd_data: DMA-safe buffer for storing data retrieved
+	 *    [ in] rd_len:  length of reading data in bytes
+	 *
+	 * @return
+	 *    0 or positive value on success; otherwise, on error.
+	 */
+	int (*ops_read_data_direct)(struct syna_hw_interface *hw_if,
+			unsigned char *rd_data, unsigned int rd_len);
+
 	/* Operation to write data to bus
 	 *
 	 * This is an essential operation; otherwise, the communication
@@ -55,6 +55,9 @@ static unsigned char *tx_buf;
 
 static unsigned int buf_size;
 
+static unsigned char *ff_buf;
+static unsigned int ff_buf_size;
+
 static struct spi_transfer *xfer;
 
 static struct platform_device *syna_spi_device;
@@ -518,6 +521,31 @@ static int syna_spi_parse_dt(struct syna_hw_interface *hw_if,
 		bus->spi_block_delay_us = 0;
 	}
 
+	prop = of_find_property(np, "synaptics,spi-byte-delay-chunk", NULL);
+	if (prop && prop->length) {
+		retval = of_property_read_u32(np,
+				"synaptics,spi-byte-delay-chunk", &value);
+		if (retval < 0) {
+			LOGE("Fail to read byte-delay-chunk property\n");
+			return retval;
+		}
+
+		bus->spi_byte_delay_chunk = (value > 0) ? value : 1;
+
+	} else {
+		bus->spi_byte_delay_chunk = 1;
+	}
+
+	/* the controller honors spi_transfer.word_delay */
+	bus->spi_word_delay = of_property_read_bool(np,
+			"synaptics,spi-word-delay");
+#ifndef SPI_NO_DELAY_USEC
+	if (bus->spi_word_delay) {
+		LOGW("word_delay is not supported, use byte-delay transfers\n");
+		bus->spi_word_delay = false;
+	}
+#endif
+
 	prop = of_find_property(np, "synaptics,spi-mode", NULL);
 	if (prop && prop->length) {
 		retval = of_property_read_u32(np, "synaptics,spi-mode",
@@ -618,9 +646,130 @@ static int syna_spi_alloc_mem(unsigned int count, unsigned int size)
 	return 0;
 }
 
+/**
+ * syna_spi_alloc_ff_buf()
+ *
+ * Extend the 0xFF pattern clocked out while reading, only if the existing
+ * one is shorter than the requirement. The pattern is filled once here
+ * and never rewritten.
+ *
+ * @param
+ *    [ in] size: required length of the pattern
+ *
+ * @return
+ *    on success, 0; otherwise, negative value on error.
+ */
+static int syna_spi_alloc_ff_buf(unsigned int size)
+{
+	if (size <= ff_buf_size)
+		return 0;
+
+	if (ff_buf) {
+		syna_pal_mem_free((void *)ff_buf);
+		ff_buf = NULL;
+	}
+
+	ff_buf = syna_pal_mem_alloc(size, sizeof(unsigned char));
+	if (!ff_buf) {
+		LOGE("Fail to allocate memory for ff_buf\n");
+		ff_buf_size = 0;
+		return -ENOMEM;
+	}
+	syna_pal_mem_set(ff_buf, 0xff, size);
+
+	ff_buf_size = size;
+
+	return 0;
+}
+
+/**
+ * syna_spi_byte_delay_xfer_count()
+ *
+ * Return the number of spi_transfer structures needed to move len bytes
+ * while spi_byte_delay_us is set.
+ *
+ * @param
+ *    [ in] bus: the bus data
+ *    [ in] len: number of bytes to transfer
+ *
+ * @return
+ *    number of spi_transfer structures.
+ */
+static unsigned int syna_spi_byte_delay_xfer_count(struct syna_hw_bus_data *bus,
+		unsigned int len)
+{
+	if (bus->spi_word_delay)
+		return 1;
+
+	return DIV_ROUND_UP(len, bus->spi_byte_delay_chunk);
+}
 
 /**
- * syna_spi_read()
+ * syna_spi_add_byte_delay_xfers()
+ *
+ * Lay out the transfers for a message when spi_byte_delay_us is set.
+ * If the controller supports word_delay, a single transfer carries the
+ * per-byte delay. Otherwise, the data is split into transfers of
+ * spi_byte_delay_chunk bytes without cs_change, so that the delay lands
+ * between chunks; with the default chunk of 1 this is one transfer per
+ * byte.
+ *
+ * @param
+ *    [ in] bus: the bus data
+ *    [ in] msg: message the transfers are added to
+ *    [ in] tx:  data to send, len bytes
+ *    [out] rx:  buffer for the received data, or NULL when writing
+ *    [ in] len: number of bytes to transfer
+ *
+ * @return
+ *    none.
+ */
+static void syna_spi_add_byte_delay_xfers(struct syna_hw_bus_data *bus,
+		struct spi_message *msg, unsigned char *tx, unsigned char *rx,
+		unsigned int len)
+{
+	unsigned int idx;
+	unsigned int offset;
+
+#ifdef SPI_NO_DELAY_USEC
+	if (bus->spi_word_delay) {
+		xfer[0].len = len;
+		xfer[0].tx_buf = tx;
+		xfer[0].rx_buf = rx;
+		xfer[0].bits_per_word = 8;
+		xfer[0].word_delay.value = bus->spi_byte_delay_us;
+		xfer[0].word_delay.unit = SPI_DELAY_UNIT_USECS;
+		if (bus->spi_block_delay_us) {
+			xfer[0].delay.value = bus->spi_block_delay_us;
+			xfer[0].delay.unit = SPI_DELAY_UNIT_USECS;
+		}
+		spi_message_add_tail(&xfer[0], msg);
+		return;
+	}
+#endif
+
+	for (idx = 0, offset = 0; offset < len; idx++) {
+		xfer[idx].len = min(bus->spi_byte_delay_chunk, len - offset);
+		xfer[idx].tx_buf = &tx[offset];
+		if (rx)
+			xfer[idx].rx_buf = &rx[offset];
+		offset += xfer[idx].len;
+#ifdef SPI_NO_DELAY_USEC
+		xfer[idx].delay.value = bus->spi_byte_delay_us;
+		xfer[idx].delay.unit = SPI_DELAY_UNIT_USECS;
+		if (bus->spi_block_delay_us && (offset == len))
+			xfer[idx].delay.value = bus->spi_block_delay_us;
+#else
+		xfer[idx].delay_usecs = bus->spi_byte_delay_us;
+		if (bus->spi_block_delay_us && (offset == len))
+			xfer[idx].delay_usecs = bus->spi_block_delay_us;
+#endif
+		spi_message_add_tail(&xfer[idx], msg);
+	}
+}
+
+/**
+ * syna_spi_xfer_read()
  *
  * TouchCom over SPI requires the host to assert the SSB signal to address
  * the device and retrieve the data.
@@ -629,15 +778,16 @@ static int syna_spi_alloc_mem(unsigned int count, unsigned int size)
  *    [ in] hw_if:   the handle of hw interface
  *    [out] rd_data: buffer for storing data retrieved from device
  *    [ in] rd_len: number of bytes retrieved from device
+ *    [ in] direct:  rd_data is DMA-safe, receive into it without rx_buf
  *
  * @return
  *    on success, 0; otherwise, negative value on error.
  */
-static int syna_spi_read(struct syna_hw_interface *hw_if,
-		unsigned char *rd_data, unsigned int rd_len)
+static int syna_spi_xfer_read(struct syna_hw_interface *hw_if,
+		unsigned char *rd_data, unsigned int rd_len, bool direct)
 {
+	unsigned char *rx;
 	int retval;
-	unsigned int idx;
 	struct spi_message msg;
 	struct spi_device *spi = hw_if->pdev;
 	struct syna_hw_bus_data *bus = &hw_if->bdata_io;
@@ -694,46 +844,44 @@ static int syna_spi_read(struct syna_hw_interface *hw_if,
  */
 	if (rd_len > 256 && rd_len % 64)
 		rd_len = rd_len + (64 - rd_len % 64);
+	/* the padded tail does not fit the caller's buffer */
+	if (rd_len != bak_rd_len)
+		direct = false;
 #endif
 
 	spi_message_init(&msg);
 
-	if (bus->spi_byte_delay_us == 0)
-		retval = syna_spi_alloc_mem(1, rd_len);
-	else
-		retval = syna_spi_alloc_mem(rd_len, rd_len);
+	retval = syna_spi_alloc_mem((bus->spi_byte_delay_us == 0) ? 1 :
+			syna_spi_byte_delay_xfer_count(bus, rd_len),
+			direct ? 0 : rd_len);
+	if (retval < 0) {
+		LOGE("Fail to allocate memory\n");
+		goto exit;
+	}
+
+	retval = syna_spi_alloc_ff_buf(rd_len);
 	if (retval < 0) {
 		LOGE("Fail to allocate memory\n");
 		goto exit;
 	}
 
+	rx = direct ? rd_data : rx_buf;
+
 	if (bus->spi_byte_delay_us == 0) {
-		syna_pal_mem_set(tx_buf, 0xff, rd_len);
 		xfer[0].len = rd_len;
 #if defined(TOUCH_PLATFORM_XRING)
 		xfer[0].tx_buf = NULL;
 #else
-		xfer[0].tx_buf = tx_buf;
+		xfer[0].tx_buf = ff_buf;
 #endif
-		xfer[0].rx_buf = rx_buf;
+		xfer[0].rx_buf = rx;
 #ifndef SPI_NO_DELAY_USEC
 		if (bus->spi_block_delay_us)
 			xfer[0].delay_usecs = bus->spi_block_delay_us;
 #endif
 		spi_message_add_tail(&xfer[0], &msg);
 	} else {
-		tx_buf[0] = 0xff;
-		for (idx = 0; idx < rd_len; idx++) {
-			xfer[idx].len = 1;
-			xfer[idx].tx_buf = tx_buf;
-			xfer[idx].rx_buf = &rx_buf[idx];
-#ifndef SPI_NO_DELAY_USEC
-			xfer[idx].delay_usecs = bus->spi_byte_delay_us;
-			if (bus->spi_block_delay_us && (idx == rd_len - 1))
-				xfer[idx].delay_usecs = bus->spi_block_delay_us;
-#endif
-			spi_message_add_tail(&xfer[idx], &msg);
-		}
+		syna_spi_add_byte_delay_xfers(bus, &msg, ff_buf, rx, rd_len);
 	}
 
 	retval = spi_sync(spi, &msg);
@@ -744,10 +892,13 @@ static int syna_spi_read(struct syna_hw_interface *hw_if,
 #if defined(TOUCH_PLATFORM_XRING)
 	rd_len = bak_rd_len;
 #endif
-	retval = syna_pal_mem_cpy(rd_data, rd_len, rx_buf, rd_len, rd_len);
-	if (retval < 0) {
-		LOGE("Fail to copy rx_buf to rd_data\n");
-		goto exit;
+	if (!direct) {
+		retval = syna_pal_mem_cpy(rd_data, rd_len, rx_buf, rd_len, rd_len);
+		if (retval < 0) {
+			LOGE("Fail to copy rx_buf to rd_data\n");
+			goto exit;
+		}
+		tcm->bus_bytes_copied += rd_len;
 	}
 
 	syna_print_xfer_data(rd_data, rd_len, SYNA_SPI_TRANSFER_READ);
@@ -768,6 +919,45 @@ exit:
 	return retval;
 }
 
+/**
+ * syna_spi_read()
+ *
+ * Read the data through the internal rx buffer, for callers whose buffer
+ * may not be DMA-safe.
+ *
+ * @param
+ *    [ in] hw_if:   the handle of hw interface
+ *    [out] rd_data: buffer for storing data retrieved from device
+ *    [ in] rd_len: number of bytes retrieved from device
+ *
+ * @return
+ *    on success, 0; otherwise, negative value on error.
+ */
+static int syna_spi_read(struct syna_hw_interface *hw_if,
+		unsigned char *rd_data, unsigned int rd_len)
+{
+	return syna_spi_xfer_read(hw_if, rd_data, rd_len, false);
+}
+
+/**
+ * syna_spi_read_direct()
+ *
+ * Read the data into the caller's DMA-safe buffer without the extra copy.
+ *
+ * @param
+ *    [ in] hw_if:   the handle of hw interface
+ *    [out] rd_data: DMA-safe buffer for storing data retrieved from device
+ *    [ in] rd_len: number of bytes retrieved from device
+ *
+ * @return
+ *    on success, 0; otherwise, negative value on error.
+ */
+static int syna_spi_read_direct(struct syna_hw_interface *hw_if,
+		unsigned char *rd_data, unsigned int rd_len)
+{
+	return syna_spi_xfer_read(hw_if, rd_data, rd_len, true);
+}
+
 /**
  * syna_spi_write()
  *
@@ -786,7 +976,6 @@ static int syna_spi_write(struct syna_hw_interface *hw_if,
 		unsigned char *wr_data, unsigned int wr_len)
 {
 	int retval;
-	unsigned int idx;
 	struct spi_message msg;
 	struct spi_device *spi = hw_if->pdev;
 	struct syna_hw_bus_data *bus = &hw_if->bdata_io;
@@ -837,7 +1026,8 @@ static int syna_spi_write(struct syna_hw_interface *hw_if,
 	if (bus->spi_byte_delay_us == 0)
 		retval = syna_spi_alloc_mem(1, wr_len);
 	else
-		retval = syna_spi_alloc_mem(wr_len, wr_len);
+		retval = syna_spi_alloc_mem(
+				syna_spi_byte_delay_xfer_count(bus, wr_len), wr_len);
 	if (retval < 0) {
 		LOGE("Failed to allocate memory\n");
 		goto exit;
@@ -848,6 +1038,7 @@ static int syna_spi_write(struct syna_hw_interface *hw_if,
 		LOGE("Fail to copy wr_data to tx_buf\n");
 		goto exit;
 	}
+	tcm->bus_bytes_copied += wr_len;
 
 	if (bus->spi_byte_delay_us == 0) {
 		xfer[0].len = wr_len;
@@ -858,16 +1049,7 @@ static int syna_spi_write(struct syna_hw_interface *hw_if,
 #endif
 		spi_message_add_tail(&xfer[0], &msg);
 	} else {
-		for (idx = 0; idx < wr_len; idx++) {
-			xfer[idx].len = 1;
-			xfer[idx].tx_buf = &tx_buf[idx];
-#ifndef SPI_NO_DELAY_USEC
-			xfer[idx].delay_usecs = bus->spi_byte_delay_us;
-			if (bus->spi_block_delay_us && (idx == wr_len - 1))
-				xfer[idx].delay_usecs = bus->spi_block_delay_us;
-#endif
-			spi_message_add_tail(&xfer[idx], &msg);
-		}
+		syna_spi_add_byte_delay_xfers(bus, &msg, tx_buf, NULL, wr_len);
 	}
 
 	retval = spi_sync(spi, &msg);
@@ -1327,6 +1509,7 @@ static struct syna_hw_interface syna_spi_hw_if = {
 		.type = BUS_TYPE_SPI,
 		.rd_chunk_size = RD_CHUNK_SIZE,
 		.wr_chunk_size = WR_CHUNK_SIZE,
+		.spi_byte_delay_chunk = 1,
 	},
 	.bdata_attn = {
 		.irq_enabled = false,
@@ -1344,6 +1527,7 @@ static struct syna_hw_interface syna_spi_hw_if = {
 	.ops_power_on = syna_spi_power_on,
 	.ops_hw_reset = syna_spi_hw_reset,
 	.ops_read_data = syna_spi_read,
+	.ops_read_data_direct = syna_spi_read_direct,
 	.ops_write_data = syna_spi_write,
 	.ops_enable_irq = syna_spi_enable_irq,
 	.ops_config_gpio = syna_spi_config_gpios,
@@ -1560,6 +1744,11 @@ void syna_hw_interface_exit(void)
 		tx_buf = NULL;
 	}
 
+	if (ff_buf) {
+		syna_pal_mem_free((void *)ff_buf);
+		ff_buf = NULL;
+	}
+
 	if (xfer) {
 		syna_pal_mem_free((void *)xfer);
 		xfer = NULL;
@@ -1572,3 +1761,6 @@ MODULE_AUTHOR("Synaptics, Inc.");
 MODULE_DESCRIPTION("Synaptics TouchCom SPI Bus Module");
 MODULE_LICENSE("GPL v2");
 
+#if IS_ENABLED(CONFIG_TOUCHSCREEN_KUNIT_TEST)
+#include "../touch_kunit/tests/syna_tcm2_spi_test.c"
+#endif
@@ -484,6 +484,254 @@ exit:
 static struct kobj_attribute kobj_attr_pwr =
 	__ATTR(power_state, 0220, NULL, syna_sysfs_pwr_store);
 
+#if defined(ENABLE_ISR_LATENCY_STATS)
+/**
+ * syna_sysfs_isr_latency_show()
+ *
+ * Attribute to show the time spent in each stage of the ISR.
+ *
+ * @param
+ *    [ in] kobj:  an instance of kobj
+ *    [ in] attr:  an instance of kobj attribute structure
+ *    [out] buf:  string buffer shown on console
+ *
+ * @return
+ *    on success, number of characters being output;
+ *    otherwise, negative value on error.
+ */
+static ssize_t syna_sysfs_isr_latency_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct device *p_dev;
+	struct kobject *p_kobj;
+	struct syna_tcm *tcm;
+
+	p_kobj = g_sysfs_dir->parent;
+	p_dev = container_of(p_kobj, struct device, kobj);
+	tcm = dev_get_drvdata(p_dev);
+
+	return syna_dev_isr_latency_show(tcm, buf, PAGE_SIZE);
+}
+
+/**
+ * syna_sysfs_isr_latency_store()
+ *
+ * Attribute to control the ISR latency statistics.
+ * "1" to start; "0" to stop; "2" to clear the collected data
+ *
+ * @param
+ *    [ in] kobj:  an instance of kobj
+ *    [ in] attr:  an instance of kobj attribute structure
+ *    [ in] buf:   string buffer input
+ *    [ in] count: size of buffer input
+ *
+ * @return
+ *    on success, return count; otherwise, return error code
+ */
+static ssize_t syna_sysfs_isr_latency_store(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	unsigned int input;
+	struct device *p_dev;
+	struct kobject *p_kobj;
+	struct syna_tcm *tcm;
+
+	p_kobj = g_sysfs_dir->parent;
+	p_dev = container_of(p_kobj, struct device, kobj);
+	tcm = dev_get_drvdata(p_dev);
+
+	if (kstrtouint(buf, 10, &input))
+		return -EINVAL;
+
+	if (input == 0) {
+		syna_dev_isr_latency_enable(tcm, false);
+	} else if (input == 1) {
+		syna_dev_isr_latency_reset(tcm);
+		syna_dev_isr_latency_enable(tcm, true);
+	} else if (input == 2) {
+		syna_dev_isr_latency_reset(tcm);
+	} else {
+		LOGW("Unknown option %d (0:stop / 1:start / 2:clear)\n", input);
+		return -EINVAL;
+	}
+
+	return count;
+}
+
+static struct kobj_attribute kobj_attr_isr_latency =
+	__ATTR(isr_latency, 0644, syna_sysfs_isr_latency_show,
+		syna_sysfs_isr_latency_store);
+#endif
+
+/**
+ * syna_sysfs_bus_copy_show()
+ *
+ * Attribute to show the number of bytes copied through the bus
+ * bounce buffers.
+ *
+ * @param
+ *    [ in] kobj:  an instance of kobj
+ *    [ in] attr:  an instance of kobj attribute structure
+ *    [out] buf:  string buffer shown on console
+ *
+ * @return
+ *    on success, number of characters being output;
+ *    otherwise, negative value on error.
+ */
+static ssize_t syna_sysfs_bus_copy_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct device *p_dev;
+	struct kobject *p_kobj;
+	struct syna_tcm *tcm;
+
+	p_kobj = g_sysfs_dir->parent;
+	p_dev = container_of(p_kobj, struct device, kobj);
+	tcm = dev_get_drvdata(p_dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%llu\n",
+			tcm->bus_bytes_copied);
+}
+
+static struct kobj_attribute kobj_attr_bus_copy =
+	__ATTR(bus_copy, 0444, syna_sysfs_bus_copy_show, NULL);
+
+#ifdef TOUCH_THP_SUPPORT
+/**
+ * syna_sysfs_mf_queue_show()
+ *
+ * Attribute to show the MultiFunction commands submitted, the ones
+ * replaced by a newer write, and the transactions actually issued.
+ *
+ * @param
+ *    [ in] kobj:  an instance of kobj
+ *    [ in] attr:  an instance of kobj attribute structure
+ *    [out] buf:  string buffer shown on console
+ *
+ * @return
+ *    on success, number of characters being output;
+ *    otherwise, negative value on error.
+ */
+static ssize_t syna_sysfs_mf_queue_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct device *p_dev;
+	struct kobject *p_kobj;
+	struct syna_tcm *tcm;
+
+	p_kobj = g_sysfs_dir->parent;
+	p_dev = container_of(p_kobj, struct device, kobj);
+	tcm = dev_get_drvdata(p_dev);
+
+	return syna_tcm_mf_queue_show(tcm, buf, PAGE_SIZE);
+}
+
+static struct kobj_attribute kobj_attr_mf_queue =
+	__ATTR(mf_queue, 0444, syna_sysfs_mf_queue_show, NULL);
+
+/**
+ * syna_sysfs_report_rate_show()
+ *
+ * Attribute to show the report rate in effect, the rate pinned by
+ * userspace, the rate requested by the HAL, the last panel refresh rate
+ * and the number of switches.
+ *
+ * @param
+ *    [ in] kobj:  an instance of kobj
+ *    [ in] attr:  an instance of kobj attribute structure
+ *    [out] buf:  string buffer shown on console
+ *
+ * @return
+ *    on success, number of characters being output;
+ *    otherwise, negative value on error.
+ */
+static ssize_t syna_sysfs_report_rate_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct device *p_dev;
+	struct kobject *p_kobj;
+	struct syna_tcm *tcm;
+
+	p_kobj = g_sysfs_dir->parent;
+	p_dev = container_of(p_kobj, struct device, kobj);
+	tcm = dev_get_drvdata(p_dev);
+
+	return syna_tcm_report_rate_show(tcm, buf, PAGE_SIZE);
+}
+
+/**
+ * syna_sysfs_report_rate_store()
+ *
+ * Attribute to pin the report rate.
+ * "N" to pin the supported rate closest to N Hz; "0" to follow the HAL
+ * request or the panel
+ *
+ * @param
+ *    [ in] kobj:  an instance of kobj
+ *    [ in] attr:  an instance of kobj attribute structure
+ *    [ in] buf:   string buffer input
+ *    [ in] count: size of buffer input
+ *
+ * @return
+ *    on success, return count; otherwise, return error code
+ */
+static ssize_t syna_sysfs_report_rate_store(struct kobject *kobj,
+		struct kobj_attribute *attr, const char *buf, size_t count)
+{
+	unsigned int input;
+	struct device *p_dev;
+	struct kobject *p_kobj;
+	struct syna_tcm *tcm;
+
+	p_kobj = g_sysfs_dir->parent;
+	p_dev = container_of(p_kobj, struct device, kobj);
+	tcm = dev_get_drvdata(p_dev);
+
+	if (kstrtouint(buf, 10, &input) || input > USHRT_MAX)
+		return -EINVAL;
+
+	syna_tcm_report_rate_pin(tcm, input);
+
+	return count;
+}
+
+static struct kobj_attribute kobj_attr_report_rate =
+	__ATTR(report_rate, 0644, syna_sysfs_report_rate_show,
+		syna_sysfs_report_rate_store);
+
+/**
+ * syna_sysfs_thp_frame_show()
+ *
+ * Attribute to show the THP frames read straight into the raw data slot,
+ * the frames copied from the event buffer and the crc failures.
+ *
+ * @param
+ *    [ in] kobj:  an instance of kobj
+ *    [ in] attr:  an instance of kobj attribute structure
+ *    [out] buf:  string buffer shown on console
+ *
+ * @return
+ *    on success, number of characters being output;
+ *    otherwise, negative value on error.
+ */
+static ssize_t syna_sysfs_thp_frame_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct device *p_dev;
+	struct kobject *p_kobj;
+	struct syna_tcm *tcm;
+
+	p_kobj = g_sysfs_dir->parent;
+	p_dev = container_of(p_kobj, struct device, kobj);
+	tcm = dev_get_drvdata(p_dev);
+
+	return syna_tcm_thp_frame_show(tcm, buf, PAGE_SIZE);
+}
+
+static struct kobj_attribute kobj_attr_thp_frame =
+	__ATTR(thp_frame, 0444, syna_sysfs_thp_frame_show, NULL);
+#endif
+
 /**
  * declaration of sysfs attributes
  */
@@ -492,6 +740,15 @@ static struct attribute *attrs[] = {
 	&kobj_attr_irq_en.attr,
 	&kobj_attr_reset.attr,
 	&kobj_attr_pwr.attr,
+	&kobj_attr_bus_copy.attr,
+#if defined(ENABLE_ISR_LATENCY_STATS)
+	&kobj_attr_isr_latency.attr,
+#endif
+#ifdef TOUCH_THP_SUPPORT
+	&kobj_attr_mf_queue.attr,
+	&kobj_attr_report_rate.attr,
+	&kobj_attr_thp_frame.attr,
+#endif
 	NULL,
 };
 
@@ -42,7 +42,14 @@ static xiaomi_driver_data_t xiaomi_driver_data;
 static hardware_operation_t hardware_operation;
 static hardware_param_t hardware_param;
 static struct syna_tcm *tcm = NULL;
+static const u32 syna_default_report_rates[] = {60, 68, 120, 135, 240, 300};
 static void syna_set_ic_mode(enum set_ic_mode_enum mode, int *value);
+#ifdef TOUCH_THP_SUPPORT
+static void syna_report_rate_restore(struct syna_tcm *tcm_hcd);
+static void syna_report_rate_send(struct syna_tcm *tcm_hcd, int rate);
+static void syna_mf_queue_hold(struct syna_tcm *tcm_hcd);
+static void syna_mf_queue_release(struct syna_tcm *tcm_hcd);
+#endif
 
 #ifdef CONFIG_TRUSTED_TOUCH
 struct qts_vendor_data qts_vendor_data;
@@ -162,6 +169,8 @@ static int syna_htc_ic_setModeValue(common_data_t *common_data)
 		LOGD("new_out_buf[i:%d]:0x%x", i, new_out_buf[i]);
 	}
 
+	/* queued mode writes go first, they are older than this one */
+	syna_mf_queue_hold(tcm_hcd);
 	retval = tcm_dev->write_message(tcm_dev,
 			CMD,
 			new_out_buf,
@@ -169,6 +178,7 @@ static int syna_htc_ic_setModeValue(common_data_t *common_data)
 			cmd_size,
 			resp_buf,
 			tcm_dev->msg_data.default_resp_reading);
+	syna_mf_queue_release(tcm_hcd);
 	if (retval < 0) {
 		LOGE("Failed to write command %s\n", STR(CMD));
 		goto exit;
@@ -678,6 +688,23 @@ int xiaomi_parse_dt(struct device *dev)
 		xiaomi_bdata.super_resolution_factor = value;
 	}
 
+	xiaomi_bdata.report_rate_num = 0;
+	retval = of_property_count_u32_elems(np, SYNA_REPORT_RATE_TABLE);
+	if (retval > 0) {
+		value = min(retval, SYNA_REPORT_RATE_MAX_NUM);
+		retval = of_property_read_u32_array(np, SYNA_REPORT_RATE_TABLE,
+				xiaomi_bdata.report_rate_table, value);
+		if (retval == 0)
+			xiaomi_bdata.report_rate_num = value;
+	}
+	/* missing, empty or unreadable table */
+	if (xiaomi_bdata.report_rate_num == 0) {
+		LOGI("no %s, use default report rates\n", SYNA_REPORT_RATE_TABLE);
+		xiaomi_bdata.report_rate_num = ARRAY_SIZE(syna_default_report_rates);
+		memcpy(xiaomi_bdata.report_rate_table, syna_default_report_rates,
+				sizeof(syna_default_report_rates));
+	}
+
 	retval = of_property_read_string(np, "synaptics,default-thp-config-name",
 					 &xiaomi_bdata.synaptics_default_cfg_name);
 	if (retval && (retval != -EINVAL)) {
@@ -806,6 +833,9 @@ static int syna_tcm_resume_suspend(bool is_resume, u8 gesture_type)
 #endif
 		result = tcm->dev_resume(&tcm->pdev->dev);
 		syna_set_ic_mode(SET_BASE_REFRESH_INTERVAL_TIME, NULL);
+#ifdef TOUCH_THP_SUPPORT
+		syna_report_rate_restore(tcm);
+#endif
 		return result;
 	}
 
@@ -848,6 +878,10 @@ static int syna_tcm_post_la_tui_disable(void *data)
 	syna_tcm_enable_touch_raw(1);
 	complete_all(&xiaomi_driver_data.tui_finish);
 	xiaomi_driver_data.tui_process = false;
+#ifdef TOUCH_THP_SUPPORT
+	/* send what was queued while the TVM held the bus */
+	queue_work(system_highpri_wq, &tcm->mf_queue.work);
+#endif
 	 return 0;
 }
 
@@ -1010,19 +1044,248 @@ exit:
 static void syna_set_fod_downup(struct syna_tcm *tcm_hcd, int enable)
 {
 	LOGI("enable:%d\n", enable);
+	/* the IC gets the queued mode writes before the fod state changes */
+	syna_mf_queue_hold(tcm_hcd);
 	if (enable) {
 		update_fod_press_status(1);
 	} else {
 		update_fod_press_status(0);
 		tcm_hcd->fod_finger = false;
 	}
+	syna_mf_queue_release(tcm_hcd);
+}
+
+static int syna_mf_queue_send(struct syna_tcm *tcm_hcd, unsigned char *packet,
+		unsigned int size, unsigned char *cmd_size, int count)
+{
+	struct syna_mf_queue *queue = &tcm_hcd->mf_queue;
+	unsigned int offset = 0;
+	int retval;
+	int i;
+
+	retval = syna_tcm_set_touch_multi_function(tcm_hcd->tcm_dev, packet, size);
+	queue->transactions++;
+	if (retval >= 0 || count == 1)
+		return retval;
+
+	/* firmware refused the packed one, send the sub-commands one by one */
+	LOGW("Fail to send %d packed sub-commands, send them one by one\n", count);
+	for (i = 0; i < count; i++) {
+		retval = syna_tcm_set_touch_multi_function(tcm_hcd->tcm_dev,
+				&packet[offset], cmd_size[i]);
+		queue->transactions++;
+		if (retval < 0)
+			LOGE("Fail to send sub-command 0x%02x\n", packet[offset]);
+		offset += cmd_size[i];
+	}
+
+	return retval;
+}
+
+/* called with flush_lock held */
+static void __syna_mf_queue_flush(struct syna_tcm *tcm_hcd)
+{
+	struct syna_mf_queue *queue = &tcm_hcd->mf_queue;
+	struct syna_mf_cmd cmd[SYNA_MF_QUEUE_SLOTS];
+	unsigned char packet[SYNA_MF_PACKET_MAX_SIZE];
+	unsigned char cmd_size[SYNA_MF_QUEUE_SLOTS];
+	unsigned int size = 0;
+	int count = 0;
+	int retval;
+	int i;
+
+	/* the bus belongs to the TVM or to the flasher, hold the commands */
+#ifdef CONFIG_TRUSTED_TOUCH
+	if (xiaomi_driver_data.tui_process) {
+		if (!wait_for_completion_timeout(&xiaomi_driver_data.tui_finish,
+				msecs_to_jiffies(6000))) {
+			/* keep them pending, the end of the TUI session sends them */
+			LOGE("TUI still running, keep the pending commands\n");
+			return;
+		}
+		LOGN("wait finished, its time to go ahead\n");
+	}
+#endif
+	if (ATOMIC_GET(tcm_hcd->tcm_dev->firmware_flashing)) {
+		LOGI("Touch is do fw updating\n");
+		if (!wait_for_completion_timeout(&tcm_hcd->tcm_dev->fw_update_completion,
+				msecs_to_jiffies(6000)))
+			LOGE("wait_for_completion_timeout!\n");
+	}
+
+	mutex_lock(&queue->lock);
+	memcpy(cmd, queue->cmd, sizeof(cmd));
+	for (i = 0; i < SYNA_MF_QUEUE_SLOTS; i++)
+		queue->cmd[i].pending = false;
+	mutex_unlock(&queue->lock);
+
+	if (tcm_hcd->pwr_state != PWR_ON) {
+		LOGI("pwr_state is not PWR_ON, drop the pending commands\n");
+		return;
+	}
+	if (ATOMIC_GET(tcm_hcd->tcm_dev->firmware_flashing)) {
+		LOGE("Touch is still do fw updating, drop the pending commands\n");
+		return;
+	}
+
+	/* keep the submission order, pack the adjacent MultiFunction ones */
+	for (i = 0; i < SYNA_MF_QUEUE_SLOTS; i++) {
+		if (!cmd[i].pending)
+			continue;
+
+		if (cmd[i].no_resp || size + cmd[i].size > sizeof(packet)) {
+			if (size > 0) {
+				retval = syna_mf_queue_send(tcm_hcd, packet, size,
+						cmd_size, count);
+				if (retval < 0)
+					LOGE("Failed to write command %s\n", STR(CMD_MultiFunction));
+				size = 0;
+				count = 0;
+			}
+		}
+
+		if (cmd[i].no_resp) {
+			syna_tcm_set_cmd_noresponse(tcm_hcd->tcm_dev,
+					cmd[i].data, cmd[i].size);
+			queue->transactions++;
+			continue;
+		}
+
+		memcpy(&packet[size], cmd[i].data, cmd[i].size);
+		size += cmd[i].size;
+		cmd_size[count++] = cmd[i].size;
+	}
+
+	if (size > 0) {
+		retval = syna_mf_queue_send(tcm_hcd, packet, size,
+						cmd_size, count);
+		if (retval < 0)
+			LOGE("Failed to write command %s\n", STR(CMD_MultiFunction));
+	}
+}
+
+static void syna_mf_queue_flush(struct syna_tcm *tcm_hcd)
+{
+	mutex_lock(&tcm_hcd->mf_queue.flush_lock);
+	__syna_mf_queue_flush(tcm_hcd);
+	mutex_unlock(&tcm_hcd->mf_queue.flush_lock);
+}
+
+/*
+ * send the pending commands and keep the queue from sending more until
+ * syna_mf_queue_release(), so a direct write is not overtaken by an
+ * older queued one
+ */
+static void syna_mf_queue_hold(struct syna_tcm *tcm_hcd)
+{
+	mutex_lock(&tcm_hcd->mf_queue.flush_lock);
+	__syna_mf_queue_flush(tcm_hcd);
+}
+
+static void syna_mf_queue_release(struct syna_tcm *tcm_hcd)
+{
+	mutex_unlock(&tcm_hcd->mf_queue.flush_lock);
+}
+
+static void syna_mf_queue_work(struct work_struct *work)
+{
+	struct syna_mf_queue *queue =
+			container_of(work, struct syna_mf_queue, work);
+	struct syna_tcm *tcm_hcd =
+			container_of(queue, struct syna_tcm, mf_queue);
+
+	syna_mf_queue_flush(tcm_hcd);
+}
+
+/*
+ * the sub-command identity: the first byte after the header of a 0xC8
+ * packet, plus the variant for sub-commands whose variants fill
+ * disjoint fields and so must not replace each other
+ */
+static inline unsigned int syna_mf_cmd_key(bool no_resp, unsigned char *data)
+{
+	unsigned int key = no_resp ? data[3] : data[0];
+
+	/* ENTER_IDLE_MODE: idle enable in byte 1 or idle threshold in byte 2 */
+	if (!no_resp && key == 0x43 && data[2])
+		key |= 0x100;
+
+	return key;
+}
+
+/*
+ * queue one command without blocking on the bus, -EBUSY when every slot
+ * holds another sub-command and the queue has to be flushed first
+ */
+static int syna_mf_queue_try_submit(struct syna_tcm *tcm_hcd,
+		unsigned char *data, unsigned int size, bool no_resp)
+{
+	struct syna_mf_queue *queue = &tcm_hcd->mf_queue;
+	struct syna_mf_cmd *slot = NULL;
+	unsigned int key = syna_mf_cmd_key(no_resp, data);
+	int i;
+
+	if (size > SYNA_MF_CMD_MAX_SIZE) {
+		LOGE("Invalid sub-command size %d\n", size);
+		return -EINVAL;
+	}
+
+	mutex_lock(&queue->lock);
+	for (i = 0; i < SYNA_MF_QUEUE_SLOTS; i++) {
+		if (queue->cmd[i].pending) {
+			if (queue->cmd[i].no_resp == no_resp &&
+				syna_mf_cmd_key(no_resp, queue->cmd[i].data) == key) {
+				slot = &queue->cmd[i];
+				queue->merged++;
+				break;
+			}
+		} else if (!slot) {
+			slot = &queue->cmd[i];
+		}
+	}
+
+	if (!slot) {
+		mutex_unlock(&queue->lock);
+		return -EBUSY;
+	}
+
+	memcpy(slot->data, data, size);
+	slot->size = size;
+	slot->no_resp = no_resp;
+	slot->pending = true;
+	queue->submitted++;
+	mutex_unlock(&queue->lock);
+
+	queue_work(system_highpri_wq, &queue->work);
+	return 0;
+}
+
+static void syna_mf_queue_submit(struct syna_tcm *tcm_hcd,
+		unsigned char *data, unsigned int size, bool no_resp)
+{
+	/* all slots taken by other sub-commands, send them first */
+	while (syna_mf_queue_try_submit(tcm_hcd, data, size, no_resp) == -EBUSY)
+		syna_mf_queue_flush(tcm_hcd);
+}
+
+int syna_tcm_mf_queue_show(struct syna_tcm *tcm_hcd, char *buf, int size)
+{
+	struct syna_mf_queue *queue = &tcm_hcd->mf_queue;
+	int count;
+
+	mutex_lock(&queue->lock);
+	count = scnprintf(buf, size,
+			"submitted: %llu\nmerged: %llu\ntransactions: %llu\n",
+			queue->submitted, queue->merged, queue->transactions);
+	mutex_unlock(&queue->lock);
+
+	return count;
 }
 
 static void syna_set_ic_mode(enum set_ic_mode_enum mode, int *value)
 {
 	unsigned char out_buf[11] = {0};
 	int out_buf_size = 0;
-	int retval;
 	struct syna_tcm *tcm_hcd = tcm;
 
 	if (!tcm_hcd) {
@@ -1065,7 +1328,12 @@ static void syna_set_ic_mode(enum set_ic_mode_enum mode, int *value)
 		out_buf[0] = 0x07;
 		out_buf[1] = ((value[0] == 1) ? 60 : 120);
 		out_buf[2] = 0x00;
-		out_buf_size = 3;
+		/* same sub-command as syna_report_rate_apply, keep its state */
+		mutex_lock(&tcm_hcd->report_rate_lock);
+		syna_report_rate_send(tcm_hcd, out_buf[1]);
+		mutex_unlock(&tcm_hcd->report_rate_lock);
+		LOGD("%s queued, mode = %d\n", __func__, mode);
+		return;
 	} else if (mode == SET_DOZE_WAKEUP_THRESHOLD) {
 		out_buf[0] = 0x39;
 		out_buf[1] = value[0];
@@ -1080,7 +1348,7 @@ static void syna_set_ic_mode(enum set_ic_mode_enum mode, int *value)
 		out_buf[4] = value[0] ? 0x04 : 0x03;
 		out_buf[5] = 0x00;
 		LOGD("%s out_buf:%x,%x,%x,%x,%x,%x\n", __func__, out_buf[0], out_buf[1], out_buf[2], out_buf[3], out_buf[4], out_buf[5]);
-		syna_tcm_set_cmd_noresponse(tcm_hcd->tcm_dev, out_buf, 6);
+		syna_mf_queue_submit(tcm_hcd, out_buf, 6, true);
 		return;
 	} else if (mode == SET_THP_GLOVE_STATUS) {
 		out_buf[0] = 0xC8;
@@ -1094,64 +1362,156 @@ static void syna_set_ic_mode(enum set_ic_mode_enum mode, int *value)
 		out_buf[8] = (value[2] & 0xFF);
 		out_buf[9] = ((value[2] >> 8) & 0xFF);
 		LOGD("%s out_buf:%x,%x,%x,%x,%x,%x,%x,%x,%x,%x\n", __func__, out_buf[0], out_buf[1], out_buf[2], out_buf[3], out_buf[4], out_buf[5], out_buf[6], out_buf[7], out_buf[8], out_buf[9]);
-		syna_tcm_set_cmd_noresponse(tcm_hcd->tcm_dev, out_buf, 10);
+		syna_mf_queue_submit(tcm_hcd, out_buf, 10, true);
 		return;
 	} else {
 		LOGE("unkow mode %d, return\n", mode);
 		return;
 	}
 
-	retval = syna_tcm_set_touch_multi_function(tcm_hcd->tcm_dev, out_buf, out_buf_size);
-	if (retval < 0) {
-		LOGE("%s Failed to write command %s, mode = %d\n", __func__, STR(CMD_MultiFunction), mode);
-	} else {
-		LOGD("%s ok\n", __func__);
+	syna_mf_queue_submit(tcm_hcd, out_buf, out_buf_size, false);
+	LOGD("%s queued, mode = %d\n", __func__, mode);
+}
+
+/* closest supported rate to hz; ties go to the higher rate */
+static int syna_report_rate_closest(int hz)
+{
+	int i, rate, best = 0, diff, best_diff = INT_MAX;
+
+	for (i = 0; i < xiaomi_bdata.report_rate_num; i++) {
+		rate = (int)xiaomi_bdata.report_rate_table[i];
+		diff = abs(rate - hz);
+		if (diff < best_diff || (diff == best_diff && rate > best)) {
+			best = rate;
+			best_diff = diff;
+		}
+	}
+
+	return best;
+}
+
+/*
+ * called with report_rate_lock held; the lock is dropped while the
+ * queue is flushed to make room
+ */
+static void syna_report_rate_send(struct syna_tcm *tcm_hcd, int rate)
+{
+	unsigned char out_buf[3] = {0x07, 0x00, 0x00};
+
+	out_buf[1] = (unsigned char)(rate & 0xFF);
+	out_buf[2] = (unsigned char)((rate >> 8) & 0xFF);
+	while (syna_mf_queue_try_submit(tcm_hcd, out_buf, sizeof(out_buf),
+			false) == -EBUSY) {
+		mutex_unlock(&tcm_hcd->report_rate_lock);
+		syna_mf_queue_flush(tcm_hcd);
+		mutex_lock(&tcm_hcd->report_rate_lock);
+	}
+	if (rate != tcm_hcd->report_rate) {
+		tcm_hcd->report_rate = rate;
+		tcm_hcd->report_rate_switches++;
+	}
+}
+
+/* called with report_rate_lock held */
+static void syna_report_rate_apply(struct syna_tcm *tcm_hcd, bool force)
+{
+	int target = tcm_hcd->report_rate_pinned;
+	int rate;
+
+	if (!target)
+		target = tcm_hcd->report_rate_requested;
+	if (!target)
+		target = tcm_hcd->panel_fps ? tcm_hcd->panel_fps : SYNA_REPORT_RATE_DEFAULT;
+	rate = syna_report_rate_closest(target);
+	if (!rate)
+		return;
+	if (tcm_hcd->pwr_state != PWR_ON) {
+		LOGI("Touch is in not in PWR_ON mode, set report rate %d on resume\n", rate);
+		return;
 	}
+	if (!force && rate == tcm_hcd->report_rate)
+		return;
+
+	syna_report_rate_send(tcm_hcd, rate);
+	LOGI("%s queued, target = %d, rate = %d\n", __func__, target, rate);
 }
 
+/*
+ * DATA_MODE_55: the HAL rate stays in force over panel fps changes and
+ * resumes until the HAL sends 0 to follow the panel fps again
+ */
 static void syna_set_report_rate(int value)
 {
-	unsigned char out_buf[3] = {0x07, 0x78, 0x00};
-	int retval;
 	struct syna_tcm *tcm_hcd = tcm;
 
 	if (!tcm_hcd) {
 		LOGE("%s tcm_hcd is null\n", __func__);
 		return;
 	}
-	if (tcm_hcd->pwr_state != PWR_ON) {
-		LOGE("Touch is in not in PWR_ON mode, don't need to set report rate\n");
+	mutex_lock(&tcm_hcd->report_rate_lock);
+	tcm_hcd->report_rate_requested = value > 0 ? value : 0;
+	syna_report_rate_apply(tcm_hcd, true);
+	mutex_unlock(&tcm_hcd->report_rate_lock);
+	LOGI("%s value = %d\n", __func__, value);
+}
+
+/**
+ * syna_tcm_report_rate_pin()
+ *
+ * Pin the report rate regardless of the panel refresh rate.
+ *
+ * @param
+ *    [ in] tcm_hcd: the driver handle
+ *    [ in] value:   rate in Hz to pin; 0 to follow the panel fps again
+ *
+ * @return
+ *    none.
+ */
+void syna_tcm_report_rate_pin(struct syna_tcm *tcm_hcd, int value)
+{
+	mutex_lock(&tcm_hcd->report_rate_lock);
+	tcm_hcd->report_rate_pinned = value > 0 ? value : 0;
+	syna_report_rate_apply(tcm_hcd, true);
+	mutex_unlock(&tcm_hcd->report_rate_lock);
+}
+
+static void syna_tcm_set_panel_fps(int fps)
+{
+	struct syna_tcm *tcm_hcd = tcm;
+
+	if (!tcm_hcd || tcm_hcd->tp_probe_success == 0)
 		return;
-	}
-	switch (value) {
-	case 60:
-		out_buf[1] = 0x3C;
-		break;
-	case 68:
-		out_buf[1] = 0x44;
-		break;
-	case 120:
-		out_buf[1] = 0x78;
-		break;
-	case 135:
-		out_buf[1] = 0x87;
-		break;
-	case 240:
-		out_buf[1] = 0xF0;
-		break;
-	case 300:
-		out_buf[1] = 0x2c;
-		out_buf[2] = 0x01;
-		break;
-	default:
-		break;
-	}
-	retval = syna_tcm_set_touch_multi_function(tcm_hcd->tcm_dev, out_buf, sizeof(out_buf));
-	if (retval < 0) {
-		LOGE("%s Failed to write command %s\n", __func__, STR(CMD_MultiFunction));
-	} else {
-		LOGI("%s ok\n", __func__);
-	}
+	mutex_lock(&tcm_hcd->report_rate_lock);
+	tcm_hcd->panel_fps = fps;
+	if (!tcm_hcd->report_rate_pinned && !tcm_hcd->report_rate_requested)
+		syna_report_rate_apply(tcm_hcd, false);
+	mutex_unlock(&tcm_hcd->report_rate_lock);
+}
+
+/* the IC is back at its default rate after a reset, send ours again */
+static void syna_report_rate_restore(struct syna_tcm *tcm_hcd)
+{
+	mutex_lock(&tcm_hcd->report_rate_lock);
+	tcm_hcd->report_rate = 0;
+	if (tcm_hcd->report_rate_pinned || tcm_hcd->report_rate_requested ||
+			tcm_hcd->panel_fps)
+		syna_report_rate_apply(tcm_hcd, true);
+	mutex_unlock(&tcm_hcd->report_rate_lock);
+}
+
+int syna_tcm_report_rate_show(struct syna_tcm *tcm_hcd, char *buf, int size)
+{
+	int count;
+
+	mutex_lock(&tcm_hcd->report_rate_lock);
+	count = scnprintf(buf, size,
+			"rate: %d\npinned: %d\nrequested: %d\npanel_fps: %d\nswitches: %u\n",
+			tcm_hcd->report_rate, tcm_hcd->report_rate_pinned,
+			tcm_hcd->report_rate_requested, tcm_hcd->panel_fps,
+			tcm_hcd->report_rate_switches);
+	mutex_unlock(&tcm_hcd->report_rate_lock);
+
+	return count;
 }
 
 #ifdef CONFIG_TOUCH_FACTORY_BUILD
@@ -1181,6 +1541,41 @@ static void syna_tmd_signal_work(struct work_struct *work)
 	return;
 }
 
+/* report dest callback, place a THP report straight into the raw data slot */
+static unsigned char *syna_tcm_thp_slot_dest(unsigned char code,
+		unsigned int length, void *callback_data)
+{
+	struct syna_tcm *tcm_hcd = (struct syna_tcm *)callback_data;
+	struct tp_frame *thp_frame = NULL;
+
+	if (code != REPORT_THP)
+		return NULL;
+
+	if (tcm_hcd->thp_slot) {
+		/* the last report read into the slot was never published */
+		cancel_raw_data_update(TOUCH_ID);
+		tcm_hcd->thp_slot = NULL;
+	}
+	/* the core gives the slot back when the payload could not be stored */
+	if (length == 0)
+		return NULL;
+	if (!tcm_hcd->enable_touch_raw || (tcm_hcd->pwr_state != PWR_ON))
+		return NULL;
+	if (length > sizeof(thp_frame->thp_frame_buf)) {
+		LOGE("THP report %d bytes exceeds the raw data slot\n", length);
+		return NULL;
+	}
+
+	thp_frame = (struct tp_frame *)begin_raw_data_update(TOUCH_ID);
+	if (thp_frame == NULL)
+		return NULL;
+
+	tcm_hcd->thp_slot = thp_frame;
+	tcm_hcd->thp_slot_length = length;
+
+	return (unsigned char *)thp_frame->thp_frame_buf;
+}
+
 int syna_tcm_report_thp_frame(struct syna_tcm *tcm_hcd, s64 irq_start_time)
 {
 	struct tp_frame *thp_frame = NULL;
@@ -1195,32 +1590,41 @@ int syna_tcm_report_thp_frame(struct syna_tcm *tcm_hcd, s64 irq_start_time)
     struct tp_raw* tp_raw = NULL;
 #endif
 
-	pevent_data = &tcm_hcd->event_data;
-	if ((pevent_data == NULL) || (pevent_data->buf == NULL)) {
-		LOGE("Returned, invalid event data pointer\n");
-		return -EIO;
-	}
-	if (pevent_data->data_length == 0) {
-		LOGE("Returned, invalid event data length = 0\n");
-		return -EIO;
-	}
+	if (tcm_hcd->thp_slot) {
+		/* the report was already read into the slot */
+		thp_frame = (struct tp_frame *)tcm_hcd->thp_slot;
+		frame_length = tcm_hcd->thp_slot_length;
+		tcm_hcd->thp_slot = NULL;
+		tcm_hcd->thp_frames_in_slot++;
+	} else {
+		pevent_data = &tcm_hcd->event_data;
+		if ((pevent_data == NULL) || (pevent_data->buf == NULL)) {
+			LOGE("Returned, invalid event data pointer\n");
+			return -EIO;
+		}
+		if (pevent_data->data_length == 0) {
+			LOGE("Returned, invalid event data length = 0\n");
+			return -EIO;
+		}
 
-	thp_frame = (struct tp_frame *)get_raw_data_base(TOUCH_ID);
-	if (thp_frame == NULL) {
-		LOGE("Returned, no memory\n");
-		return -ENOMEM;
-	}
+		thp_frame = (struct tp_frame *)begin_raw_data_update(TOUCH_ID);
+		if (thp_frame == NULL) {
+			LOGE("Returned, no memory\n");
+			return -ENOMEM;
+		}
 
-	frame_length = pevent_data->data_length;
-	memcpy(thp_frame->thp_frame_buf, pevent_data->buf, frame_length);
+		frame_length = min_t(unsigned int, pevent_data->data_length,
+				sizeof(thp_frame->thp_frame_buf));
+		memcpy(thp_frame->thp_frame_buf, pevent_data->buf, frame_length);
+		tcm_hcd->thp_frames_copied++;
+	}
 	ktime_get_real_ts64(&ts);
 	thp_frame->time_ns = timespec64_to_ns(&ts);
 	thp_frame->frm_cnt = thp_cnt++;
 	thp_frame->fod_pressed = tcm_hcd->fod_finger;
 	thp_frame->fod_trackingId = 0;
-	add_input_event_timeline_before_event_time(0, thp_frame->frm_cnt, irq_start_time, ktime_get());
-	notify_raw_data_update(TOUCH_ID);
 #ifdef SYNA_CRC_CHECK
+	/* fix up the crc in the slot before the frame is published */
 	tp_raw = (struct tp_raw*)((thp_frame->thp_frame_buf));
 	ic_crc = tp_raw->crc;
 	ap_ic_crc = tp_ic_bcc_check(&((int *)(thp_frame->thp_frame_buf))[5], crc_check_size / 4 - 5);
@@ -1230,13 +1634,24 @@ int syna_tcm_report_thp_frame(struct syna_tcm *tcm_hcd, s64 irq_start_time)
 		tp_raw->crc = ap_thp_crc;
 		tp_raw->crc_r = -(ap_thp_crc + 1);
 	} else {
+		tcm_hcd->thp_crc_errors++;
 		tp_raw->crc = ap_thp_crc + 10;
 		tp_raw->crc_r = -(ap_thp_crc + 10 + 1);
 	}
 #endif
+	add_input_event_timeline_before_event_time(0, thp_frame->frm_cnt, irq_start_time, ktime_get());
+	notify_raw_data_update(TOUCH_ID);
 	return 0;
 }
 
+int syna_tcm_thp_frame_show(struct syna_tcm *tcm_hcd, char *buf, int size)
+{
+	return scnprintf(buf, size,
+			"in_slot: %llu\ncopied: %llu\ncrc_errors: %llu\n",
+			tcm_hcd->thp_frames_in_slot, tcm_hcd->thp_frames_copied,
+			tcm_hcd->thp_crc_errors);
+}
+
 #endif
 
 int syna_tcm_set_gesture_type(struct syna_tcm *tcm, u8 val)
@@ -1429,7 +1844,13 @@ static void syna_tcm_set_charge_state(int state)
 			}
 	}
 	val = state & 0x01; /* Default Value: 0, disconnected: 1, connected */
+#ifdef TOUCH_THP_SUPPORT
+	syna_mf_queue_hold(tcm);
+#endif
 	retval = syna_tcm_set_dynamic_config(tcm->tcm_dev, DC_ENABLE_CHARGER_CONNECTED, val, RESP_IN_ATTN);
+#ifdef TOUCH_THP_SUPPORT
+	syna_mf_queue_release(tcm);
+#endif
 	if (retval < 0) {
 		LOGE("Failed to set charge mode\n");
 	} else {
@@ -1769,6 +2190,14 @@ void syna_xiaomi_touch_probe(struct syna_tcm *syna_tcm)
 	syna_get_config();
 
 	INIT_DELAYED_WORK(&tcm->signal_work, syna_tmd_signal_work);
+#ifdef TOUCH_THP_SUPPORT
+	mutex_init(&tcm->mf_queue.lock);
+	mutex_init(&tcm->mf_queue.flush_lock);
+	INIT_WORK(&tcm->mf_queue.work, syna_mf_queue_work);
+	mutex_init(&tcm->report_rate_lock);
+	syna_tcm_set_report_dest_callback(tcm->tcm_dev,
+			syna_tcm_thp_slot_dest, (void *)tcm);
+#endif
 
 	hardware_param.x_resolution = xiaomi_bdata.max_x;
 	hardware_param.y_resolution = xiaomi_bdata.max_y;
@@ -1823,6 +2252,7 @@ void syna_xiaomi_touch_probe(struct syna_tcm *syna_tcm)
 	hardware_operation.ic_switch_mode = syna_tcm_switch_mode;
 	hardware_operation.ic_enable_irq = syna_tcm_enable_irq;
 	hardware_operation.ic_set_charge_state = syna_tcm_set_charge_state;
+	hardware_operation.ic_set_panel_fps = syna_tcm_set_panel_fps;
 #endif
 	register_touch_panel(&spi->dev, TOUCH_ID, &hardware_param, &hardware_operation);
 #if defined(TOUCH_PLATFORM_XRING)
@@ -1857,6 +2287,14 @@ void syna_xiaomi_touch_remove(struct syna_tcm *syna_tcm)
 	struct spi_device *spi_dev = syna_tcm->hw_if->pdev;
 
 	cancel_delayed_work_sync(&tcm->signal_work);
+#ifdef TOUCH_THP_SUPPORT
+	syna_tcm_set_report_dest_callback(tcm->tcm_dev, NULL, NULL);
+	cancel_work_sync(&tcm->mf_queue.work);
+#endif
 	xiaomi_unregister_panel_notifier(&spi_dev->dev, TOUCH_ID);
 	unregister_touch_panel(TOUCH_ID);
 }
+
+#if IS_ENABLED(CONFIG_TOUCHSCREEN_KUNIT_TEST)
+#include "../touch_kunit/tests/syna_xiaomi_mf_test.c"
+#endif
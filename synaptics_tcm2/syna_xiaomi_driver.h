@@ -8,6 +8,9 @@
 
 
 #define SYNA_DISPLAY_RESOLUTION_ARRAY       "synaptics,panel-display-resolution"
+#define SYNA_REPORT_RATE_TABLE              "synaptics,report-rate-table"
+#define SYNA_REPORT_RATE_MAX_NUM            16
+#define SYNA_REPORT_RATE_DEFAULT            120
 #define SYNAPTICS_DEBUGFS_ENABLE
 
 #ifdef SYNAPTICS_DEBUGFS_ENABLE
@@ -87,6 +90,8 @@ typedef struct {
 	int raw_data_page_size;
 	int raw_data_buf_size;
 	int super_resolution_factor;
+	u32 report_rate_table[SYNA_REPORT_RATE_MAX_NUM];
+	int report_rate_num;
 	size_t config_array_size;
 	struct synaptics_config_info *config_array;
 	const char *synaptics_default_cfg_name;
@@ -61,6 +61,9 @@
  *
  * @brief: MAX_NUM_KNOB_OBJECTS
  *         Maximum size of knob objects
+ *
+ * @brief: MAX_NUM_TOUCH_DECODER_ENTRIES
+ *         Maximum entries of the compiled touch report decoder
  */
 #define MAX_NUM_OBJECTS (10)
 
@@ -70,6 +73,8 @@
 
 #define MAX_NUM_KNOB_OBJECTS (2)
 
+#define MAX_NUM_TOUCH_DECODER_ENTRIES (64)
+
 /**
  * @section: Command-handling relevant definitions
  *
@@ -626,6 +631,56 @@ struct tcm_touch_data_blob {
 	struct tcm_knob_data_blob knob[MAX_NUM_KNOB_OBJECTS];
 };
 
+/**
+ * @section: Compiled touch report decoder
+ *
+ * Once the touch report configuration is retrieved, it is translated into
+ * a flat table so that the report parsing doesn't have to interpret the
+ * configuration codes for every frame.
+ *
+ * The table is split into three sections, entities before the object loop,
+ * entities inside the object loop and entities after the loop. The bit
+ * offset of each entry is relative to the beginning of its section.
+ *
+ * @subsection: tcm_touch_decoder_type
+ *              The way to store the data parsed
+ *
+ * @subsection: tcm_touch_decoder_entry
+ *              The entity offset, bit length and destination
+ *
+ * @subsection: tcm_touch_decoder
+ *              The table and the layout of object loop
+ */
+enum tcm_touch_decoder_type {
+	TOUCH_DECODER_FIELD = 0,
+	TOUCH_DECODER_OBJECT_FIELD,
+	TOUCH_DECODER_OBJECT_STATUS,
+	TOUCH_DECODER_OBJECT_INDEX,
+	TOUCH_DECODER_ACTIVE_OBJECTS,
+	TOUCH_DECODER_GESTURE_DATA,
+	TOUCH_DECODER_KNOB_DATA,
+	TOUCH_DECODER_KNOB_CALIB,
+};
+struct tcm_touch_decoder_entry {
+	unsigned int offset;
+	unsigned short dest;
+	unsigned char bits;
+	unsigned char type;
+};
+struct tcm_touch_decoder {
+	bool compiled;
+	bool active_only;
+	bool has_active_objects;
+	bool has_gesture;
+	bool has_custom_entity;
+	unsigned int loop_offset;
+	unsigned int loop_stride;
+	unsigned int num_of_head;
+	unsigned int num_of_loop;
+	unsigned int num_of_tail;
+	struct tcm_touch_decoder_entry entry[MAX_NUM_TOUCH_DECODER_ENTRIES];
+};
+
 /**
  * @section: Callback function used to parse custom touch entity
  *
@@ -690,6 +745,27 @@ typedef int (*tcm_custom_gesture_callback_t) (const unsigned char code,
  */
 typedef void (*tcm_reset_occurrence_callback_t) (void *callback_data);
 
+/**
+ * @section: Callback function used to place the report payload
+ *
+ * Allow the caller to provide the buffer where the payload of a report
+ * is stored, instead of the internal buffer.report.
+ * If the payload could not be stored, the callback is called once more
+ * with length 0 to give the buffer back, and the payload goes to the
+ * internal buffer.report instead.
+ *
+ * @param
+ *    [ in]    code:          the report code
+ *    [ in]    length:        length of report payload, or 0 to release
+ *    [ in]    callback_data: pointer to caller data
+ *
+ * @return
+ *    a buffer holding at least length bytes;
+ *    or, NULL to keep the payload in the internal buffer.report.
+ */
+typedef unsigned char *(*tcm_report_dest_callback_t) (unsigned char code,
+		unsigned int length, void *callback_data);
+
 /**
  * @section: TouchComm Message Handling Wrapper
  *
@@ -706,6 +782,8 @@ struct tcm_message_data_blob {
 	unsigned char response_code;
 	unsigned char report_code;
 	unsigned char seq_toggle;
+	/* the last report was stored into the cb_report_dest buffer */
+	bool report_in_dest;
 	unsigned int default_resp_reading;
 
 	/* completion event for command processing */
@@ -798,6 +876,7 @@ struct tcm_dev {
 	unsigned int end_config_loop;
 	unsigned int bits_config_loop;
 	unsigned int bits_config_tailing;
+	struct tcm_touch_decoder touch_decoder;
 
 	/* TouchComm message handling wrapper */
 	struct tcm_message_data_blob msg_data;
@@ -866,6 +945,7 @@ struct tcm_dev {
 	 *   cb_custom_touch_entity: callback to parse custom touch entity
 	 *   cb_custom_gesture : callback to parse custom gesture
 	 *   cb_reset_occurrence : callback once reset occurrence
+	 *   cb_report_dest : callback to provide the buffer for a report
 	 */
 	tcm_custom_touch_entity_callback_t cb_custom_touch_entity;
 	void *cbdata_touch_entity;
@@ -873,6 +953,8 @@ struct tcm_dev {
 	void *cbdata_gesture;
 	tcm_reset_occurrence_callback_t cb_reset_occurrence;
 	void *cbdata_reset;
+	tcm_report_dest_callback_t cb_report_dest;
+	void *cbdata_report_dest;
 	struct completion fw_update_completion;
 };
 /* end of structure syna_tcm_dev */
@@ -1254,6 +1336,39 @@ static inline int syna_tcm_read(struct tcm_dev *tcm_dev,
 	return hw_if->ops_read_data(hw_if, rd_data, rd_len);
 }
 
+/**
+ * syna_tcm_read_direct()
+ *
+ * Same as syna_tcm_read(), but the data is placed into the given
+ * buffer without a bounce copy when the bus supports it.
+ * The buffer must come from the heap and hold rd_len bytes.
+ *
+ * @param
+ *    [ in] tcm_dev: the device handle
+ *    [out] rd_data: DMA-safe buffer for storing data retrieved
+ *    [ in] rd_len:  length of reading data in bytes
+ *
+ * @return
+ *    the number of data bytes retrieved;
+ *    otherwise, negative value, on error.
+ */
+static inline int syna_tcm_read_direct(struct tcm_dev *tcm_dev,
+	unsigned char *rd_data, unsigned int rd_len)
+{
+	struct syna_hw_interface *hw_if;
+
+	if (!tcm_dev) {
+		LOGE("Invalid tcm device handle\n");
+		return -ERR_INVAL;
+	}
+
+	hw_if = tcm_dev->hw_if;
+	if (!hw_if->ops_read_data_direct)
+		return syna_tcm_read(tcm_dev, rd_data, rd_len);
+
+	return hw_if->ops_read_data_direct(hw_if, rd_data, rd_len);
+}
+
 /**
  * syna_tcm_write()
  *
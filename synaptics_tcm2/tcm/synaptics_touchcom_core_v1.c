@@ -440,7 +440,8 @@ exit:
  *    [ in] tcm_dev:    the device handle
  *    [ in] rd_length:  number of reading bytes;
  *                      '0' means to read the message header only
- *    [in/out] buf:     pointer to a buffer which is stored the retrieved data
+ *    [in/out] buf:     pointer to a buffer which is stored the retrieved data,
+ *                      a heap buffer read into without a bounce copy
  *    [out] buf_size:   size of the buffer pointed
  *    [ in] extra_crc:  flag to read in extra crc bytes
  *
@@ -480,7 +481,7 @@ static int syna_tcm_v1_read(struct tcm_dev *tcm_dev, unsigned int rd_length,
 	 * will do retry if the packet is not expected
 	 */
 	for (retry = 0; retry < 20; retry++) {
-		retval = syna_tcm_read(tcm_dev,
+		retval = syna_tcm_read_direct(tcm_dev,
 				buf,
 				rd_length
 				);
@@ -220,7 +220,8 @@ static int syna_tcm_v2_parse_idinfo(struct tcm_dev *tcm_dev,
  *
  * If it's an identify report, parse the identification packet and signal
  * the command completion just in case.
- * Otherwise, copy the data from internal buffer.in to internal buffer.report
+ * Otherwise, copy the data from internal buffer.in to internal buffer.report,
+ * or to the buffer given by cb_report_dest if the caller provides one.
  *
  * @param
  *    [ in] tcm_dev: the device handle
@@ -231,6 +232,7 @@ static int syna_tcm_v2_parse_idinfo(struct tcm_dev *tcm_dev,
 static void syna_tcm_v2_dispatch_report(struct tcm_dev *tcm_dev)
 {
 	int retval;
+	unsigned char *dest;
 	struct tcm_message_data_blob *tcm_msg = NULL;
 	syna_pal_completion_t *cmd_completion = NULL;
 
@@ -243,6 +245,7 @@ static void syna_tcm_v2_dispatch_report(struct tcm_dev *tcm_dev)
 	cmd_completion = &tcm_msg->cmd_completion;
 
 	tcm_msg->report_code = tcm_msg->status_report_code;
+	tcm_msg->report_in_dest = false;
 
 	if (tcm_msg->payload_length == 0) {
 		tcm_dev->report_buf.data_length = tcm_msg->payload_length;
@@ -250,6 +253,48 @@ static void syna_tcm_v2_dispatch_report(struct tcm_dev *tcm_dev)
 		goto exit;
 	}
 
+	/* store the report into the caller's buffer, if one is given */
+	if (tcm_dev->cb_report_dest &&
+		(tcm_msg->report_code != REPORT_IDENTIFY)) {
+		dest = tcm_dev->cb_report_dest(tcm_msg->report_code,
+				tcm_msg->payload_length,
+				tcm_dev->cbdata_report_dest);
+		if (dest) {
+			syna_tcm_buf_lock(&tcm_msg->in);
+
+			retval = syna_pal_mem_cpy(dest,
+					tcm_msg->payload_length,
+					&tcm_msg->in.buf[MESSAGE_HEADER_SIZE],
+					tcm_msg->in.buf_size - MESSAGE_HEADER_SIZE,
+					tcm_msg->payload_length);
+
+			syna_tcm_buf_unlock(&tcm_msg->in);
+
+			if (retval < 0) {
+				LOGE("Fail to copy payload to report dest\n");
+				/* give the buffer back, keep the report */
+				tcm_dev->cb_report_dest(tcm_msg->report_code, 0,
+						tcm_dev->cbdata_report_dest);
+				goto store_report;
+			}
+
+			tcm_msg->report_in_dest = true;
+
+			syna_tcm_buf_lock(&tcm_dev->report_buf);
+			tcm_dev->report_buf.data_length = 0;
+			syna_tcm_buf_unlock(&tcm_dev->report_buf);
+
+			if (tcm_msg->command == CMD_TCM2_GET_REPORT) {
+				tcm_msg->response_code = STATUS_OK;
+				ATOMIC_SET(tcm_msg->command_status,
+					CMD_STATE_IDLE);
+				syna_pal_completion_complete(cmd_completion);
+			}
+			goto exit;
+		}
+	}
+
+store_report:
 	/* store the received report into the internal buffer.report */
 	syna_tcm_buf_lock(&tcm_dev->report_buf);
 
@@ -502,7 +547,7 @@ static int syna_tcm_v2_read(struct tcm_dev *tcm_dev, unsigned int rd_length,
 		goto exit;
 	}
 	/* read data from the bus */
-	retval = syna_tcm_read(tcm_dev,
+	retval = syna_tcm_read_direct(tcm_dev,
 			tcm_msg->temp.buf,
 			xfer_len);
 	if (retval < 0) {
@@ -1176,8 +1221,29 @@ static int syna_tcm_v2_read_message(struct tcm_dev *tcm_dev,
 		goto exit;
 	}
 
-	/* duplicate the data to external buffer */
+	tcm_msg->report_in_dest = false;
+
+	/* process the retrieved packet */
+	if (tcm_msg->response_code != STATUS_NO_REPORT_AVAILABLE) {
+		if (tcm_msg->status_report_code >= REPORT_IDENTIFY)
+			syna_tcm_v2_dispatch_report(tcm_dev);
+		else
+			syna_tcm_v2_dispatch_response(tcm_dev);
+
+		/* copy the status report code to caller */
+		if (status_report_code)
+			*status_report_code = tcm_msg->status_report_code;
+	}
+
+	/* duplicate the data to external buffer, unless the report
+	 * already went to the caller's buffer
+	 */
 	syna_tcm_buf_lock(&tcm_dev->external_buf);
+	if (tcm_msg->report_in_dest) {
+		tcm_dev->external_buf.data_length = 0;
+		syna_tcm_buf_unlock(&tcm_dev->external_buf);
+		goto exit;
+	}
 	if (tcm_msg->payload_length > 0) {
 		retval = syna_tcm_buf_alloc(&tcm_dev->external_buf,
 				tcm_msg->payload_length);
@@ -1201,19 +1267,6 @@ static int syna_tcm_v2_read_message(struct tcm_dev *tcm_dev,
 	tcm_dev->external_buf.data_length = tcm_msg->payload_length;
 	syna_tcm_buf_unlock(&tcm_dev->external_buf);
 
-	if (tcm_msg->response_code == STATUS_NO_REPORT_AVAILABLE)
-		goto exit;
-
-	/* process the retrieved packet */
-	if (tcm_msg->status_report_code >= REPORT_IDENTIFY)
-		syna_tcm_v2_dispatch_report(tcm_dev);
-	else
-		syna_tcm_v2_dispatch_response(tcm_dev);
-
-	/* copy the status report code to caller */
-	if (status_report_code)
-		*status_report_code = tcm_msg->status_report_code;
-
 exit:
 	syna_pal_mutex_unlock(rw_mutex);
 
@@ -245,6 +245,8 @@ int syna_tcm_allocate_device(struct tcm_dev **ptcm_dev_ptr,
 	tcm_dev->cbdata_gesture = NULL;
 	tcm_dev->cb_reset_occurrence = NULL;
 	tcm_dev->cbdata_reset = NULL;
+	tcm_dev->cb_report_dest = NULL;
+	tcm_dev->cbdata_report_dest = NULL;
 
 	tcm_dev->dev_mode = MODE_UNKNOWN;
 
@@ -1899,6 +1901,38 @@ int syna_tcm_set_reset_occurrence_callback(struct tcm_dev *tcm_dev,
 	return 0;
 }
 
+/**
+ * syna_tcm_set_report_dest_callback()
+ *
+ * Set up callback function to provide the buffer a report is stored in.
+ *
+ * The payload placed by this callback is not copied to buffer.report, so
+ * syna_tcm_get_event_data() returns no data for such a report.
+ *
+ * @param
+ *    [ in] tcm_dev:  the device handle
+ *    [ in] p_cb:     the pointer of callback function, NULL to disable
+ *    [ in] p_cbdata: pointer to caller data
+ *
+ * @return
+ *    on success, 0 or positive value; otherwise, negative value on error.
+ */
+int syna_tcm_set_report_dest_callback(struct tcm_dev *tcm_dev,
+		tcm_report_dest_callback_t p_cb, void *p_cbdata)
+{
+	if (!tcm_dev) {
+		LOGE("Invalid tcm device handle\n");
+		return -ERR_INVAL;
+	}
+
+	tcm_dev->cb_report_dest = p_cb;
+	tcm_dev->cbdata_report_dest = p_cbdata;
+
+	LOGI("report dest callback %s\n", (p_cb) ? "enabled" : "disabled");
+
+	return 0;
+}
+
 /**
  * syna_tcm_smart_bridge_reset()
  *
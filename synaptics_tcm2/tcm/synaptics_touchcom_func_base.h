@@ -458,6 +458,21 @@ int syna_tcm_enable_predict_reading(struct tcm_dev *tcm_dev, bool en);
  */
 int syna_tcm_set_reset_occurrence_callback(struct tcm_dev *tcm_dev,
 		tcm_reset_occurrence_callback_t p_cb, void *p_cbdata);
+/**
+ * syna_tcm_set_report_dest_callback()
+ *
+ * Set up callback function to provide the buffer a report is stored in.
+ *
+ * @param
+ *    [ in] tcm_dev:  the device handle
+ *    [ in] p_cb:     the pointer of callback function, NULL to disable
+ *    [ in] p_cbdata: pointer to caller data
+ *
+ * @return
+ *    on success, 0 or positive value; otherwise, negative value on error.
+ */
+int syna_tcm_set_report_dest_callback(struct tcm_dev *tcm_dev,
+		tcm_report_dest_callback_t p_cb, void *p_cbdata);
 /**
  * syna_tcm_smart_bridge_reset()
  *
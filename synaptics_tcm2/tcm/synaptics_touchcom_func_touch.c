@@ -366,6 +366,566 @@ static int syna_tcm_get_gesture_data(const unsigned char *report,
 	return 0;
 }
 
+/**
+ * @section: Sections of compiled touch report decoder
+ *
+ * The entities before the object loop, inside the loop and after the loop.
+ */
+enum tcm_touch_decoder_section {
+	DECODER_SECTION_HEAD = 0,
+	DECODER_SECTION_LOOP,
+	DECODER_SECTION_TAIL,
+};
+
+#define TOUCH_DATA_FIELD(_field) \
+	offsetof(struct tcm_touch_data_blob, _field)
+#define OBJECT_DATA_FIELD(_field) \
+	offsetof(struct tcm_objects_data_blob, _field)
+
+/**
+ * syna_tcm_set_touch_decoder_entry()
+ *
+ * Map the code entity in touch report configuration to the entry of
+ * compiled decoder, which describes where the parsed data is stored.
+ *
+ * @param
+ *    [ in] code:  the code entity in touch report configuration
+ *    [ in] bits:  number of bits representing the data
+ *    [out] entry: the decoder entry to fill
+ *
+ * @return
+ *    1 if the code is mapped; 0 if the code is unknown;
+ *    otherwise, negative value if the entity can't be compiled.
+ */
+static int syna_tcm_set_touch_decoder_entry(unsigned char code,
+		unsigned char bits, struct tcm_touch_decoder_entry *entry)
+{
+	entry->bits = bits;
+	entry->dest = 0;
+
+	switch (code) {
+	case TOUCH_REPORT_GESTURE_DATA:
+		entry->type = TOUCH_DECODER_GESTURE_DATA;
+		return 1;
+	case TOUCH_REPORT_KNOB_DATA:
+		entry->type = TOUCH_DECODER_KNOB_DATA;
+		return 1;
+	case TOUCH_REPORT_KNOB_CALIB:
+		entry->type = TOUCH_DECODER_KNOB_CALIB;
+		return 1;
+	default:
+		break;
+	}
+
+	/* the remaining entities are no more than 32 bits */
+	if (bits == 0 || bits > 32)
+		return -ERR_INVAL;
+
+	switch (code) {
+	case TOUCH_REPORT_OBJECT_N_INDEX:
+		entry->type = TOUCH_DECODER_OBJECT_INDEX;
+		break;
+	case TOUCH_REPORT_NUM_OF_ACTIVE_OBJECTS:
+		entry->type = TOUCH_DECODER_ACTIVE_OBJECTS;
+		break;
+	case TOUCH_REPORT_OBJECT_N_CLASSIFICATION:
+		entry->type = TOUCH_DECODER_OBJECT_STATUS;
+		break;
+	case TOUCH_REPORT_OBJECT_N_X_POSITION:
+		entry->type = TOUCH_DECODER_OBJECT_FIELD;
+		entry->dest = OBJECT_DATA_FIELD(x_pos);
+		break;
+	case TOUCH_REPORT_OBJECT_N_Y_POSITION:
+		entry->type = TOUCH_DECODER_OBJECT_FIELD;
+		entry->dest = OBJECT_DATA_FIELD(y_pos);
+		break;
+	case TOUCH_REPORT_OBJECT_N_Z:
+		entry->type = TOUCH_DECODER_OBJECT_FIELD;
+		entry->dest = OBJECT_DATA_FIELD(z);
+		break;
+	case TOUCH_REPORT_OBJECT_N_X_WIDTH:
+		entry->type = TOUCH_DECODER_OBJECT_FIELD;
+		entry->dest = OBJECT_DATA_FIELD(x_width);
+		break;
+	case TOUCH_REPORT_OBJECT_N_Y_WIDTH:
+		entry->type = TOUCH_DECODER_OBJECT_FIELD;
+		entry->dest = OBJECT_DATA_FIELD(y_width);
+		break;
+	case TOUCH_REPORT_OBJECT_N_TX_POSITION_TIXELS:
+		entry->type = TOUCH_DECODER_OBJECT_FIELD;
+		entry->dest = OBJECT_DATA_FIELD(tx_pos);
+		break;
+	case TOUCH_REPORT_OBJECT_N_RX_POSITION_TIXELS:
+		entry->type = TOUCH_DECODER_OBJECT_FIELD;
+		entry->dest = OBJECT_DATA_FIELD(rx_pos);
+		break;
+	case TOUCH_REPORT_TIMESTAMP:
+		entry->type = TOUCH_DECODER_FIELD;
+		entry->dest = TOUCH_DATA_FIELD(timestamp);
+		break;
+	case TOUCH_REPORT_0D_BUTTONS_STATE:
+		entry->type = TOUCH_DECODER_FIELD;
+		entry->dest = TOUCH_DATA_FIELD(buttons_state);
+		break;
+	case TOUCH_REPORT_GESTURE_ID:
+		entry->type = TOUCH_DECODER_FIELD;
+		entry->dest = TOUCH_DATA_FIELD(gesture_id);
+		break;
+	case TOUCH_REPORT_FRAME_RATE:
+		entry->type = TOUCH_DECODER_FIELD;
+		entry->dest = TOUCH_DATA_FIELD(frame_rate);
+		break;
+	case TOUCH_REPORT_FORCE_MEASUREMENT:
+		entry->type = TOUCH_DECODER_FIELD;
+		entry->dest = TOUCH_DATA_FIELD(force_data);
+		break;
+	case TOUCH_REPORT_FINGERPRINT_AREA_MEET:
+		entry->type = TOUCH_DECODER_FIELD;
+		entry->dest = TOUCH_DATA_FIELD(fingerprint_area_meet);
+		break;
+	case TOUCH_REPORT_POWER_IM:
+		entry->type = TOUCH_DECODER_FIELD;
+		entry->dest = TOUCH_DATA_FIELD(power_im);
+		break;
+	case TOUCH_REPORT_CID_IM:
+		entry->type = TOUCH_DECODER_FIELD;
+		entry->dest = TOUCH_DATA_FIELD(cid_im);
+		break;
+	case TOUCH_REPORT_RAIL_IM:
+		entry->type = TOUCH_DECODER_FIELD;
+		entry->dest = TOUCH_DATA_FIELD(rail_im);
+		break;
+	case TOUCH_REPORT_CID_VARIANCE_IM:
+		entry->type = TOUCH_DECODER_FIELD;
+		entry->dest = TOUCH_DATA_FIELD(cid_variance_im);
+		break;
+	case TOUCH_REPORT_NSM_FREQUENCY_INDEX:
+		entry->type = TOUCH_DECODER_FIELD;
+		entry->dest = TOUCH_DATA_FIELD(nsm_frequency);
+		break;
+	case TOUCH_REPORT_NSM_STATE:
+		entry->type = TOUCH_DECODER_FIELD;
+		entry->dest = TOUCH_DATA_FIELD(nsm_state);
+		break;
+	case TOUCH_REPORT_CPU_CYCLES_USED_SINCE_LAST_FRAME:
+		entry->type = TOUCH_DECODER_FIELD;
+		entry->dest = TOUCH_DATA_FIELD(num_of_cpu_cycles);
+		break;
+	case TOUCH_REPORT_FACE_DETECT:
+		entry->type = TOUCH_DECODER_FIELD;
+		entry->dest = TOUCH_DATA_FIELD(fd_data);
+		break;
+	case TOUCH_REPORT_SENSING_MODE:
+		entry->type = TOUCH_DECODER_FIELD;
+		entry->dest = TOUCH_DATA_FIELD(sensing_mode);
+		break;
+	default:
+		return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * syna_tcm_compile_touch_report_config()
+ *
+ * Translate the touch report configuration into the flat decoder table.
+ *
+ * The bit offset of every entity is resolved here, so the report parsing
+ * only walks through the table. Configurations whose layout can't be
+ * resolved in advance, such as padding that depends on the number of
+ * objects reported, are left to the generic parser.
+ *
+ * @param
+ *    [ in] tcm_dev: the device handle
+ *
+ * @return
+ *    none.
+ */
+static void syna_tcm_compile_touch_report_config(struct tcm_dev *tcm_dev)
+{
+	int retval;
+	unsigned char code;
+	unsigned char bits;
+	unsigned int idx;
+	unsigned int size;
+	unsigned int offset;
+	unsigned int count;
+	unsigned int skip_offset;
+	unsigned char *config;
+	bool pad_in_loop;
+	bool pad_in_tail;
+	bool aligned;
+	enum tcm_touch_decoder_section section;
+	struct tcm_touch_decoder *decoder = &tcm_dev->touch_decoder;
+	struct tcm_touch_decoder_entry *entry;
+
+	decoder->compiled = false;
+	decoder->active_only = false;
+	decoder->has_active_objects = false;
+	decoder->has_gesture = false;
+	decoder->has_custom_entity = false;
+
+	config = tcm_dev->touch_config.buf;
+	size = tcm_dev->touch_config.data_length;
+
+	idx = 0;
+	offset = 0;
+	count = 0;
+	skip_offset = 0;
+	pad_in_loop = false;
+	pad_in_tail = false;
+	section = DECODER_SECTION_HEAD;
+
+	while (idx < size) {
+		code = config[idx++];
+
+		if (code == TOUCH_REPORT_END)
+			break;
+
+		switch (code) {
+		case TOUCH_REPORT_FOREACH_ACTIVE_OBJECT:
+		case TOUCH_REPORT_FOREACH_OBJECT:
+			if (section != DECODER_SECTION_HEAD)
+				goto not_supported;
+			decoder->active_only =
+				(code == TOUCH_REPORT_FOREACH_ACTIVE_OBJECT);
+			decoder->loop_offset = offset;
+			decoder->num_of_head = count;
+			section = DECODER_SECTION_LOOP;
+			offset = 0;
+			break;
+		case TOUCH_REPORT_FOREACH_END:
+			if (section != DECODER_SECTION_LOOP)
+				goto not_supported;
+			decoder->loop_stride = offset;
+			decoder->num_of_loop = count - decoder->num_of_head;
+			section = DECODER_SECTION_TAIL;
+			offset = 0;
+			break;
+		case TOUCH_REPORT_PAD_TO_NEXT_BYTE:
+			if (section == DECODER_SECTION_LOOP)
+				pad_in_loop = true;
+			if (section == DECODER_SECTION_TAIL)
+				pad_in_tail = true;
+			offset = syna_pal_ceil_div(offset, 8) * 8;
+			break;
+		default:
+			if (idx >= size)
+				goto not_supported;
+
+			bits = config[idx++];
+
+			if (count >= MAX_NUM_TOUCH_DECODER_ENTRIES)
+				goto not_supported;
+
+			entry = &decoder->entry[count];
+			retval = syna_tcm_set_touch_decoder_entry(code, bits,
+					entry);
+			if (retval < 0)
+				goto not_supported;
+
+			if (retval == 0) {
+				/* skipped, or handled by custom callback */
+				decoder->has_custom_entity = true;
+				offset += bits;
+				break;
+			}
+
+			if ((code == TOUCH_REPORT_GESTURE_ID) ||
+				(code == TOUCH_REPORT_GESTURE_DATA))
+				decoder->has_gesture = true;
+
+			if (entry->type == TOUCH_DECODER_ACTIVE_OBJECTS) {
+				if (section != DECODER_SECTION_HEAD)
+					goto not_supported;
+				decoder->has_active_objects = true;
+				skip_offset = offset + bits;
+			}
+
+			entry->offset = offset;
+			offset += bits;
+			count++;
+			break;
+		}
+	}
+
+	if (section != DECODER_SECTION_TAIL)
+		goto not_supported;
+
+	decoder->num_of_tail = count - decoder->num_of_head -
+		decoder->num_of_loop;
+
+	/* padding is resolvable only if every object starts byte-aligned */
+	aligned = ((decoder->loop_offset % 8) == 0) &&
+		((decoder->loop_stride % 8) == 0);
+
+	if (pad_in_loop && !aligned)
+		goto not_supported;
+
+	if (pad_in_tail) {
+		if (!aligned)
+			goto not_supported;
+		if (decoder->has_active_objects && (skip_offset % 8))
+			goto not_supported;
+	}
+
+	decoder->compiled = true;
+
+	LOGI("Touch report decoder compiled, entries:%d (%d/%d/%d)\n",
+		count, decoder->num_of_head, decoder->num_of_loop,
+		decoder->num_of_tail);
+
+	return;
+
+not_supported:
+	LOGI("Touch report config not compiled, use generic parser\n");
+}
+
+/**
+ * syna_tcm_decode_touch_value()
+ *
+ * Get data entity from the touch report. The byte-aligned entities in
+ * 8, 16 or 32 bits are fetched directly.
+ *
+ * @param
+ *    [ in] report:      touch report generated by TouchComm device
+ *    [ in] report_size: size of given report
+ *    [ in] offset:      bit offset in the report
+ *    [ in] bits:        number of bits representing the data
+ *
+ * @return
+ *    the data parsed.
+ */
+static inline unsigned int syna_tcm_decode_touch_value(
+		const unsigned char *report, unsigned int report_size,
+		unsigned int offset, unsigned int bits)
+{
+	unsigned int data;
+
+	if (offset + bits > report_size * 8)
+		return 0;
+
+	if ((offset & 0x7) == 0) {
+		switch (bits) {
+		case 8:
+			return report[offset >> 3];
+		case 16:
+			return syna_pal_le2_to_uint(&report[offset >> 3]);
+		case 32:
+			return syna_pal_le4_to_uint(&report[offset >> 3]);
+		default:
+			break;
+		}
+	}
+
+	syna_tcm_get_touch_data(report, report_size, offset, bits, &data);
+
+	return data;
+}
+
+/**
+ * syna_tcm_decode_touch_entries()
+ *
+ * Parse the touch report by a section of compiled decoder table.
+ *
+ * @param
+ *    [ in]    entry:       the first entry of the section
+ *    [ in]    count:       number of entries in the section
+ *    [ in]    base:        bit offset where the section begins
+ *    [ in]    report:      touch report generated by TouchComm device
+ *    [ in]    report_size: size of given report
+ *    [out]    touch_data:  touch data generated
+ *    [in/out] obj:         index of current object
+ *    [out]    skip_offset: bit offset to continue if no active objects
+ *
+ * @return
+ *    0 on success; 1 if no active object is reported;
+ *    otherwise, negative value on error.
+ */
+static int syna_tcm_decode_touch_entries(
+		const struct tcm_touch_decoder_entry *entry, unsigned int count,
+		unsigned int base, const unsigned char *report,
+		unsigned int report_size, struct tcm_touch_data_blob *touch_data,
+		unsigned int *obj, unsigned int *skip_offset)
+{
+	int retval;
+	unsigned int idx;
+	unsigned int data;
+	unsigned int offset;
+	unsigned char *object;
+
+	for (idx = 0; idx < count; idx++, entry++) {
+		offset = base + entry->offset;
+
+		switch (entry->type) {
+		case TOUCH_DECODER_GESTURE_DATA:
+			retval = syna_tcm_get_gesture_data(report, report_size,
+					offset, entry->bits,
+					&touch_data->gesture_data,
+					touch_data->gesture_id);
+			if (retval < 0) {
+				LOGE("Fail to get gesture data\n");
+				return retval;
+			}
+			continue;
+		case TOUCH_DECODER_KNOB_DATA:
+			retval = syna_tcm_get_knob_data(report, report_size,
+					offset, entry->bits, touch_data->knob);
+			if (retval < 0) {
+				LOGE("Fail to get knob data\n");
+				return retval;
+			}
+			continue;
+		case TOUCH_DECODER_KNOB_CALIB:
+			retval = syna_tcm_get_knob_calib_data(report,
+					report_size, offset, entry->bits,
+					touch_data->knob);
+			if (retval < 0) {
+				LOGE("Fail to get knob calibration data\n");
+				return retval;
+			}
+			continue;
+		default:
+			break;
+		}
+
+		data = syna_tcm_decode_touch_value(report, report_size,
+				offset, entry->bits);
+
+		switch (entry->type) {
+		case TOUCH_DECODER_FIELD:
+			*(unsigned int *)((unsigned char *)touch_data +
+				entry->dest) = data;
+			break;
+		case TOUCH_DECODER_OBJECT_FIELD:
+			if (*obj >= MAX_NUM_OBJECTS)
+				break;
+			object = (unsigned char *)&touch_data->object_data[*obj];
+			*(unsigned int *)(object + entry->dest) = data;
+			break;
+		case TOUCH_DECODER_OBJECT_STATUS:
+			if (*obj >= MAX_NUM_OBJECTS)
+				break;
+			touch_data->object_data[*obj].status =
+				(unsigned char)data;
+			break;
+		case TOUCH_DECODER_OBJECT_INDEX:
+			*obj = data;
+			touch_data->obji = data;
+			break;
+		case TOUCH_DECODER_ACTIVE_OBJECTS:
+			touch_data->num_of_active_objects = data;
+			if (data == 0) {
+				*skip_offset = offset + entry->bits;
+				return 1;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * syna_tcm_run_touch_decoder()
+ *
+ * Parse the touch report by the compiled decoder table. The result is
+ * the same as traversing through the touch report configuration.
+ *
+ * @param
+ *    [ in] tcm_dev:     the device handle
+ *    [ in] report:      touch report generated by TouchComm device
+ *    [ in] report_size: size of given report
+ *    [out] touch_data:  touch data generated
+ *
+ * @return
+ *    on success, 0 or positive value; otherwise, negative value on error.
+ */
+static int syna_tcm_run_touch_decoder(struct tcm_dev *tcm_dev,
+		const unsigned char *report, unsigned int report_size,
+		struct tcm_touch_data_blob *touch_data)
+{
+	int retval;
+	unsigned int obj = 0;
+	unsigned int offset = 0;
+	unsigned int report_bits = report_size * 8;
+	struct tcm_touch_decoder *decoder = &tcm_dev->touch_decoder;
+	const struct tcm_touch_decoder_entry *entry = decoder->entry;
+
+	retval = syna_tcm_decode_touch_entries(entry, decoder->num_of_head,
+			0, report, report_size, touch_data, &obj, &offset);
+	if (retval < 0)
+		return retval;
+
+	entry += decoder->num_of_head;
+
+	/* skip the object loop if there is no active object */
+	if (retval == 0) {
+		obj = 0;
+		offset = decoder->loop_offset;
+		while (1) {
+			retval = syna_tcm_decode_touch_entries(entry,
+					decoder->num_of_loop, offset,
+					report, report_size, touch_data,
+					&obj, &offset);
+			if (retval < 0)
+				return retval;
+
+			offset += decoder->loop_stride;
+			if (offset + tcm_dev->bits_config_tailing >= report_bits)
+				break;
+
+			obj++;
+			if (decoder->active_only && decoder->has_active_objects) {
+				if (obj >= touch_data->num_of_active_objects)
+					break;
+			} else if (obj >= tcm_dev->max_objects) {
+				break;
+			}
+		}
+	}
+
+	entry += decoder->num_of_loop;
+
+	retval = syna_tcm_decode_touch_entries(entry, decoder->num_of_tail,
+			offset, report, report_size, touch_data, &obj, &offset);
+	if (retval < 0)
+		return retval;
+
+	return 0;
+}
+
+/**
+ * syna_tcm_touch_decoder_ready()
+ *
+ * Check whether the compiled decoder can be used. Entities handled by the
+ * custom callbacks go through the generic parser.
+ *
+ * @param
+ *    [ in] tcm_dev: the device handle
+ *
+ * @return
+ *    true if the compiled decoder is available; otherwise, false.
+ */
+static inline bool syna_tcm_touch_decoder_ready(struct tcm_dev *tcm_dev)
+{
+	struct tcm_touch_decoder *decoder = &tcm_dev->touch_decoder;
+
+	if (!decoder->compiled)
+		return false;
+
+	if (decoder->has_gesture && tcm_dev->cb_custom_gesture)
+		return false;
+
+	if (decoder->has_custom_entity && tcm_dev->cb_custom_touch_entity)
+		return false;
+
+	return true;
+}
+
 /**
  * syna_tcm_parse_touch_report()
  *
@@ -445,6 +1005,10 @@ int syna_tcm_parse_touch_report(struct tcm_dev *tcm_dev,
 	size = sizeof(touch_data->object_data);
 	syna_pal_mem_set(touch_data->object_data, 0x00, size);
 
+	if (syna_tcm_touch_decoder_ready(tcm_dev))
+		return syna_tcm_run_touch_decoder(tcm_dev, report,
+				report_size, touch_data);
+
 	num_of_active_objects = false;
 
 	bits_in_obj_loop = tcm_dev->bits_config_loop;
@@ -977,6 +1541,8 @@ int syna_tcm_preserve_touch_report_config(struct tcm_dev *tcm_dev)
 		return -ERR_INVAL;
 	}
 
+	tcm_dev->touch_decoder.compiled = false;
+
 	retval = tcm_dev->write_message(tcm_dev,
 			CMD_GET_TOUCH_REPORT_CONFIG,
 			NULL,
@@ -1059,6 +1625,8 @@ int syna_tcm_preserve_touch_report_config(struct tcm_dev *tcm_dev)
 	tcm_dev->bits_config_loop = bits_in_loop;
 	tcm_dev->bits_config_tailing = bits_tailing;
 
+	syna_tcm_compile_touch_report_config(tcm_dev);
+
 exit:
 	return retval;
 }
@@ -1127,3 +1695,6 @@ int syna_tcm_set_custom_gesture_callback(struct tcm_dev *tcm_dev,
 	return 0;
 }
 
+#if IS_ENABLED(CONFIG_TOUCHSCREEN_KUNIT_TEST)
+#include "../../touch_kunit/tests/syna_tcm2_touch_decoder_test.c"
+#endif
@@ -2,6 +2,13 @@ load(":touch_modules.bzl", "touch_driver_modules")
 load(":touch_modules_build.bzl", "define_target_variant_modules")
 load("//msm-kernel:target_variants.bzl", "get_all_la_variants", "get_all_le_variants", "get_all_lxc_variants")
 
+# the driver KUnit tests only go on the consolidate (debug) kernel, which has KUnit
+def kunit_modules(v):
+    return ["touch_kunit"] if v == "consolidate" else []
+
+def kunit_config_options(v):
+    return ["CONFIG_TOUCHSCREEN_KUNIT_TEST"] if v == "consolidate" else []
+
 def define_pineapple(t,v):
     define_target_variant_modules(
         target = t,
@@ -14,7 +21,7 @@ def define_pineapple(t,v):
             "goodix_ts",
             "focaltech_fts",
 	    "qts"
-        ],
+        ] + kunit_modules(v),
         config_options = [
             "TOUCH_DLKM_ENABLE",
             "CONFIG_ARCH_PINEAPPLE",
@@ -25,7 +32,7 @@ def define_pineapple(t,v):
             "CONFIG_TOUCHSCREEN_DUMMY",
             "CONFIG_TOUCH_FOCALTECH",
 	    "CONFIG_QTS_ENABLE"
-        ],
+        ] + kunit_config_options(v),
 )
 
 def define_blair(t,v):
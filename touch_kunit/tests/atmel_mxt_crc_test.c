@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit vectors for the table-driven mXT config CRC.
+ *
+ * Built into atmel_mxt_ts.c. mxt_calculate_crc() is checked against the
+ * word-at-a-time routine it replaced, which is kept below as the
+ * reference, and against fixed values from that routine.
+ */
+
+#include <kunit/test.h>
+
+/* the former mxt_calculate_crc(), one mxt_calc_crc24() step per word */
+static u32 mxt_crc_test_reference(u8 *base, off_t start_off, off_t end_off)
+{
+	u32 crc = 0;
+	u8 *ptr = base + start_off;
+	u8 *last_val = base + end_off - 1;
+
+	while (ptr < last_val) {
+		mxt_calc_crc24(&crc, *ptr, *(ptr + 1));
+		ptr += 2;
+	}
+
+	if (ptr == last_val)
+		mxt_calc_crc24(&crc, *ptr, 0);
+
+	return crc & 0x00FFFFFF;
+}
+
+struct mxt_crc_test_vector {
+	unsigned int len;
+	u32 crc;
+};
+
+/* bytes (i * 7 + 3) & 0xff */
+static const struct mxt_crc_test_vector mxt_crc_test_vectors[] = {
+	{ 0, 0x000000 },
+	{ 7, 0x007c4f },
+	{ 64, 0x6daf31 },
+	{ 100, 0x4fbe3e },
+};
+
+static void mxt_crc_test_fixed(struct kunit *test)
+{
+	const struct mxt_crc_test_vector *v;
+	u8 *buf;
+	int i;
+
+	buf = kunit_kzalloc(test, 128, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, buf);
+
+	for (i = 0; i < 128; i++)
+		buf[i] = (i * 7 + 3) & 0xff;
+
+	for (i = 0; i < ARRAY_SIZE(mxt_crc_test_vectors); i++) {
+		v = &mxt_crc_test_vectors[i];
+		KUNIT_EXPECT_EQ_MSG(test, mxt_calculate_crc(buf, 0, v->len),
+				v->crc, "len %u", v->len);
+		KUNIT_EXPECT_EQ_MSG(test, mxt_crc_test_reference(buf, 0, v->len),
+				v->crc, "len %u", v->len);
+	}
+
+	memset(buf, 0xff, 33);
+	KUNIT_EXPECT_EQ(test, mxt_calculate_crc(buf, 0, 33), (u32)0xaaa1a1);
+}
+
+static void mxt_crc_test_table(struct kunit *test)
+{
+	u32 crc;
+	int i, j;
+
+	/* each entry is eight zero-word steps from a CRC of i << 16 */
+	for (i = 0; i < ARRAY_SIZE(mxt_crc24_table); i++) {
+		crc = i << 16;
+		for (j = 0; j < 8; j++)
+			mxt_calc_crc24(&crc, 0, 0);
+		KUNIT_EXPECT_EQ_MSG(test, crc & 0x00FFFFFF, mxt_crc24_table[i],
+				"entry %d", i);
+	}
+}
+
+static void mxt_crc_test_random(struct kunit *test)
+{
+	u32 seed = 0x2f6b9d31;
+	unsigned int len, start;
+	u8 *buf;
+	int i;
+
+	buf = kunit_kzalloc(test, 512, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, buf);
+
+	/* a fixed seed keeps a failure reproducible */
+	for (i = 0; i < 512; i++) {
+		seed = seed * 1103515245 + 12345;
+		buf[i] = seed >> 16;
+	}
+
+	/* every length across the 16-byte stride, from odd and even starts */
+	for (start = 0; start < 4; start++) {
+		for (len = 0; len <= 80; len++)
+			KUNIT_EXPECT_EQ_MSG(test,
+				mxt_calculate_crc(buf, start, start + len),
+				mxt_crc_test_reference(buf, start, start + len),
+				"start %u len %u", start, len);
+	}
+
+	/* object table sized blocks */
+	for (len = 96; len <= 508; len += 59)
+		KUNIT_EXPECT_EQ_MSG(test, mxt_calculate_crc(buf, 3, 3 + len),
+				mxt_crc_test_reference(buf, 3, 3 + len),
+				"len %u", len);
+}
+
+static struct kunit_case mxt_crc_test_cases[] = {
+	KUNIT_CASE(mxt_crc_test_fixed),
+	KUNIT_CASE(mxt_crc_test_table),
+	KUNIT_CASE(mxt_crc_test_random),
+	{}
+};
+
+static struct kunit_suite mxt_crc_test_suite = {
+	.name = "atmel_mxt_crc",
+	.test_cases = mxt_crc_test_cases,
+};
+
+kunit_test_suite(mxt_crc_test_suite);
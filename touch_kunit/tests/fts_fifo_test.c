@@ -0,0 +1,367 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the ST FTS event FIFO reads.
+ *
+ * Built into fts.c. fts_event_handler() runs against a mock i2c adapter
+ * holding a canned FIFO, once reading it an event at a time and once in
+ * bursts, and every dispatched event is recorded so both modes can be
+ * compared. A benchmark case times the threaded IRQ against the old
+ * bounce through a workqueue, idle and with every cpu kept busy.
+ */
+
+#include <kunit/test.h>
+#include <linux/kthread.h>
+
+#include "../touch_kunit.h"
+
+#define FTS_FIFO_TEST_ADDR	0x49
+#define FTS_FIFO_TEST_MAX	FIFO_DEPTH
+#define FTS_FIFO_BENCH_IRQS	200
+
+struct fts_fifo_test_log {
+	unsigned char events[FTS_FIFO_TEST_MAX][FIFO_EVENT_SIZE];
+	unsigned int count;
+};
+
+struct fts_fifo_test_ctx {
+	struct touch_kunit_bus *bus;
+	struct fts_ts_info *info;
+	struct i2c_client *saved_client;
+	struct fts_fifo_test_log log;
+
+	/* benchmark */
+	struct touch_kunit_irq line;
+	struct workqueue_struct *wq;
+	struct work_struct work;
+	ktime_t first_event;
+};
+
+static struct fts_fifo_test_ctx *fts_fifo_test_ctx;
+
+static void fts_fifo_test_record(struct fts_ts_info *info,
+		unsigned char *event)
+{
+	struct fts_fifo_test_log *log = &fts_fifo_test_ctx->log;
+
+	if (log->count < FTS_FIFO_TEST_MAX)
+		memcpy(log->events[log->count], event, FIFO_EVENT_SIZE);
+	if (!log->count)
+		fts_fifo_test_ctx->first_event = ktime_get();
+	log->count++;
+}
+
+static int fts_fifo_test_init(struct kunit *test)
+{
+	struct fts_fifo_test_ctx *ctx;
+	struct fts_ts_info *info;
+	int i;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	test->priv = ctx;
+	fts_fifo_test_ctx = ctx;
+
+	info = kunit_kzalloc(test, sizeof(*info), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, info);
+	ctx->info = info;
+
+	info->event_dispatch_table = kunit_kcalloc(test, EVENTID_LAST,
+			sizeof(*info->event_dispatch_table), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, info->event_dispatch_table);
+	for (i = 0; i < EVENTID_LAST; i++)
+		info->event_dispatch_table[i].handler = fts_fifo_test_record;
+
+	info->input_dev = input_allocate_device();
+	KUNIT_ASSERT_NOT_NULL(test, info->input_dev);
+
+	ctx->bus = touch_kunit_i2c_bus_create(FTS_FIFO_TEST_ADDR);
+	KUNIT_ASSERT_NOT_NULL(test, ctx->bus);
+	/* an empty FIFO reads back as EVENTID_NO_EVENT */
+	ctx->bus->idle_byte = EVENTID_NO_EVENT;
+
+	i2c_set_clientdata(ctx->bus->client, info);
+	info->client = ctx->bus->client;
+	ctx->saved_client = getClient();
+	openChannel(ctx->bus->client);
+
+	return 0;
+}
+
+static void fts_fifo_test_exit(struct kunit *test)
+{
+	struct fts_fifo_test_ctx *ctx = test->priv;
+
+	if (!ctx)
+		return;
+
+	touch_kunit_irq_release(&ctx->line);
+	if (ctx->wq)
+		destroy_workqueue(ctx->wq);
+	if (ctx->saved_client)
+		openChannel(ctx->saved_client);
+	if (ctx->bus)
+		touch_kunit_bus_destroy(ctx->bus);
+	if (ctx->info) {
+		kfree(ctx->info->i2c_data);
+		input_free_device(ctx->info->input_dev);
+	}
+	fts_fifo_test_ctx = NULL;
+}
+
+/*
+ * count events with distinct payloads, one id in six is unknown and is
+ * skipped; return how many events get dispatched
+ */
+static unsigned int fts_fifo_test_fill(unsigned char (*fifo)[FIFO_EVENT_SIZE],
+		unsigned int count)
+{
+	static const unsigned char ids[] = {
+		EVENTID_ENTER_POINTER, EVENTID_MOTION_POINTER,
+		EVENTID_MOTION_POINTER, EVENTID_LEAVE_POINTER,
+		EVENTID_STATUS_UPDATE, EVENTID_LAST,
+	};
+	unsigned int i, j, known = 0;
+
+	for (i = 0; i < count; i++) {
+		fifo[i][0] = ids[i % ARRAY_SIZE(ids)];
+		for (j = 1; j < FIFO_EVENT_SIZE; j++)
+			fifo[i][j] = i * FIFO_EVENT_SIZE + j;
+		if (fifo[i][0] < EVENTID_LAST)
+			known++;
+	}
+
+	return known;
+}
+
+static void fts_fifo_test_queue(struct kunit *test,
+		unsigned char (*fifo)[FIFO_EVENT_SIZE], unsigned int count,
+		unsigned int per_read)
+{
+	struct fts_fifo_test_ctx *ctx = test->priv;
+	unsigned int i, n;
+
+	for (i = 0; i < count; i += per_read) {
+		n = min(per_read, count - i);
+		KUNIT_ASSERT_EQ(test, touch_kunit_bus_queue_frame(ctx->bus,
+				fifo[i], n * FIFO_EVENT_SIZE), 0);
+	}
+}
+
+static unsigned int fts_fifo_test_run(struct kunit *test, bool burst,
+		unsigned int count, struct fts_fifo_test_log *log)
+{
+	struct fts_fifo_test_ctx *ctx = test->priv;
+	unsigned char fifo[FTS_FIFO_TEST_MAX][FIFO_EVENT_SIZE];
+	unsigned int i, known;
+
+	known = fts_fifo_test_fill(fifo, count);
+	fts_fifo_test_queue(test, fifo, count, burst ? FIFO_BURST_EVENTS : 1);
+
+	touch_kunit_bus_reset_log(ctx->bus);
+	ctx->bus->msg_count = 0;
+	memset(&ctx->log, 0, sizeof(ctx->log));
+	ctx->info->fifo_burst = burst;
+
+	fts_event_handler(ctx->info);
+
+	/* the mode does not change behind the test's back */
+	KUNIT_EXPECT_EQ(test, ctx->info->fifo_burst, burst);
+	/* one command byte per transaction */
+	KUNIT_EXPECT_EQ(test, ctx->bus->write_len, ctx->bus->msg_count);
+	for (i = 0; i < ctx->bus->write_len; i++)
+		KUNIT_EXPECT_EQ(test, ctx->bus->write_log[i],
+				(unsigned char)(burst ? FIFO_CMD_READALL :
+				FIFO_CMD_READONE));
+
+	*log = ctx->log;
+
+	return known;
+}
+
+static void fts_fifo_test_compare(struct kunit *test, unsigned int count)
+{
+	struct fts_fifo_test_ctx *ctx = test->priv;
+	struct fts_fifo_test_log *single, *burst;
+	unsigned int single_msgs, known;
+
+	single = kunit_kzalloc(test, sizeof(*single), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, single);
+	burst = kunit_kzalloc(test, sizeof(*burst), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, burst);
+
+	known = fts_fifo_test_run(test, false, count, single);
+	single_msgs = ctx->bus->msg_count;
+	fts_fifo_test_run(test, true, count, burst);
+
+	/* every event is dispatched, in FIFO order, the same in both modes */
+	KUNIT_EXPECT_EQ(test, single->count, known);
+	KUNIT_EXPECT_EQ(test, burst->count, known);
+	KUNIT_EXPECT_EQ(test, memcmp(single->events, burst->events,
+			sizeof(single->events)), 0);
+
+	/* the read returning EVENTID_NO_EVENT ends both loops */
+	KUNIT_EXPECT_EQ(test, single_msgs, count + 1);
+	KUNIT_EXPECT_EQ(test, ctx->bus->msg_count,
+			count / FIFO_BURST_EVENTS + 1);
+}
+
+static void fts_fifo_test_empty(struct kunit *test)
+{
+	fts_fifo_test_compare(test, 0);
+}
+
+static void fts_fifo_test_one(struct kunit *test)
+{
+	fts_fifo_test_compare(test, 1);
+}
+
+static void fts_fifo_test_partial(struct kunit *test)
+{
+	fts_fifo_test_compare(test, FIFO_BURST_EVENTS + 3);
+}
+
+static void fts_fifo_test_full_bursts(struct kunit *test)
+{
+	fts_fifo_test_compare(test, 2 * FIFO_BURST_EVENTS);
+}
+
+#ifndef FTS_USE_POLLING_MODE
+
+/* the event handling before the threaded IRQ drained the FIFO itself */
+static void fts_fifo_bench_work(struct work_struct *work)
+{
+	struct fts_fifo_test_ctx *ctx =
+		container_of(work, struct fts_fifo_test_ctx, work);
+
+	fts_event_handler(ctx->info);
+	enable_irq(ctx->line.irq);
+}
+
+static irqreturn_t fts_fifo_bench_bounce(int irq, void *handle)
+{
+	struct fts_fifo_test_ctx *ctx = handle;
+
+	disable_irq_nosync(irq);
+	queue_work(ctx->wq, &ctx->work);
+
+	return IRQ_HANDLED;
+}
+
+static int fts_fifo_bench_load(void *unused)
+{
+	while (!kthread_should_stop()) {
+		cpu_relax();
+		cond_resched();
+	}
+
+	return 0;
+}
+
+/*
+ * fire FTS_FIFO_BENCH_IRQS interrupts, each with two events waiting,
+ * and return the mean delay from the interrupt to the first FIFO event
+ */
+static u64 fts_fifo_bench_run(struct kunit *test, irq_handler_t thread_fn,
+		void *dev_id, u64 *max_ns)
+{
+	struct fts_fifo_test_ctx *ctx = test->priv;
+	unsigned char fifo[2][FIFO_EVENT_SIZE];
+	u64 sum = 0, delay;
+	ktime_t start;
+	int i;
+
+	touch_kunit_irq_release(&ctx->line);
+	KUNIT_ASSERT_EQ(test, touch_kunit_irq_init(&ctx->line, NULL,
+			thread_fn, dev_id), 0);
+
+	*max_ns = 0;
+	for (i = 0; i < FTS_FIFO_BENCH_IRQS; i++) {
+		fts_fifo_test_fill(fifo, ARRAY_SIZE(fifo));
+		fts_fifo_test_queue(test, fifo, ARRAY_SIZE(fifo), 1);
+		memset(&ctx->log, 0, sizeof(ctx->log));
+
+		start = ktime_get();
+		touch_kunit_irq_fire(&ctx->line);
+		flush_work(&ctx->work);
+
+		KUNIT_ASSERT_EQ(test, ctx->log.count, 2U);
+		delay = ktime_to_ns(ktime_sub(ctx->first_event, start));
+		sum += delay;
+		*max_ns = max(*max_ns, delay);
+	}
+
+	return div_u64(sum, FTS_FIFO_BENCH_IRQS);
+}
+
+static void fts_fifo_bench_compare(struct kunit *test, const char *load)
+{
+	struct fts_fifo_test_ctx *ctx = test->priv;
+	u64 direct, bounce, direct_max, bounce_max;
+
+	direct = fts_fifo_bench_run(test, fts_interrupt_handler, ctx->info,
+			&direct_max);
+	bounce = fts_fifo_bench_run(test, fts_fifo_bench_bounce, ctx,
+			&bounce_max);
+
+	kunit_info(test, "%s: irq to first event, threaded irq %llu ns (max %llu), workqueue %llu ns (max %llu)\n",
+			load, direct, direct_max, bounce, bounce_max);
+}
+
+static void fts_fifo_test_bench(struct kunit *test)
+{
+	struct fts_fifo_test_ctx *ctx = test->priv;
+	struct task_struct **loaders;
+	unsigned int cpu, n = 0;
+
+#if defined(CONFIG_ST_TRUSTED_TOUCH) && !defined(CONFIG_ARCH_QTI_VM)
+	ctx->info->vm_info = kunit_kzalloc(test, sizeof(*ctx->info->vm_info),
+			GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx->info->vm_info);
+#endif
+	ctx->info->fifo_burst = false;
+	ctx->wq = alloc_workqueue("fts-fifo-bench", WQ_UNBOUND | WQ_HIGHPRI,
+			1);
+	KUNIT_ASSERT_NOT_NULL(test, ctx->wq);
+	INIT_WORK(&ctx->work, fts_fifo_bench_work);
+
+	fts_fifo_bench_compare(test, "idle");
+
+	loaders = kunit_kcalloc(test, num_possible_cpus(), sizeof(*loaders),
+			GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, loaders);
+	for_each_online_cpu(cpu) {
+		loaders[n] = kthread_create(fts_fifo_bench_load, NULL,
+				"fts_fifo_load/%u", cpu);
+		if (IS_ERR(loaders[n]))
+			break;
+		kthread_bind(loaders[n], cpu);
+		wake_up_process(loaders[n++]);
+	}
+
+	fts_fifo_bench_compare(test, "loaded");
+
+	while (n--)
+		kthread_stop(loaders[n]);
+}
+
+#endif /* FTS_USE_POLLING_MODE */
+
+static struct kunit_case fts_fifo_test_cases[] = {
+	KUNIT_CASE(fts_fifo_test_empty),
+	KUNIT_CASE(fts_fifo_test_one),
+	KUNIT_CASE(fts_fifo_test_partial),
+	KUNIT_CASE(fts_fifo_test_full_bursts),
+#ifndef FTS_USE_POLLING_MODE
+	KUNIT_CASE_SLOW(fts_fifo_test_bench),
+#endif
+	{}
+};
+
+static struct kunit_suite fts_fifo_test_suite = {
+	.name = "fts_event_fifo",
+	.init = fts_fifo_test_init,
+	.exit = fts_fifo_test_exit,
+	.test_cases = fts_fifo_test_cases,
+};
+
+kunit_test_suite(fts_fifo_test_suite);
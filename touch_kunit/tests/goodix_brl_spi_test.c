@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the Goodix Berlin spi transfer buffers.
+ *
+ * Built into goodix_brl_spi.c. The read and write helpers run against the
+ * mock spi controller with the per-device buffers probe would set up.
+ */
+
+#include <kunit/test.h>
+
+#include "../touch_kunit.h"
+
+#define GOODIX_SPI_TEST_ADDR	0x10308
+#define GOODIX_SPI_TEST_LEN	64
+
+struct goodix_spi_test_ctx {
+	struct touch_kunit_bus *bus;
+	struct goodix_spi_xfer *xfer;
+};
+
+static int goodix_spi_test_init(struct kunit *test)
+{
+	struct goodix_spi_test_ctx *ctx;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	test->priv = ctx;
+
+	ctx->bus = touch_kunit_spi_bus_create();
+	KUNIT_ASSERT_NOT_NULL(test, ctx->bus);
+
+	/* as goodix_spi_probe() leaves them */
+	ctx->xfer = kunit_kzalloc(test, sizeof(*ctx->xfer), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx->xfer);
+	mutex_init(&ctx->xfer->lock);
+	KUNIT_ASSERT_EQ(test, goodix_spi_get_xfer_buf(ctx->xfer,
+			SPI_XFER_BUF_DEFAULT_SIZE), 0);
+	spi_set_drvdata(ctx->bus->spi, ctx->xfer);
+
+	return 0;
+}
+
+static void goodix_spi_test_exit(struct kunit *test)
+{
+	struct goodix_spi_test_ctx *ctx = test->priv;
+
+	if (!ctx)
+		return;
+
+	if (ctx->xfer)
+		goodix_spi_free_xfer_buf(ctx->xfer);
+	touch_kunit_bus_destroy(ctx->bus);
+}
+
+/* the device answers after the prefix, the prefix bytes are don't care */
+static void goodix_spi_test_queue(struct kunit *test, unsigned int prefix,
+		unsigned int len, unsigned char seed)
+{
+	struct goodix_spi_test_ctx *ctx = test->priv;
+	unsigned char frame[SPI_READ_PREFIX_LEN + GOODIX_SPI_TEST_LEN];
+	unsigned int i;
+
+	memset(frame, 0x5a, prefix);
+	for (i = 0; i < len; i++)
+		frame[prefix + i] = seed + i;
+
+	KUNIT_ASSERT_EQ(test, touch_kunit_bus_queue_frame(ctx->bus, frame,
+			prefix + len), 0);
+}
+
+static void goodix_spi_test_check_tx(struct kunit *test, unsigned int prefix,
+		unsigned int len)
+{
+	struct goodix_spi_test_ctx *ctx = test->priv;
+	const unsigned char *tx = ctx->bus->tx_log;
+	unsigned int i;
+
+	KUNIT_ASSERT_EQ(test, ctx->bus->tx_len, prefix + len);
+	KUNIT_EXPECT_EQ(test, tx[0], (unsigned char)SPI_READ_FLAG);
+	KUNIT_EXPECT_EQ(test, tx[1], (unsigned char)0x00);
+	KUNIT_EXPECT_EQ(test, tx[2], (unsigned char)0x01);
+	KUNIT_EXPECT_EQ(test, tx[3], (unsigned char)0x03);
+	KUNIT_EXPECT_EQ(test, tx[4], (unsigned char)0x08);
+	for (i = SPI_WRITE_PREFIX_LEN; i < prefix; i++)
+		KUNIT_EXPECT_EQ_MSG(test, tx[i], (unsigned char)0xff,
+				"dummy byte %u", i);
+	/* nothing of an earlier write is clocked out while reading */
+	for (i = prefix; i < prefix + len; i++)
+		KUNIT_EXPECT_EQ_MSG(test, tx[i], (unsigned char)0x00,
+				"tail byte %u", i);
+}
+
+static void goodix_spi_test_read(struct kunit *test, bool bra)
+{
+	struct goodix_spi_test_ctx *ctx = test->priv;
+	struct goodix_spi_xfer *xfer = ctx->xfer;
+	unsigned int prefix = bra ? SPI_READ_PREFIX_LEN :
+			SPI_READ_PREFIX_LEN - 1;
+	unsigned char data[GOODIX_SPI_TEST_LEN];
+	unsigned char wr[GOODIX_SPI_TEST_LEN];
+	u8 *tx_buf = xfer->tx_buf;
+	u8 *rd_tx_buf = xfer->rd_tx_buf;
+	u8 *rx_buf = xfer->rx_buf;
+	unsigned int size = xfer->size;
+	unsigned int len;
+	int i;
+
+	/* leave a pattern in the write buffer first */
+	memset(wr, 0xa5, sizeof(wr));
+	KUNIT_ASSERT_EQ(test, goodix_spi_write(&ctx->bus->spi->dev,
+			GOODIX_SPI_TEST_ADDR, wr, sizeof(wr)), 0);
+
+	for (i = 0; i < 8; i++) {
+		len = GOODIX_SPI_TEST_LEN - i * 7;
+		goodix_spi_test_queue(test, prefix, len, i * 16);
+		memset(data, 0, sizeof(data));
+
+		if (bra)
+			KUNIT_ASSERT_EQ(test, goodix_spi_read_bra(
+					&ctx->bus->spi->dev,
+					GOODIX_SPI_TEST_ADDR, data, len), 0);
+		else
+			KUNIT_ASSERT_EQ(test, goodix_spi_read(
+					&ctx->bus->spi->dev,
+					GOODIX_SPI_TEST_ADDR, data, len), 0);
+
+		KUNIT_EXPECT_EQ(test, data[0], (unsigned char)(i * 16));
+		KUNIT_EXPECT_EQ(test, data[len - 1],
+				(unsigned char)(i * 16 + len - 1));
+		goodix_spi_test_check_tx(test, prefix, len);
+	}
+
+	/* steady state reads use the probe time buffers, nothing is allocated */
+	KUNIT_EXPECT_PTR_EQ(test, xfer->tx_buf, tx_buf);
+	KUNIT_EXPECT_PTR_EQ(test, xfer->rd_tx_buf, rd_tx_buf);
+	KUNIT_EXPECT_PTR_EQ(test, xfer->rx_buf, rx_buf);
+	KUNIT_EXPECT_EQ(test, xfer->size, size);
+	KUNIT_EXPECT_TRUE(test, IS_ALIGNED(xfer->size, L1_CACHE_BYTES));
+}
+
+static void goodix_spi_test_read_steady(struct kunit *test)
+{
+	goodix_spi_test_read(test, false);
+}
+
+static void goodix_spi_test_read_bra_steady(struct kunit *test)
+{
+	goodix_spi_test_read(test, true);
+}
+
+static void goodix_spi_test_grow(struct kunit *test)
+{
+	struct goodix_spi_test_ctx *ctx = test->priv;
+	struct goodix_spi_xfer *xfer = ctx->xfer;
+	unsigned int len = xfer->size + 1;
+	unsigned char *data;
+	unsigned int size;
+
+	data = kunit_kzalloc(test, len, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, data);
+
+	/* past the canned frame the mock answers with its idle byte */
+	KUNIT_ASSERT_EQ(test, goodix_spi_read(&ctx->bus->spi->dev,
+			GOODIX_SPI_TEST_ADDR, data, len), 0);
+	KUNIT_EXPECT_EQ(test, data[len - 1], (unsigned char)0xff);
+
+	size = xfer->size;
+	KUNIT_EXPECT_GE(test, size, len + SPI_READ_PREFIX_LEN - 1);
+	KUNIT_EXPECT_TRUE(test, IS_ALIGNED(size, L1_CACHE_BYTES));
+
+	/* and the grown buffers are kept for the reads that follow */
+	KUNIT_ASSERT_EQ(test, goodix_spi_read(&ctx->bus->spi->dev,
+			GOODIX_SPI_TEST_ADDR, data, GOODIX_SPI_TEST_LEN), 0);
+	KUNIT_EXPECT_EQ(test, xfer->size, size);
+}
+
+static struct kunit_case goodix_spi_test_cases[] = {
+	KUNIT_CASE(goodix_spi_test_read_steady),
+	KUNIT_CASE(goodix_spi_test_read_bra_steady),
+	KUNIT_CASE(goodix_spi_test_grow),
+	{}
+};
+
+static struct kunit_suite goodix_spi_test_suite = {
+	.name = "goodix_brl_spi",
+	.init = goodix_spi_test_init,
+	.exit = goodix_spi_test_exit,
+	.test_cases = goodix_spi_test_cases,
+};
+
+kunit_test_suite(goodix_spi_test_suite);
@@ -0,0 +1,450 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for two Goodix Berlin touch cores running side by side.
+ *
+ * Built into goodix_ts_core.c. Each core gets the Berlin hw ops with its
+ * bus read replaced by a canned touch frame, a registered input device
+ * and a fake ATTN line whose irq thread runs goodix_irq_handler(), so
+ * both event paths run the real frame handling concurrently. Ext modules
+ * are also registered and unregistered while a core's irqs fire.
+ */
+
+#include <kunit/test.h>
+#include <linux/kthread.h>
+
+#include "../touch_kunit.h"
+
+#define GOODIX_CORE_TEST_CORES		2
+#define GOODIX_CORE_TEST_IRQS		500
+#define GOODIX_CORE_TEST_ADDR		0x10308
+/* frame layout of goodix_brl_hw.c */
+#define GOODIX_CORE_TEST_HEAD_LEN	8
+#define GOODIX_CORE_TEST_POINT_LEN	8
+#define GOODIX_CORE_TEST_FRAME_LEN	(GOODIX_CORE_TEST_HEAD_LEN + \
+		GOODIX_CORE_TEST_POINT_LEN * GOODIX_MAX_TOUCH + 2)
+
+struct goodix_core_test_core {
+	struct goodix_ts_core *cd;
+	struct goodix_ts_hw_ops hw_ops;
+	struct goodix_bus_interface bus;
+	struct touch_kunit_irq line;
+	struct goodix_ext_module module;
+	u8 frame[GOODIX_CORE_TEST_FRAME_LEN];
+	/* first finger id and count of the canned frame */
+	unsigned int first_id;
+	unsigned int touch_num;
+	unsigned int x_base;
+
+	struct task_struct *firer;
+	struct completion fired;
+	atomic_t irq_events;
+	atomic_t wrong_core;
+	atomic_t bad_frames;
+};
+
+struct goodix_core_test_ctx {
+	struct goodix_core_test_core core[GOODIX_CORE_TEST_CORES];
+	/* saved module state of a real core, if any */
+	struct goodix_ts_core *saved_core_data;
+	int saved_prob_state;
+
+	/* ext module churn */
+	atomic_t churn_calls;
+	atomic_t churn_late;
+};
+
+/* an ext module registered for a moment while irqs fire */
+struct goodix_core_test_churn {
+	struct goodix_ext_module module;
+	/* irq_event calls in flight */
+	atomic_t inside;
+	bool exited;
+};
+
+static struct goodix_core_test_ctx *goodix_core_test_ctx;
+
+static struct goodix_core_test_core *goodix_core_test_find(
+		struct goodix_ts_core *cd)
+{
+	int i;
+
+	for (i = 0; i < GOODIX_CORE_TEST_CORES; i++) {
+		if (goodix_core_test_ctx->core[i].cd == cd)
+			return &goodix_core_test_ctx->core[i];
+	}
+
+	return NULL;
+}
+
+static void goodix_core_test_checksum(u8 *data, unsigned int len)
+{
+	u16 sum = 0;
+	unsigned int i;
+
+	for (i = 0; i < len; i++)
+		sum += data[i];
+	put_unaligned_le16(sum, &data[len]);
+}
+
+/* a touch frame with touch_num fingers, ids from first_id */
+static void goodix_core_test_build_frame(struct goodix_core_test_core *core)
+{
+	u8 *point = &core->frame[GOODIX_CORE_TEST_HEAD_LEN];
+	unsigned int i;
+
+	memset(core->frame, 0, sizeof(core->frame));
+	core->frame[0] = 0x80;
+	core->frame[2] = core->touch_num;
+	goodix_core_test_checksum(core->frame, GOODIX_CORE_TEST_HEAD_LEN - 2);
+
+	for (i = 0; i < core->touch_num; i++) {
+		point[0] = ((core->first_id + i) << 4) | 0x01;
+		put_unaligned_le16(core->x_base + i, &point[2]);
+		put_unaligned_le16(core->x_base + 100 + i, &point[4]);
+		put_unaligned_le16(10 + i, &point[6]);
+		point += GOODIX_CORE_TEST_POINT_LEN;
+	}
+	goodix_core_test_checksum(&core->frame[GOODIX_CORE_TEST_HEAD_LEN],
+			core->touch_num * GOODIX_CORE_TEST_POINT_LEN);
+}
+
+static int goodix_core_test_read(struct goodix_ts_core *cd, unsigned int addr,
+		unsigned char *data, unsigned int len)
+{
+	struct goodix_core_test_core *core = goodix_core_test_find(cd);
+	unsigned int offset = addr - GOODIX_CORE_TEST_ADDR;
+	unsigned int i;
+
+	if (!core)
+		return -ENODEV;
+
+	for (i = 0; i < len; i++, offset++)
+		data[i] = offset < sizeof(core->frame) ? core->frame[offset] : 0;
+
+	/* let the other core run between the head and the point reads */
+	usleep_range(10, 20);
+
+	return 0;
+}
+
+static int goodix_core_test_write(struct goodix_ts_core *cd, unsigned int addr,
+		unsigned char *data, unsigned int len)
+{
+	return 0;
+}
+
+static int goodix_core_test_irq_event(struct goodix_ts_core *cd,
+		struct goodix_ext_module *module)
+{
+	struct goodix_core_test_core *core = module->priv_data;
+
+	atomic_inc(&core->irq_events);
+	if (cd != core->cd || module->core_data != core->cd)
+		atomic_inc(&core->wrong_core);
+
+	return EVT_CONTINUE;
+}
+
+static const struct goodix_ext_module_funcs goodix_core_test_funcs = {
+	.irq_event = goodix_core_test_irq_event,
+};
+
+/* the frame goodix_touch_handler() left for the last irq of this core */
+static bool goodix_core_test_check_event(struct goodix_core_test_core *core)
+{
+	struct goodix_touch_data *touch_data = &core->cd->ts_event.touch_data;
+	unsigned int i, id;
+
+	if (core->cd->ts_event.event_type != EVENT_TOUCH ||
+			touch_data->touch_num != core->touch_num)
+		return false;
+
+	for (i = 0; i < core->touch_num; i++) {
+		id = core->first_id + i;
+		if (touch_data->coords[id].status != TS_TOUCH ||
+				touch_data->coords[id].x != core->x_base + i ||
+				touch_data->coords[id].y != core->x_base + 100 + i)
+			return false;
+	}
+
+	return true;
+}
+
+static int goodix_core_test_churn_irq_event(struct goodix_ts_core *cd,
+		struct goodix_ext_module *module)
+{
+	struct goodix_core_test_churn *churn =
+		container_of(module, struct goodix_core_test_churn, module);
+
+	atomic_inc(&churn->inside);
+	atomic_inc(&goodix_core_test_ctx->churn_calls);
+	if (READ_ONCE(churn->exited) || module->core_data != cd)
+		atomic_inc(&goodix_core_test_ctx->churn_late);
+	/* widen the window for unregister to race with us */
+	usleep_range(5, 10);
+	atomic_dec(&churn->inside);
+
+	return EVT_CONTINUE;
+}
+
+static int goodix_core_test_churn_exit(struct goodix_ts_core *cd,
+		struct goodix_ext_module *module)
+{
+	struct goodix_core_test_churn *churn =
+		container_of(module, struct goodix_core_test_churn, module);
+
+	WRITE_ONCE(churn->exited, true);
+	return 0;
+}
+
+static const struct goodix_ext_module_funcs goodix_core_test_churn_funcs = {
+	.exit = goodix_core_test_churn_exit,
+	.irq_event = goodix_core_test_churn_irq_event,
+};
+
+static int goodix_core_test_init_core(struct kunit *test,
+		struct goodix_core_test_core *core, unsigned int first_id,
+		unsigned int touch_num, unsigned int x_base)
+{
+	struct goodix_ts_core *cd;
+
+	cd = kunit_kzalloc(test, sizeof(*cd), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, cd);
+	core->cd = cd;
+
+	core->first_id = first_id;
+	core->touch_num = touch_num;
+	core->x_base = x_base;
+	goodix_core_test_build_frame(core);
+
+	/* the Berlin event handler on a canned bus */
+	core->hw_ops = *goodix_get_hw_ops();
+	core->hw_ops.read = goodix_core_test_read;
+	core->hw_ops.write = goodix_core_test_write;
+	cd->hw_ops = &core->hw_ops;
+	cd->bus = &core->bus;
+	cd->ic_info.misc.touch_data_addr = GOODIX_CORE_TEST_ADDR;
+	cd->board_data.panel_max_x = 4095;
+	cd->board_data.panel_max_y = 4095;
+	cd->board_data.panel_max_w = 255;
+	mutex_init(&cd->tui_transition_lock);
+
+	KUNIT_ASSERT_EQ(test, goodix_ts_input_dev_config(cd), 0);
+
+	core->module.name = "goodix_core_test";
+	core->module.priority = EXTMOD_PRIO_DEFAULT;
+	core->module.funcs = &goodix_core_test_funcs;
+	core->module.priv_data = core;
+	atomic_set(&core->irq_events, 0);
+	atomic_set(&core->wrong_core, 0);
+	atomic_set(&core->bad_frames, 0);
+	init_completion(&core->fired);
+
+	KUNIT_ASSERT_EQ(test, touch_kunit_irq_init(&core->line, NULL,
+			goodix_irq_handler, cd), 0);
+	cd->irq = core->line.irq;
+
+	return 0;
+}
+
+static int goodix_core_test_init(struct kunit *test)
+{
+	struct goodix_core_test_ctx *ctx;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	test->priv = ctx;
+	goodix_core_test_ctx = ctx;
+
+	/* core 0 reports five fingers, core 1 a single one */
+	goodix_core_test_init_core(test, &ctx->core[0], 0, 5, 100);
+	goodix_core_test_init_core(test, &ctx->core[1], 7, 1, 3000);
+
+	/* core 0 probed as the primary touch core */
+	goodix_core_module_init();
+	ctx->saved_core_data = goodix_modules.core_data;
+	ctx->saved_prob_state = core_module_prob_sate;
+	goodix_modules.core_data = ctx->core[0].cd;
+	core_module_prob_sate = CORE_MODULE_PROB_SUCCESS;
+	atomic_set(&ctx->churn_calls, 0);
+	atomic_set(&ctx->churn_late, 0);
+
+	return 0;
+}
+
+static void goodix_core_test_exit(struct kunit *test)
+{
+	struct goodix_core_test_ctx *ctx = test->priv;
+	struct goodix_core_test_core *core;
+	int i;
+
+	if (!ctx)
+		return;
+
+	for (i = 0; i < GOODIX_CORE_TEST_CORES; i++) {
+		core = &ctx->core[i];
+		if (!core->cd)
+			continue;
+		goodix_unregister_ext_module(&core->module);
+		touch_kunit_irq_release(&core->line);
+		goodix_ts_input_dev_remove(core->cd);
+	}
+
+	goodix_modules.core_data = ctx->saved_core_data;
+	core_module_prob_sate = ctx->saved_prob_state;
+	goodix_core_test_ctx = NULL;
+}
+
+static void goodix_core_test_binding(struct kunit *test)
+{
+	struct goodix_core_test_ctx *ctx = test->priv;
+	struct goodix_core_test_core *core0 = &ctx->core[0];
+	struct goodix_core_test_core *core1 = &ctx->core[1];
+
+	/* no core given, the module goes to the primary core */
+	KUNIT_ASSERT_EQ(test,
+		goodix_register_ext_module_no_wait(&core0->module), 0);
+	KUNIT_EXPECT_PTR_EQ(test, core0->module.core_data, core0->cd);
+
+	/* a core probing later does not take it over */
+	core1->module.core_data = core1->cd;
+	KUNIT_ASSERT_EQ(test,
+		goodix_register_ext_module_no_wait(&core1->module), 0);
+	KUNIT_EXPECT_PTR_EQ(test, core1->module.core_data, core1->cd);
+
+	touch_kunit_irq_fire(&core1->line);
+	KUNIT_EXPECT_EQ(test, atomic_read(&core0->irq_events), 0);
+	KUNIT_EXPECT_EQ(test, atomic_read(&core1->irq_events), 1);
+
+	touch_kunit_irq_fire(&core0->line);
+	KUNIT_EXPECT_EQ(test, atomic_read(&core0->irq_events), 1);
+	KUNIT_EXPECT_EQ(test, atomic_read(&core1->irq_events), 1);
+	KUNIT_EXPECT_EQ(test, atomic_read(&core0->wrong_core), 0);
+	KUNIT_EXPECT_EQ(test, atomic_read(&core1->wrong_core), 0);
+
+	KUNIT_EXPECT_TRUE(test, goodix_core_test_check_event(core0));
+	KUNIT_EXPECT_TRUE(test, goodix_core_test_check_event(core1));
+
+	/* unregistering drops the binding */
+	goodix_unregister_ext_module(&core1->module);
+	KUNIT_EXPECT_NULL(test, core1->module.core_data);
+}
+
+static int goodix_core_test_firer(void *data)
+{
+	struct goodix_core_test_core *core = data;
+	int i;
+
+	for (i = 0; i < GOODIX_CORE_TEST_IRQS; i++) {
+		touch_kunit_irq_fire(&core->line);
+		/* nothing but this core's irq thread writes its event */
+		if (!goodix_core_test_check_event(core))
+			atomic_inc(&core->bad_frames);
+	}
+
+	complete(&core->fired);
+	return 0;
+}
+
+static void goodix_core_test_interleave(struct kunit *test)
+{
+	struct goodix_core_test_ctx *ctx = test->priv;
+	struct goodix_core_test_core *core;
+	int i;
+
+	ctx->core[1].module.core_data = ctx->core[1].cd;
+	for (i = 0; i < GOODIX_CORE_TEST_CORES; i++)
+		KUNIT_ASSERT_EQ(test, goodix_register_ext_module_no_wait(
+				&ctx->core[i].module), 0);
+
+	for (i = 0; i < GOODIX_CORE_TEST_CORES; i++) {
+		core = &ctx->core[i];
+		core->firer = kthread_run(goodix_core_test_firer, core,
+				"goodix_core_test%d", i);
+		KUNIT_ASSERT_FALSE(test, IS_ERR(core->firer));
+	}
+
+	for (i = 0; i < GOODIX_CORE_TEST_CORES; i++) {
+		core = &ctx->core[i];
+		wait_for_completion(&core->fired);
+
+		KUNIT_EXPECT_EQ_MSG(test, atomic_read(&core->bad_frames), 0,
+				"core %d", i);
+		KUNIT_EXPECT_EQ_MSG(test, atomic_read(&core->irq_events),
+				GOODIX_CORE_TEST_IRQS, "core %d", i);
+		KUNIT_EXPECT_EQ_MSG(test, atomic_read(&core->wrong_core), 0,
+				"core %d", i);
+		KUNIT_EXPECT_EQ(test, core->cd->pre_finger_num,
+				(u8)core->touch_num);
+		KUNIT_EXPECT_EQ(test, core->cd->irq_trig_cnt,
+				(size_t)GOODIX_CORE_TEST_IRQS);
+	}
+}
+
+static void goodix_core_test_churn(struct kunit *test)
+{
+	struct goodix_core_test_ctx *ctx = test->priv;
+	struct goodix_core_test_core *core = &ctx->core[0];
+	struct goodix_core_test_churn *churn;
+	unsigned int rounds = 0, stuck = 0;
+
+	KUNIT_ASSERT_EQ(test,
+		goodix_register_ext_module_no_wait(&core->module), 0);
+
+	core->firer = kthread_run(goodix_core_test_firer, core,
+			"goodix_core_test0");
+	KUNIT_ASSERT_FALSE(test, IS_ERR(core->firer));
+
+	while (!completion_done(&core->fired)) {
+		churn = kzalloc(sizeof(*churn), GFP_KERNEL);
+		KUNIT_ASSERT_NOT_NULL(test, churn);
+		churn->module.name = "goodix_core_test_churn";
+		/* land before, among and after the other modules */
+		churn->module.priority = EXTMOD_PRIO_FWUPDATE +
+				rounds % EXTMOD_PRIO_DEFAULT;
+		churn->module.funcs = &goodix_core_test_churn_funcs;
+		atomic_set(&churn->inside, 0);
+
+		if (goodix_register_ext_module_no_wait(&churn->module)) {
+			kfree(churn);
+			KUNIT_FAIL(test, "churn module %u not registered",
+					rounds);
+			break;
+		}
+		usleep_range(50, 100);
+		goodix_unregister_ext_module(&churn->module);
+
+		/* the irq thread has left the module once unregister returns */
+		if (atomic_read(&churn->inside))
+			stuck++;
+		kfree(churn);
+		rounds++;
+	}
+	wait_for_completion(&core->fired);
+
+	kunit_info(test, "%u modules churned, %d irq_event calls on them\n",
+			rounds, atomic_read(&ctx->churn_calls));
+	KUNIT_EXPECT_EQ(test, stuck, 0U);
+	KUNIT_EXPECT_EQ(test, atomic_read(&ctx->churn_late), 0);
+	/* the module that stayed saw every irq, with the right frame */
+	KUNIT_EXPECT_EQ(test, atomic_read(&core->irq_events),
+			GOODIX_CORE_TEST_IRQS);
+	KUNIT_EXPECT_EQ(test, atomic_read(&core->bad_frames), 0);
+	KUNIT_EXPECT_EQ(test, atomic_read(&core->wrong_core), 0);
+}
+
+static struct kunit_case goodix_core_test_cases[] = {
+	KUNIT_CASE(goodix_core_test_binding),
+	KUNIT_CASE_SLOW(goodix_core_test_interleave),
+	KUNIT_CASE_SLOW(goodix_core_test_churn),
+	{}
+};
+
+static struct kunit_suite goodix_core_test_suite = {
+	.name = "goodix_ts_core_multi",
+	.init = goodix_core_test_init,
+	.exit = goodix_core_test_exit,
+	.test_cases = goodix_core_test_cases,
+};
+
+kunit_test_suite(goodix_core_test_suite);
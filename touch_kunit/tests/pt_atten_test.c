@@ -0,0 +1,259 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit stress test for the Parade attention lists.
+ *
+ * Built into pt_core.c. Reports are delivered through call_atten_cb()
+ * from the irq thread of the fake ATTN line while other threads keep subscribing and
+ * unsubscribing, and a callback unsubscribes itself from within the walk.
+ */
+
+#include <kunit/test.h>
+#include <linux/kthread.h>
+
+#include "../touch_kunit.h"
+
+#define PT_ATTEN_TEST_REPORTS	2000
+#define PT_ATTEN_TEST_RESUB	100
+#define PT_ATTEN_TEST_MODE	0x01
+#define PT_ATTEN_TEST_CHURNERS	2
+
+struct pt_atten_test_ctx {
+	struct pt_core_data *cd;
+	struct device *dev;
+	struct touch_kunit_irq line;
+	struct task_struct *churner[PT_ATTEN_TEST_CHURNERS];
+	atomic_t keep_calls;
+	atomic_t self_calls;
+	atomic_t churn_calls;
+	atomic_t wrong_mode;
+	atomic_t churn_subs;
+};
+
+static struct pt_atten_test_ctx *pt_atten_test_ctx;
+
+/* the list matches on the id pointer, not the string */
+static char pt_atten_test_keep_id[] = "keep";
+static char pt_atten_test_self_id[] = "self";
+static char pt_atten_test_mode_id[] = "mode";
+static char pt_atten_test_churn_id[PT_ATTEN_TEST_CHURNERS][8] = {
+	"churn0", "churn1",
+};
+
+static int pt_atten_test_keep(struct device *dev)
+{
+	atomic_inc(&pt_atten_test_ctx->keep_calls);
+	return 0;
+}
+
+static int pt_atten_test_self(struct device *dev)
+{
+	atomic_inc(&pt_atten_test_ctx->self_calls);
+	return _pt_unsubscribe_attention(dev, PT_ATTEN_IRQ,
+			pt_atten_test_self_id, pt_atten_test_self,
+			PT_ATTEN_TEST_MODE);
+}
+
+static int pt_atten_test_wrong_mode(struct device *dev)
+{
+	atomic_inc(&pt_atten_test_ctx->wrong_mode);
+	return 0;
+}
+
+static int pt_atten_test_churn(struct device *dev)
+{
+	atomic_inc(&pt_atten_test_ctx->churn_calls);
+	/* callbacks may sleep, keep the walk open a little */
+	usleep_range(1, 5);
+	return 0;
+}
+
+static irqreturn_t pt_atten_test_irq(int irq, void *data)
+{
+	struct pt_core_data *cd = data;
+
+	call_atten_cb(cd, PT_ATTEN_IRQ, PT_ATTEN_TEST_MODE);
+
+	return IRQ_HANDLED;
+}
+
+static int pt_atten_test_churn_thread(void *data)
+{
+	char *id = data;
+	struct device *dev = pt_atten_test_ctx->dev;
+
+	while (!kthread_should_stop()) {
+		_pt_subscribe_attention(dev, PT_ATTEN_IRQ, id,
+				pt_atten_test_churn, PT_ATTEN_TEST_MODE);
+		atomic_inc(&pt_atten_test_ctx->churn_subs);
+		cond_resched();
+		_pt_unsubscribe_attention(dev, PT_ATTEN_IRQ, id,
+				pt_atten_test_churn, PT_ATTEN_TEST_MODE);
+		cond_resched();
+	}
+
+	return 0;
+}
+
+static unsigned int pt_atten_test_count(struct pt_core_data *cd,
+		enum pt_atten_type type)
+{
+	struct atten_node *atten;
+	unsigned int count = 0;
+
+	mutex_lock(&cd->atten_lock);
+	list_for_each_entry(atten, &cd->atten_list[type], node)
+		count++;
+	mutex_unlock(&cd->atten_lock);
+
+	return count;
+}
+
+static int pt_atten_test_init(struct kunit *test)
+{
+	struct pt_atten_test_ctx *ctx;
+	enum pt_atten_type type;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	test->priv = ctx;
+
+	ctx->cd = kunit_kzalloc(test, sizeof(*ctx->cd), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx->cd);
+
+	ctx->dev = root_device_register("pt_atten_kunit");
+	KUNIT_ASSERT_FALSE(test, IS_ERR(ctx->dev));
+	dev_set_drvdata(ctx->dev, ctx->cd);
+	ctx->cd->dev = ctx->dev;
+
+	mutex_init(&ctx->cd->atten_lock);
+	KUNIT_ASSERT_EQ(test, init_srcu_struct(&ctx->cd->atten_srcu), 0);
+	for (type = 0; type < PT_ATTEN_NUM_ATTEN; type++)
+		INIT_LIST_HEAD(&ctx->cd->atten_list[type]);
+
+	pt_atten_test_ctx = ctx;
+	KUNIT_ASSERT_EQ(test, touch_kunit_irq_init(&ctx->line, NULL,
+			pt_atten_test_irq, ctx->cd), 0);
+
+	return 0;
+}
+
+static void pt_atten_test_exit(struct kunit *test)
+{
+	struct pt_atten_test_ctx *ctx = test->priv;
+	struct atten_node *atten, *tmp;
+	enum pt_atten_type type;
+
+	int i;
+
+	if (!ctx || !ctx->dev || IS_ERR(ctx->dev))
+		return;
+
+	for (i = 0; i < PT_ATTEN_TEST_CHURNERS; i++) {
+		if (!IS_ERR_OR_NULL(ctx->churner[i]))
+			kthread_stop(ctx->churner[i]);
+	}
+	touch_kunit_irq_release(&ctx->line);
+
+	/* no walk is left, free whatever is still subscribed */
+	for (type = 0; type < PT_ATTEN_NUM_ATTEN; type++) {
+		list_for_each_entry_safe(atten, tmp,
+				&ctx->cd->atten_list[type], node) {
+			list_del_rcu(&atten->node);
+			call_srcu(&ctx->cd->atten_srcu, &atten->rcu,
+					pt_free_atten_node);
+		}
+	}
+	srcu_barrier(&ctx->cd->atten_srcu);
+	cleanup_srcu_struct(&ctx->cd->atten_srcu);
+
+	root_device_unregister(ctx->dev);
+	pt_atten_test_ctx = NULL;
+}
+
+static void pt_atten_test_subscribe_once(struct kunit *test)
+{
+	struct pt_atten_test_ctx *ctx = test->priv;
+
+	KUNIT_EXPECT_EQ(test, _pt_subscribe_attention(ctx->dev, PT_ATTEN_IRQ,
+			pt_atten_test_keep_id, pt_atten_test_keep,
+			PT_ATTEN_TEST_MODE), 0);
+	KUNIT_EXPECT_EQ(test, _pt_subscribe_attention(ctx->dev, PT_ATTEN_IRQ,
+			pt_atten_test_keep_id, pt_atten_test_keep,
+			PT_ATTEN_TEST_MODE), 0);
+	KUNIT_EXPECT_EQ(test, pt_atten_test_count(ctx->cd, PT_ATTEN_IRQ), 1U);
+
+	touch_kunit_irq_fire(&ctx->line);
+	KUNIT_EXPECT_EQ(test, atomic_read(&ctx->keep_calls), 1);
+
+	KUNIT_EXPECT_EQ(test, _pt_unsubscribe_attention(ctx->dev,
+			PT_ATTEN_IRQ, pt_atten_test_keep_id, pt_atten_test_keep,
+			PT_ATTEN_TEST_MODE), 0);
+	KUNIT_EXPECT_EQ(test, _pt_unsubscribe_attention(ctx->dev,
+			PT_ATTEN_IRQ, pt_atten_test_keep_id, pt_atten_test_keep,
+			PT_ATTEN_TEST_MODE), -ENODEV);
+	KUNIT_EXPECT_EQ(test, pt_atten_test_count(ctx->cd, PT_ATTEN_IRQ), 0U);
+}
+
+static void pt_atten_test_stress(struct kunit *test)
+{
+	struct pt_atten_test_ctx *ctx = test->priv;
+	unsigned int resubs = 0;
+	int i;
+
+	_pt_subscribe_attention(ctx->dev, PT_ATTEN_IRQ, pt_atten_test_keep_id,
+			pt_atten_test_keep, PT_ATTEN_TEST_MODE);
+	_pt_subscribe_attention(ctx->dev, PT_ATTEN_IRQ, pt_atten_test_mode_id,
+			pt_atten_test_wrong_mode, PT_ATTEN_TEST_MODE << 1);
+
+	for (i = 0; i < PT_ATTEN_TEST_CHURNERS; i++) {
+		ctx->churner[i] = kthread_run(pt_atten_test_churn_thread,
+				pt_atten_test_churn_id[i], "pt_atten_kunit%d", i);
+		KUNIT_ASSERT_FALSE(test, IS_ERR(ctx->churner[i]));
+	}
+
+	for (i = 0; i < PT_ATTEN_TEST_REPORTS; i++) {
+		if (i % PT_ATTEN_TEST_RESUB == 0) {
+			_pt_subscribe_attention(ctx->dev, PT_ATTEN_IRQ,
+					pt_atten_test_self_id,
+					pt_atten_test_self,
+					PT_ATTEN_TEST_MODE);
+			resubs++;
+		}
+		touch_kunit_irq_fire(&ctx->line);
+	}
+
+	for (i = 0; i < PT_ATTEN_TEST_CHURNERS; i++) {
+		kthread_stop(ctx->churner[i]);
+		ctx->churner[i] = NULL;
+	}
+
+	/* the nodes that stayed subscribed saw every report */
+	KUNIT_EXPECT_EQ(test, atomic_read(&ctx->keep_calls),
+			PT_ATTEN_TEST_REPORTS);
+	/* the node removing itself ran once per subscription */
+	KUNIT_EXPECT_EQ(test, atomic_read(&ctx->self_calls), (int)resubs);
+	KUNIT_EXPECT_EQ(test, atomic_read(&ctx->wrong_mode), 0);
+	KUNIT_EXPECT_GT(test, atomic_read(&ctx->churn_subs), 0);
+
+	/* only keep and the other mode are left */
+	KUNIT_EXPECT_EQ(test, pt_atten_test_count(ctx->cd, PT_ATTEN_IRQ), 2U);
+
+	kunit_info(test, "%d churn subscriptions, %d churn callbacks\n",
+			atomic_read(&ctx->churn_subs),
+			atomic_read(&ctx->churn_calls));
+}
+
+static struct kunit_case pt_atten_test_cases[] = {
+	KUNIT_CASE(pt_atten_test_subscribe_once),
+	KUNIT_CASE(pt_atten_test_stress),
+	{}
+};
+
+static struct kunit_suite pt_atten_test_suite = {
+	.name = "pt_atten",
+	.init = pt_atten_test_init,
+	.exit = pt_atten_test_exit,
+	.test_cases = pt_atten_test_cases,
+};
+
+kunit_test_suite(pt_atten_test_suite);
@@ -0,0 +1,204 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the Parade predictive I2C report reads.
+ *
+ * Built into pt_i2c.c. pt_i2c_read_default_nosize() runs against a mock
+ * i2c adapter; every read message takes one canned frame, so a frame is
+ * queued for each transaction the device would see and the transaction
+ * count tells a single-read hit from a follow-up read.
+ */
+
+#include <kunit/test.h>
+
+#include "../touch_kunit.h"
+
+#define PT_I2C_TEST_ADDR	0x24
+
+struct pt_i2c_test_ctx {
+	struct touch_kunit_bus *bus;
+	struct pt_core_data *cd;
+	struct device *dev;
+	u8 *buf;
+};
+
+static int pt_i2c_test_init(struct kunit *test)
+{
+	struct pt_i2c_test_ctx *ctx;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	test->priv = ctx;
+
+	ctx->cd = kunit_kzalloc(test, sizeof(*ctx->cd), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx->cd);
+	ctx->buf = kunit_kzalloc(test, PT_I2C_DATA_SIZE, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx->buf);
+
+	ctx->bus = touch_kunit_i2c_bus_create(PT_I2C_TEST_ADDR);
+	KUNIT_ASSERT_NOT_NULL(test, ctx->bus);
+
+	ctx->dev = &ctx->bus->client->dev;
+	dev_set_drvdata(ctx->dev, ctx->cd);
+
+	return 0;
+}
+
+static void pt_i2c_test_exit(struct kunit *test)
+{
+	struct pt_i2c_test_ctx *ctx = test->priv;
+
+	if (!ctx || !ctx->bus)
+		return;
+
+	dev_set_drvdata(ctx->dev, NULL);
+	touch_kunit_bus_destroy(ctx->bus);
+}
+
+/* a HID packet of size bytes, length header first */
+static void pt_i2c_test_queue_packet(struct kunit *test, u16 size, u8 fill)
+{
+	struct pt_i2c_test_ctx *ctx = test->priv;
+	u8 packet[PT_I2C_DATA_SIZE];
+
+	memset(packet, fill, sizeof(packet));
+	put_unaligned_le16(size, packet);
+	KUNIT_ASSERT_EQ(test, touch_kunit_bus_queue_frame(ctx->bus, packet,
+			clamp_t(unsigned int, size, 2, sizeof(packet))), 0);
+}
+
+static void pt_i2c_test_expect_packet(struct kunit *test, u16 size, u8 fill)
+{
+	struct pt_i2c_test_ctx *ctx = test->priv;
+	int i;
+
+	KUNIT_EXPECT_EQ(test, get_unaligned_le16(ctx->buf), size);
+	for (i = 2; i < size; i++) {
+		if (ctx->buf[i] != fill) {
+			KUNIT_FAIL(test, "byte %d is 0x%02x, expected 0x%02x",
+					i, ctx->buf[i], fill);
+			return;
+		}
+	}
+}
+
+static void pt_i2c_test_disabled(struct kunit *test)
+{
+	struct pt_i2c_test_ctx *ctx = test->priv;
+
+	/* header read, then the whole packet again */
+	pt_i2c_test_queue_packet(test, 40, 0x5a);
+	pt_i2c_test_queue_packet(test, 40, 0x5a);
+
+	KUNIT_EXPECT_EQ(test, pt_i2c_read_default_nosize(ctx->dev, ctx->buf,
+			PT_I2C_DATA_SIZE), 0);
+	KUNIT_EXPECT_EQ(test, ctx->bus->msg_count, 2U);
+	pt_i2c_test_expect_packet(test, 40, 0x5a);
+	KUNIT_EXPECT_EQ(test, ctx->cd->predict_read_hit, 0U);
+	KUNIT_EXPECT_EQ(test, ctx->cd->predict_read_miss, 0U);
+}
+
+static void pt_i2c_test_hit(struct kunit *test)
+{
+	struct pt_i2c_test_ctx *ctx = test->priv;
+
+	ctx->cd->predictive_read = true;
+	ctx->cd->predict_read_size = 40;
+
+	/* a packet of the last seen size takes one transaction */
+	pt_i2c_test_queue_packet(test, 40, 0xa5);
+	KUNIT_EXPECT_EQ(test, pt_i2c_read_default_nosize(ctx->dev, ctx->buf,
+			PT_I2C_DATA_SIZE), 0);
+	KUNIT_EXPECT_EQ(test, ctx->bus->msg_count, 1U);
+	pt_i2c_test_expect_packet(test, 40, 0xa5);
+
+	/* and so does a slightly larger one, within the headroom */
+	pt_i2c_test_queue_packet(test, 40 + PT_I2C_PREDICT_HEADROOM, 0x3c);
+	KUNIT_EXPECT_EQ(test, pt_i2c_read_default_nosize(ctx->dev, ctx->buf,
+			PT_I2C_DATA_SIZE), 0);
+	KUNIT_EXPECT_EQ(test, ctx->bus->msg_count, 2U);
+	pt_i2c_test_expect_packet(test, 40 + PT_I2C_PREDICT_HEADROOM, 0x3c);
+
+	KUNIT_EXPECT_EQ(test, ctx->cd->predict_read_hit, 2U);
+	KUNIT_EXPECT_EQ(test, ctx->cd->predict_read_miss, 0U);
+	KUNIT_EXPECT_EQ(test, ctx->cd->predict_read_size,
+			(u16)(40 + PT_I2C_PREDICT_HEADROOM));
+}
+
+static void pt_i2c_test_miss(struct kunit *test)
+{
+	struct pt_i2c_test_ctx *ctx = test->priv;
+
+	ctx->cd->predictive_read = true;
+
+	/* nothing seen yet, the packet is read again in full */
+	pt_i2c_test_queue_packet(test, 100, 0x11);
+	pt_i2c_test_queue_packet(test, 100, 0x11);
+	KUNIT_EXPECT_EQ(test, pt_i2c_read_default_nosize(ctx->dev, ctx->buf,
+			PT_I2C_DATA_SIZE), 0);
+	KUNIT_EXPECT_EQ(test, ctx->bus->msg_count, 2U);
+	pt_i2c_test_expect_packet(test, 100, 0x11);
+	KUNIT_EXPECT_EQ(test, ctx->cd->predict_read_miss, 1U);
+	KUNIT_EXPECT_EQ(test, ctx->cd->predict_read_size, (u16)100);
+
+	/* the next packet of that size is predicted */
+	pt_i2c_test_queue_packet(test, 100, 0x22);
+	KUNIT_EXPECT_EQ(test, pt_i2c_read_default_nosize(ctx->dev, ctx->buf,
+			PT_I2C_DATA_SIZE), 0);
+	KUNIT_EXPECT_EQ(test, ctx->bus->msg_count, 3U);
+	pt_i2c_test_expect_packet(test, 100, 0x22);
+	KUNIT_EXPECT_EQ(test, ctx->cd->predict_read_hit, 1U);
+}
+
+static void pt_i2c_test_empty(struct kunit *test)
+{
+	struct pt_i2c_test_ctx *ctx = test->priv;
+
+	ctx->cd->predictive_read = true;
+	ctx->cd->predict_read_size = 40;
+
+	/* empty buffers before and from PIP 1.7 */
+	pt_i2c_test_queue_packet(test, 2, 0);
+	KUNIT_EXPECT_EQ(test, pt_i2c_read_default_nosize(ctx->dev, ctx->buf,
+			PT_I2C_DATA_SIZE), 0);
+	pt_i2c_test_queue_packet(test, PT_PIP_1P7_EMPTY_BUF, 0);
+	KUNIT_EXPECT_EQ(test, pt_i2c_read_default_nosize(ctx->dev, ctx->buf,
+			PT_I2C_DATA_SIZE), 0);
+
+	KUNIT_EXPECT_EQ(test, ctx->bus->msg_count, 2U);
+	KUNIT_EXPECT_EQ(test, ctx->cd->predict_read_hit, 2U);
+	/* an empty buffer does not shrink the prediction */
+	KUNIT_EXPECT_EQ(test, ctx->cd->predict_read_size, (u16)40);
+}
+
+static void pt_i2c_test_oversized(struct kunit *test)
+{
+	struct pt_i2c_test_ctx *ctx = test->priv;
+
+	ctx->cd->predictive_read = true;
+	ctx->cd->predict_read_size = 40;
+
+	/* a length header above max is refused without a follow-up read */
+	pt_i2c_test_queue_packet(test, 64, 0x77);
+	KUNIT_EXPECT_EQ(test, pt_i2c_read_default_nosize(ctx->dev, ctx->buf,
+			48), -EINVAL);
+	KUNIT_EXPECT_EQ(test, ctx->bus->msg_count, 1U);
+	KUNIT_EXPECT_EQ(test, ctx->cd->predict_read_size, (u16)40);
+}
+
+static struct kunit_case pt_i2c_test_cases[] = {
+	KUNIT_CASE(pt_i2c_test_disabled),
+	KUNIT_CASE(pt_i2c_test_hit),
+	KUNIT_CASE(pt_i2c_test_miss),
+	KUNIT_CASE(pt_i2c_test_empty),
+	KUNIT_CASE(pt_i2c_test_oversized),
+	{}
+};
+
+static struct kunit_suite pt_i2c_test_suite = {
+	.name = "pt_i2c_predictive_read",
+	.init = pt_i2c_test_init,
+	.exit = pt_i2c_test_exit,
+	.test_cases = pt_i2c_test_cases,
+};
+
+kunit_test_suite(pt_i2c_test_suite);
@@ -0,0 +1,214 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the QTS pending interrupt latch.
+ *
+ * Built into qts_core.c. A fake vendor client is registered on a hand
+ * built qts_data and the fake ATTN line runs qts_irq_handler() from the
+ * irq core, also from inside the client's suspend and resume callbacks
+ * while the transition lock is held.
+ */
+
+#include <kunit/test.h>
+
+#include "../touch_kunit.h"
+
+struct qts_test_client {
+	struct touch_kunit_irq *line;
+	/* interrupts fired from inside each transition callback */
+	unsigned int fire_in_transition;
+	atomic_t handled;
+	atomic_t suspended;
+	atomic_t resumed;
+};
+
+struct qts_test_ctx {
+	struct touch_kunit_irq line;
+	struct qts_test_client client;
+	struct qts_data *qts_data;
+};
+
+static void qts_test_fire_in_transition(struct qts_test_client *client)
+{
+	unsigned int i;
+
+	for (i = 0; i < client->fire_in_transition; i++)
+		touch_kunit_irq_fire(client->line);
+}
+
+static irqreturn_t qts_test_client_irq(int irq, void *data)
+{
+	struct qts_test_client *client = data;
+
+	atomic_inc(&client->handled);
+	return IRQ_HANDLED;
+}
+
+static int qts_test_client_suspend(void *data)
+{
+	struct qts_test_client *client = data;
+
+	atomic_inc(&client->suspended);
+	qts_test_fire_in_transition(client);
+	return 0;
+}
+
+static int qts_test_client_resume(void *data)
+{
+	struct qts_test_client *client = data;
+
+	atomic_inc(&client->resumed);
+	qts_test_fire_in_transition(client);
+	return 0;
+}
+
+static int qts_test_init(struct kunit *test)
+{
+	struct qts_test_ctx *ctx;
+	struct qts_data *qts_data;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	test->priv = ctx;
+
+	qts_data = kunit_kzalloc(test, sizeof(*qts_data), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, qts_data);
+	ctx->qts_data = qts_data;
+
+	/* what qts_client_register() sets up for the latch */
+	mutex_init(&qts_data->transition_lock);
+	atomic_set(&qts_data->irq_pending, 0);
+	atomic_set(&qts_data->irq_replayed_cnt, 0);
+	atomic_set(&qts_data->irq_discarded_cnt, 0);
+	atomic_set(&qts_data->trusted_touch_enabled, 0);
+	atomic_set(&qts_data->trusted_touch_transition, 0);
+
+	ctx->client.line = &ctx->line;
+	qts_data->vendor_data = &ctx->client;
+	qts_data->vendor_ops.irq_handler = qts_test_client_irq;
+	qts_data->vendor_ops.suspend = qts_test_client_suspend;
+	qts_data->vendor_ops.resume = qts_test_client_resume;
+
+	KUNIT_ASSERT_EQ(test, touch_kunit_irq_init(&ctx->line, NULL,
+			qts_irq_handler, qts_data), 0);
+	qts_data->irq = ctx->line.irq;
+
+	return 0;
+}
+
+static void qts_test_exit(struct kunit *test)
+{
+	struct qts_test_ctx *ctx = test->priv;
+
+	if (!ctx)
+		return;
+
+	touch_kunit_irq_release(&ctx->line);
+}
+
+static void qts_test_uncontended(struct kunit *test)
+{
+	struct qts_test_ctx *ctx = test->priv;
+	struct qts_data *qts_data = ctx->qts_data;
+
+	touch_kunit_irq_fire(&ctx->line);
+	touch_kunit_irq_fire(&ctx->line);
+
+	/* handed straight to the client, nothing latched */
+	KUNIT_EXPECT_EQ(test, atomic_read(&ctx->client.handled), 2);
+	KUNIT_EXPECT_EQ(test, atomic_read(&qts_data->irq_pending), 0);
+	KUNIT_EXPECT_EQ(test, atomic_read(&qts_data->irq_replayed_cnt), 0);
+	KUNIT_EXPECT_EQ(test, atomic_read(&qts_data->irq_discarded_cnt), 0);
+}
+
+static void qts_test_replay(struct kunit *test)
+{
+	struct qts_test_ctx *ctx = test->priv;
+	struct qts_data *qts_data = ctx->qts_data;
+
+	mutex_lock(&qts_data->transition_lock);
+	touch_kunit_irq_fire(&ctx->line);
+	touch_kunit_irq_fire(&ctx->line);
+
+	/* held back while the lock is busy, and coalesced */
+	KUNIT_EXPECT_EQ(test, atomic_read(&ctx->client.handled), 0);
+	KUNIT_EXPECT_EQ(test, atomic_read(&qts_data->irq_pending), 1);
+
+	qts_transition_unlock(qts_data);
+
+	KUNIT_EXPECT_EQ(test, atomic_read(&ctx->client.handled), 1);
+	KUNIT_EXPECT_EQ(test, atomic_read(&qts_data->irq_pending), 0);
+	KUNIT_EXPECT_EQ(test, atomic_read(&qts_data->irq_replayed_cnt), 1);
+	KUNIT_EXPECT_EQ(test, atomic_read(&qts_data->irq_discarded_cnt), 0);
+}
+
+static void qts_test_suspend_discard(struct kunit *test)
+{
+	struct qts_test_ctx *ctx = test->priv;
+	struct qts_data *qts_data = ctx->qts_data;
+
+	ctx->client.fire_in_transition = 3;
+	qts_ts_suspend(qts_data);
+
+	/* the frame that raced the suspend is dropped on purpose */
+	KUNIT_EXPECT_EQ(test, atomic_read(&ctx->client.suspended), 1);
+	KUNIT_EXPECT_TRUE(test, qts_data->suspended);
+	KUNIT_EXPECT_EQ(test, atomic_read(&ctx->client.handled), 0);
+	KUNIT_EXPECT_EQ(test, atomic_read(&qts_data->irq_pending), 0);
+	KUNIT_EXPECT_EQ(test, atomic_read(&qts_data->irq_replayed_cnt), 0);
+	KUNIT_EXPECT_EQ(test, atomic_read(&qts_data->irq_discarded_cnt), 1);
+}
+
+static void qts_test_resume_replay(struct kunit *test)
+{
+	struct qts_test_ctx *ctx = test->priv;
+	struct qts_data *qts_data = ctx->qts_data;
+
+	qts_data->suspended = true;
+	ctx->client.fire_in_transition = 1;
+	qts_ts_resume(qts_data);
+
+	/* the touch down right after unlock is not lost */
+	KUNIT_EXPECT_EQ(test, atomic_read(&ctx->client.resumed), 1);
+	KUNIT_EXPECT_FALSE(test, qts_data->suspended);
+	KUNIT_EXPECT_EQ(test, atomic_read(&ctx->client.handled), 1);
+	KUNIT_EXPECT_EQ(test, atomic_read(&qts_data->irq_replayed_cnt), 1);
+	KUNIT_EXPECT_EQ(test, atomic_read(&qts_data->irq_discarded_cnt), 0);
+}
+
+static void qts_test_lent_discard(struct kunit *test)
+{
+	struct qts_test_ctx *ctx = test->priv;
+	struct qts_data *qts_data = ctx->qts_data;
+
+	mutex_lock(&qts_data->transition_lock);
+	touch_kunit_irq_fire(&ctx->line);
+	/* the transition ends with the irq owned by the other VM */
+#ifdef CONFIG_ARCH_QTI_VM
+	atomic_set(&qts_data->trusted_touch_enabled, 0);
+#else
+	atomic_set(&qts_data->trusted_touch_enabled, 1);
+#endif
+	qts_transition_unlock(qts_data);
+
+	KUNIT_EXPECT_EQ(test, atomic_read(&ctx->client.handled), 0);
+	KUNIT_EXPECT_EQ(test, atomic_read(&qts_data->irq_replayed_cnt), 0);
+	KUNIT_EXPECT_EQ(test, atomic_read(&qts_data->irq_discarded_cnt), 1);
+}
+
+static struct kunit_case qts_test_cases[] = {
+	KUNIT_CASE(qts_test_uncontended),
+	KUNIT_CASE(qts_test_replay),
+	KUNIT_CASE(qts_test_suspend_discard),
+	KUNIT_CASE(qts_test_resume_replay),
+	KUNIT_CASE(qts_test_lent_discard),
+	{}
+};
+
+static struct kunit_suite qts_test_suite = {
+	.name = "qts_core",
+	.init = qts_test_init,
+	.exit = qts_test_exit,
+	.test_cases = qts_test_cases,
+};
+
+kunit_test_suite(qts_test_suite);
@@ -0,0 +1,349 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the TCM2 ISR latency stages.
+ *
+ * Built into syna_tcm2.c. A TouchComm v1 touch report is served by the
+ * mock spi controller, the fake ATTN line runs syna_dev_hardirq() and
+ * syna_dev_isr() from the irq core, and the input capture sees what
+ * reaches the input core.
+ */
+
+#include <kunit/test.h>
+#include <linux/input/mt.h>
+
+#include "../touch_kunit.h"
+
+#if defined(ENABLE_ISR_LATENCY_STATS)
+
+/* TouchComm v1 framing, private to synaptics_touchcom_core_v1.c */
+#define SYNA_ISR_TEST_MARKER 0xa5
+#define SYNA_ISR_TEST_PADDING 0x5a
+
+/* one object: classification, x and y, as read by the generic parser */
+static const unsigned char syna_isr_test_config[] = {
+	TOUCH_REPORT_FOREACH_OBJECT,
+	TOUCH_REPORT_OBJECT_N_CLASSIFICATION, 8,
+	TOUCH_REPORT_OBJECT_N_X_POSITION, 16,
+	TOUCH_REPORT_OBJECT_N_Y_POSITION, 16,
+	TOUCH_REPORT_FOREACH_END,
+	TOUCH_REPORT_END,
+};
+
+struct syna_isr_test_ctx {
+	struct touch_kunit_bus *bus;
+	struct touch_kunit_irq line;
+	struct touch_kunit_input cap;
+	bool captured;
+	struct syna_hw_interface *hw_if;
+	struct syna_tcm *tcm;
+};
+
+static int syna_isr_test_read(struct syna_hw_interface *hw_if,
+		unsigned char *rd_data, unsigned int rd_len)
+{
+	int retval;
+
+	retval = spi_read(hw_if->pdev, rd_data, rd_len);
+
+	return (retval < 0) ? retval : rd_len;
+}
+
+static int syna_isr_test_write(struct syna_hw_interface *hw_if,
+		unsigned char *wr_data, unsigned int wr_len)
+{
+	int retval;
+
+	retval = spi_write(hw_if->pdev, wr_data, wr_len);
+
+	return (retval < 0) ? retval : wr_len;
+}
+
+static int syna_isr_test_touch_config(struct tcm_dev *tcm_dev)
+{
+	int retval;
+
+	retval = syna_tcm_buf_alloc(&tcm_dev->touch_config,
+			sizeof(syna_isr_test_config));
+	if (retval < 0)
+		return retval;
+
+	memcpy(tcm_dev->touch_config.buf, syna_isr_test_config,
+			sizeof(syna_isr_test_config));
+	tcm_dev->touch_config.data_length = sizeof(syna_isr_test_config);
+
+	/* as syna_tcm_preserve_touch_report_config() would leave them */
+	tcm_dev->end_config_loop = 8;
+	tcm_dev->bits_config_loop = 40;
+	tcm_dev->bits_config_tailing = 0;
+	tcm_dev->max_objects = 1;
+
+	return 0;
+}
+
+static struct input_dev *syna_isr_test_input_dev(void)
+{
+	struct input_dev *input_dev;
+
+	input_dev = input_allocate_device();
+	if (!input_dev)
+		return NULL;
+
+	input_dev->name = "syna_tcm2_kunit";
+	input_dev->id.bustype = BUS_VIRTUAL;
+	input_set_capability(input_dev, EV_KEY, BTN_TOUCH);
+	input_set_capability(input_dev, EV_KEY, BTN_TOOL_FINGER);
+	input_set_abs_params(input_dev, ABS_MT_POSITION_X, 0, 0xffff, 0, 0);
+	input_set_abs_params(input_dev, ABS_MT_POSITION_Y, 0, 0xffff, 0, 0);
+	input_set_abs_params(input_dev, ABS_MT_TOUCH_MAJOR, 0, 0xff, 0, 0);
+	input_set_abs_params(input_dev, ABS_MT_TOUCH_MINOR, 0, 0xff, 0, 0);
+	if (input_mt_init_slots(input_dev, 1, INPUT_MT_DIRECT)) {
+		input_free_device(input_dev);
+		return NULL;
+	}
+
+	if (input_register_device(input_dev)) {
+		input_free_device(input_dev);
+		return NULL;
+	}
+
+	return input_dev;
+}
+
+static int syna_isr_test_init(struct kunit *test)
+{
+	struct syna_isr_test_ctx *ctx;
+	struct syna_tcm *tcm;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	test->priv = ctx;
+
+	ctx->bus = touch_kunit_spi_bus_create();
+	KUNIT_ASSERT_NOT_NULL(test, ctx->bus);
+
+	ctx->hw_if = kunit_kzalloc(test, sizeof(*ctx->hw_if), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx->hw_if);
+	ctx->hw_if->pdev = ctx->bus->spi;
+	ctx->hw_if->ops_read_data = syna_isr_test_read;
+	ctx->hw_if->ops_write_data = syna_isr_test_write;
+
+	tcm = kunit_kzalloc(test, sizeof(*tcm), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, tcm);
+	ctx->tcm = tcm;
+
+	tcm->hw_if = ctx->hw_if;
+	tcm->pwr_state = PWR_ON;
+	syna_pal_mutex_alloc(&tcm->tp_event_mutex);
+	syna_tcm_buf_init(&tcm->event_data);
+	spin_lock_init(&tcm->isr_latency.lock);
+
+	KUNIT_ASSERT_EQ(test, syna_tcm_allocate_device(&tcm->tcm_dev,
+			ctx->hw_if, RESP_IN_ATTN), 0);
+	syna_tcm_v1_set_ops(tcm->tcm_dev);
+	KUNIT_ASSERT_EQ(test, syna_isr_test_touch_config(tcm->tcm_dev), 0);
+
+	tcm->input_dev = syna_isr_test_input_dev();
+	KUNIT_ASSERT_NOT_NULL(test, tcm->input_dev);
+
+	KUNIT_ASSERT_EQ(test, touch_kunit_input_capture(&ctx->cap,
+			tcm->input_dev), 0);
+	ctx->captured = true;
+
+	KUNIT_ASSERT_EQ(test, touch_kunit_irq_init(&ctx->line,
+			syna_dev_hardirq, syna_dev_isr, tcm), 0);
+	/* the handler samples the fake line, asserted while fired */
+	ctx->hw_if->bdata_attn.irq_gpio = ctx->line.gpio;
+	ctx->hw_if->bdata_attn.irq_on_state = 0;
+
+	return 0;
+}
+
+static void syna_isr_test_exit(struct kunit *test)
+{
+	struct syna_isr_test_ctx *ctx = test->priv;
+	struct syna_tcm *tcm;
+
+	if (!ctx)
+		return;
+
+	touch_kunit_irq_release(&ctx->line);
+
+	tcm = ctx->tcm;
+	if (tcm) {
+		syna_dev_isr_latency_enable(tcm, false);
+
+		if (ctx->captured)
+			touch_kunit_input_release(&ctx->cap);
+		if (tcm->input_dev)
+			input_unregister_device(tcm->input_dev);
+		if (tcm->tcm_dev)
+			syna_tcm_remove_device(tcm->tcm_dev);
+		syna_tcm_buf_release(&tcm->event_data);
+	}
+
+	touch_kunit_bus_destroy(ctx->bus);
+}
+
+/* header read, then the continued read carrying the one finger */
+static void syna_isr_test_queue_touch(struct kunit *test,
+		unsigned short x, unsigned short y)
+{
+	struct syna_isr_test_ctx *ctx = test->priv;
+	unsigned char header[] = {
+		SYNA_ISR_TEST_MARKER, REPORT_TOUCH, 5, 0x00,
+	};
+	unsigned char payload[] = {
+		SYNA_ISR_TEST_MARKER, STATUS_CONTINUED_READ,
+		FINGER, x & 0xff, x >> 8, y & 0xff, y >> 8,
+		SYNA_ISR_TEST_PADDING,
+	};
+
+	KUNIT_ASSERT_EQ(test, touch_kunit_bus_queue_frame(ctx->bus, header,
+			sizeof(header)), 0);
+	KUNIT_ASSERT_EQ(test, touch_kunit_bus_queue_frame(ctx->bus, payload,
+			sizeof(payload)), 0);
+}
+
+static void syna_isr_test_all_stages(struct kunit *test)
+{
+	struct syna_isr_test_ctx *ctx = test->priv;
+	struct syna_isr_latency_hist *hist = ctx->tcm->isr_latency.hist;
+	char *buf;
+	int i;
+
+	syna_dev_isr_latency_enable(ctx->tcm, true);
+	syna_isr_test_queue_touch(test, 0x140, 0x280);
+
+	KUNIT_EXPECT_EQ(test, (int)touch_kunit_irq_fire(&ctx->line),
+			(int)IRQ_HANDLED);
+	KUNIT_EXPECT_EQ(test, atomic_read(&ctx->line.threaded), 1);
+	/* the irq thread of this device was moved to SCHED_FIFO */
+	KUNIT_EXPECT_NOT_NULL(test, ctx->tcm->isr_task);
+
+	/* the frame reached the input core */
+	KUNIT_EXPECT_EQ(test, ctx->tcm->tp_data.object_data[0].x_pos, 0x140U);
+	KUNIT_EXPECT_EQ(test, ctx->tcm->tp_data.object_data[0].status,
+			(unsigned char)FINGER);
+	KUNIT_EXPECT_EQ(test, touch_kunit_input_count(&ctx->cap,
+			EV_ABS, ABS_MT_POSITION_X), 1U);
+	KUNIT_EXPECT_EQ(test, touch_kunit_input_count(&ctx->cap,
+			EV_SYN, SYN_REPORT), 1U);
+
+	/* every stage of a touch report is recorded once */
+	for (i = 0; i < ISR_STAGE_MAX; i++) {
+		if (i == ISR_STAGE_THP)
+			continue;
+		KUNIT_EXPECT_EQ_MSG(test, hist[i].count, 1ULL,
+				"stage %s", isr_latency_stage_str[i]);
+		KUNIT_EXPECT_LE(test, hist[i].min_us, hist[i].max_us);
+	}
+	/* not a thp frame */
+	KUNIT_EXPECT_EQ(test, hist[ISR_STAGE_THP].count, 0ULL);
+	/* the total covers the stages in between */
+	KUNIT_EXPECT_GE(test, hist[ISR_STAGE_TOTAL].max_us,
+			hist[ISR_STAGE_REPORT].max_us);
+
+	buf = kunit_kzalloc(test, PAGE_SIZE, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, buf);
+	KUNIT_EXPECT_GT(test, syna_dev_isr_latency_show(ctx->tcm, buf,
+			PAGE_SIZE), 0);
+	KUNIT_EXPECT_NOT_NULL(test, strstr(buf, "total"));
+}
+
+static void syna_isr_test_disabled(struct kunit *test)
+{
+	struct syna_isr_test_ctx *ctx = test->priv;
+	struct syna_isr_latency_hist *hist = ctx->tcm->isr_latency.hist;
+	int i;
+
+	syna_isr_test_queue_touch(test, 0x10, 0x20);
+
+	KUNIT_EXPECT_EQ(test, (int)touch_kunit_irq_fire(&ctx->line),
+			(int)IRQ_HANDLED);
+
+	/* the report goes through, nothing is timed */
+	KUNIT_EXPECT_EQ(test, touch_kunit_input_count(&ctx->cap,
+			EV_SYN, SYN_REPORT), 1U);
+	for (i = 0; i < ISR_STAGE_MAX; i++)
+		KUNIT_EXPECT_EQ(test, hist[i].count, 0ULL);
+	KUNIT_EXPECT_EQ(test, ctx->tcm->isr_latency.hardirq_time, (ktime_t)0);
+}
+
+static void syna_isr_test_reset(struct kunit *test)
+{
+	struct syna_isr_test_ctx *ctx = test->priv;
+	struct syna_isr_latency_hist *hist = ctx->tcm->isr_latency.hist;
+	int i;
+
+	syna_dev_isr_latency_enable(ctx->tcm, true);
+	syna_isr_test_queue_touch(test, 0x10, 0x20);
+	touch_kunit_irq_fire(&ctx->line);
+
+	KUNIT_EXPECT_EQ(test, hist[ISR_STAGE_TOTAL].count, 1ULL);
+
+	syna_dev_isr_latency_reset(ctx->tcm);
+	for (i = 0; i < ISR_STAGE_MAX; i++)
+		KUNIT_EXPECT_EQ(test, hist[i].count, 0ULL);
+}
+
+static void syna_isr_test_shared_key(struct kunit *test)
+{
+	struct syna_isr_test_ctx *ctx = test->priv;
+	struct syna_tcm *other;
+
+	other = kunit_kzalloc(test, sizeof(*other), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, other);
+	spin_lock_init(&other->isr_latency.lock);
+
+	syna_dev_isr_latency_enable(ctx->tcm, true);
+	syna_dev_isr_latency_enable(other, true);
+	/* enabling twice does not take a second reference */
+	syna_dev_isr_latency_enable(other, true);
+	KUNIT_EXPECT_TRUE(test, static_key_enabled(&syna_isr_latency_key));
+
+	/* stopping one device leaves the other one collecting */
+	syna_dev_isr_latency_enable(other, false);
+	KUNIT_EXPECT_TRUE(test, static_key_enabled(&syna_isr_latency_key));
+	syna_isr_test_queue_touch(test, 0x10, 0x20);
+	touch_kunit_irq_fire(&ctx->line);
+	KUNIT_EXPECT_EQ(test,
+			ctx->tcm->isr_latency.hist[ISR_STAGE_TOTAL].count, 1ULL);
+
+	syna_dev_isr_latency_enable(ctx->tcm, false);
+	KUNIT_EXPECT_FALSE(test, static_key_enabled(&syna_isr_latency_key));
+}
+
+static void syna_isr_test_bucket(struct kunit *test)
+{
+	unsigned int us;
+
+	/* each latency lands in a bucket whose upper bound covers it */
+	for (us = 0; us < 100000; us += (us < 64) ? 1 : us / 7) {
+		unsigned int idx = syna_dev_isr_latency_bucket(us);
+
+		KUNIT_EXPECT_LE(test, us, syna_dev_isr_latency_bucket_max(idx));
+		if (idx > 0)
+			KUNIT_EXPECT_GT(test, us,
+				syna_dev_isr_latency_bucket_max(idx - 1));
+	}
+}
+
+static struct kunit_case syna_isr_test_cases[] = {
+	KUNIT_CASE(syna_isr_test_all_stages),
+	KUNIT_CASE(syna_isr_test_disabled),
+	KUNIT_CASE(syna_isr_test_reset),
+	KUNIT_CASE(syna_isr_test_shared_key),
+	KUNIT_CASE(syna_isr_test_bucket),
+	{}
+};
+
+static struct kunit_suite syna_isr_test_suite = {
+	.name = "syna_tcm2_isr",
+	.init = syna_isr_test_init,
+	.exit = syna_isr_test_exit,
+	.test_cases = syna_isr_test_cases,
+};
+
+kunit_test_suite(syna_isr_test_suite);
+
+#endif /* ENABLE_ISR_LATENCY_STATS */
@@ -0,0 +1,239 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the TCM2 spi bus layer.
+ *
+ * Built into syna_tcm2_platform_spi.c, so the static read and write
+ * helpers are called as they are and talk to the mock spi controller.
+ */
+
+#include <kunit/test.h>
+
+#include "../touch_kunit.h"
+
+struct syna_spi_test_ctx {
+	struct touch_kunit_bus *bus;
+	struct platform_device *pdev;
+	struct platform_device *saved_pdev;
+	struct syna_tcm *tcm;
+	struct syna_hw_interface hw_if;
+};
+
+static int syna_spi_test_init(struct kunit *test)
+{
+	struct syna_spi_test_ctx *ctx;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	test->priv = ctx;
+
+	ctx->tcm = kunit_kzalloc(test, sizeof(*ctx->tcm), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx->tcm);
+
+	ctx->bus = touch_kunit_spi_bus_create();
+	KUNIT_ASSERT_NOT_NULL(test, ctx->bus);
+
+	ctx->pdev = platform_device_alloc("syna_tcm2_kunit",
+			PLATFORM_DEVID_AUTO);
+	KUNIT_ASSERT_NOT_NULL(test, ctx->pdev);
+	platform_set_drvdata(ctx->pdev, ctx->tcm);
+
+	/* the bus helpers find the tcm through the platform device */
+	ctx->saved_pdev = syna_spi_device;
+	syna_spi_device = ctx->pdev;
+
+	ctx->hw_if.pdev = ctx->bus->spi;
+	ctx->hw_if.bdata_io.spi_byte_delay_chunk = 1;
+	syna_pal_mutex_alloc(&ctx->hw_if.bdata_io.io_mutex);
+
+	return 0;
+}
+
+static void syna_spi_test_exit(struct kunit *test)
+{
+	struct syna_spi_test_ctx *ctx = test->priv;
+
+	if (!ctx)
+		return;
+
+	if (ctx->pdev) {
+		syna_spi_device = ctx->saved_pdev;
+		platform_device_put(ctx->pdev);
+	}
+
+	touch_kunit_bus_destroy(ctx->bus);
+}
+
+static void syna_spi_test_read_frame(struct kunit *test)
+{
+	struct syna_spi_test_ctx *ctx = test->priv;
+	unsigned char frame[] = {0xa5, 0x11, 0x04, 0x00, 0x01, 0x02, 0x03, 0x04};
+	unsigned char buf[sizeof(frame)] = {0};
+
+	KUNIT_ASSERT_EQ(test, touch_kunit_bus_queue_frame(ctx->bus, frame,
+			sizeof(frame)), 0);
+
+	KUNIT_EXPECT_EQ(test, syna_spi_read(&ctx->hw_if, buf, sizeof(buf)),
+			(int)sizeof(buf));
+	KUNIT_EXPECT_EQ(test, memcmp(buf, frame, sizeof(frame)), 0);
+
+	KUNIT_EXPECT_EQ(test, ctx->bus->msg_count, 1U);
+	KUNIT_ASSERT_EQ(test, ctx->bus->xfer_count, 1U);
+	KUNIT_EXPECT_EQ(test, ctx->bus->xfers[0].len, (unsigned int)sizeof(buf));
+	KUNIT_EXPECT_TRUE(test, ctx->bus->xfers[0].rx);
+	/* reads go through rx_buf and are copied out */
+	KUNIT_EXPECT_EQ(test, ctx->tcm->bus_bytes_copied,
+			(unsigned long long)sizeof(buf));
+	/* nothing the host clocked out while reading counts as written */
+	KUNIT_EXPECT_EQ(test, ctx->bus->write_len, 0U);
+}
+
+static void syna_spi_test_read_direct(struct kunit *test)
+{
+	struct syna_spi_test_ctx *ctx = test->priv;
+	unsigned char frame[] = {0xa5, 0x01, 0x00, 0x00};
+	unsigned char *buf;
+
+	buf = kunit_kzalloc(test, sizeof(frame), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, buf);
+
+	KUNIT_ASSERT_EQ(test, touch_kunit_bus_queue_frame(ctx->bus, frame,
+			sizeof(frame)), 0);
+
+	KUNIT_EXPECT_EQ(test, syna_spi_read_direct(&ctx->hw_if, buf,
+			sizeof(frame)), (int)sizeof(frame));
+	KUNIT_EXPECT_EQ(test, memcmp(buf, frame, sizeof(frame)), 0);
+	KUNIT_EXPECT_EQ(test, ctx->tcm->bus_bytes_copied, 0ULL);
+}
+
+static void syna_spi_test_write(struct kunit *test)
+{
+	struct syna_spi_test_ctx *ctx = test->priv;
+	unsigned char cmd[] = {0x0e, 0x02, 0x00, 0x3c, 0x00};
+
+	KUNIT_EXPECT_EQ(test, syna_spi_write(&ctx->hw_if, cmd, sizeof(cmd)),
+			(int)sizeof(cmd));
+
+	KUNIT_ASSERT_EQ(test, ctx->bus->write_len, (unsigned int)sizeof(cmd));
+	KUNIT_EXPECT_EQ(test, memcmp(ctx->bus->write_log, cmd, sizeof(cmd)), 0);
+	KUNIT_ASSERT_EQ(test, ctx->bus->xfer_count, 1U);
+	KUNIT_EXPECT_FALSE(test, ctx->bus->xfers[0].rx);
+}
+
+static void syna_spi_test_invalid_length(struct kunit *test)
+{
+	struct syna_spi_test_ctx *ctx = test->priv;
+	unsigned char buf[4];
+
+	KUNIT_EXPECT_EQ(test, syna_spi_read(&ctx->hw_if, buf, 0xffff),
+			-EINVAL);
+	KUNIT_EXPECT_EQ(test, syna_spi_write(&ctx->hw_if, buf, 0xffff),
+			-EINVAL);
+	KUNIT_EXPECT_EQ(test, ctx->bus->msg_count, 0U);
+}
+
+static void syna_spi_test_byte_delay_write(struct kunit *test)
+{
+	struct syna_spi_test_ctx *ctx = test->priv;
+	struct syna_hw_bus_data *bus = &ctx->hw_if.bdata_io;
+	unsigned char cmd[10] = {0x0e, 0x08, 0x00, 0x01, 0x02,
+				 0x03, 0x04, 0x05, 0x06, 0x07};
+	unsigned int len[] = {4, 4, 2};
+	unsigned int delay[] = {5, 5, 100};
+	unsigned int idx;
+
+	bus->spi_byte_delay_us = 5;
+	bus->spi_block_delay_us = 100;
+	bus->spi_byte_delay_chunk = 4;
+
+	KUNIT_EXPECT_EQ(test, syna_spi_write(&ctx->hw_if, cmd, sizeof(cmd)),
+			(int)sizeof(cmd));
+
+	/* chunks of spi_byte_delay_chunk, block delay after the last one */
+	KUNIT_EXPECT_EQ(test, ctx->bus->msg_count, 1U);
+	KUNIT_ASSERT_EQ(test, ctx->bus->xfer_count, 3U);
+	for (idx = 0; idx < ARRAY_SIZE(len); idx++) {
+		KUNIT_EXPECT_EQ(test, ctx->bus->xfers[idx].len, len[idx]);
+		KUNIT_EXPECT_EQ(test, ctx->bus->xfers[idx].delay_us,
+				delay[idx]);
+		KUNIT_EXPECT_FALSE(test, ctx->bus->xfers[idx].cs_change);
+	}
+	KUNIT_ASSERT_EQ(test, ctx->bus->write_len, (unsigned int)sizeof(cmd));
+	KUNIT_EXPECT_EQ(test, memcmp(ctx->bus->write_log, cmd, sizeof(cmd)), 0);
+}
+
+static void syna_spi_test_byte_delay_read(struct kunit *test)
+{
+	struct syna_spi_test_ctx *ctx = test->priv;
+	struct syna_hw_bus_data *bus = &ctx->hw_if.bdata_io;
+	unsigned char frame[] = {0xa5, 0x11, 0x03, 0x00, 0x01, 0x02, 0x03};
+	unsigned char buf[sizeof(frame)] = {0};
+	unsigned int idx;
+
+	bus->spi_byte_delay_us = 5;
+
+	KUNIT_ASSERT_EQ(test, touch_kunit_bus_queue_frame(ctx->bus, frame,
+			sizeof(frame)), 0);
+
+	KUNIT_EXPECT_EQ(test, syna_spi_read(&ctx->hw_if, buf, sizeof(buf)),
+			(int)sizeof(buf));
+	KUNIT_EXPECT_EQ(test, memcmp(buf, frame, sizeof(frame)), 0);
+
+	/* the default chunk of 1 keeps the per-byte fallback */
+	KUNIT_EXPECT_EQ(test, ctx->bus->msg_count, 1U);
+	KUNIT_ASSERT_EQ(test, ctx->bus->xfer_count, (unsigned int)sizeof(buf));
+	for (idx = 0; idx < sizeof(buf); idx++) {
+		KUNIT_EXPECT_EQ(test, ctx->bus->xfers[idx].len, 1U);
+		KUNIT_EXPECT_EQ(test, ctx->bus->xfers[idx].delay_us, 5U);
+		KUNIT_EXPECT_TRUE(test, ctx->bus->xfers[idx].rx);
+		KUNIT_EXPECT_FALSE(test, ctx->bus->xfers[idx].cs_change);
+	}
+}
+
+#ifdef SPI_NO_DELAY_USEC
+static void syna_spi_test_word_delay(struct kunit *test)
+{
+	struct syna_spi_test_ctx *ctx = test->priv;
+	struct syna_hw_bus_data *bus = &ctx->hw_if.bdata_io;
+	unsigned char frame[] = {0xa5, 0x11, 0x03, 0x00, 0x01, 0x02, 0x03};
+	unsigned char buf[sizeof(frame)] = {0};
+
+	bus->spi_byte_delay_us = 5;
+	bus->spi_block_delay_us = 100;
+	bus->spi_word_delay = true;
+
+	KUNIT_ASSERT_EQ(test, touch_kunit_bus_queue_frame(ctx->bus, frame,
+			sizeof(frame)), 0);
+
+	KUNIT_EXPECT_EQ(test, syna_spi_read(&ctx->hw_if, buf, sizeof(buf)),
+			(int)sizeof(buf));
+	KUNIT_EXPECT_EQ(test, memcmp(buf, frame, sizeof(frame)), 0);
+
+	/* one transfer, the controller spaces the bytes */
+	KUNIT_ASSERT_EQ(test, ctx->bus->xfer_count, 1U);
+	KUNIT_EXPECT_EQ(test, ctx->bus->xfers[0].len, (unsigned int)sizeof(buf));
+	KUNIT_EXPECT_EQ(test, ctx->bus->xfers[0].word_delay_us, 5U);
+	KUNIT_EXPECT_EQ(test, ctx->bus->xfers[0].delay_us, 100U);
+}
+#endif
+
+static struct kunit_case syna_spi_test_cases[] = {
+	KUNIT_CASE(syna_spi_test_read_frame),
+	KUNIT_CASE(syna_spi_test_read_direct),
+	KUNIT_CASE(syna_spi_test_write),
+	KUNIT_CASE(syna_spi_test_invalid_length),
+	KUNIT_CASE(syna_spi_test_byte_delay_write),
+	KUNIT_CASE(syna_spi_test_byte_delay_read),
+#ifdef SPI_NO_DELAY_USEC
+	KUNIT_CASE(syna_spi_test_word_delay),
+#endif
+	{}
+};
+
+static struct kunit_suite syna_spi_test_suite = {
+	.name = "syna_tcm2_spi",
+	.init = syna_spi_test_init,
+	.exit = syna_spi_test_exit,
+	.test_cases = syna_spi_test_cases,
+};
+
+kunit_test_suite(syna_spi_test_suite);
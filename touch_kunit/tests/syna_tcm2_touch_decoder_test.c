@@ -0,0 +1,351 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the compiled TouchComm touch report decoder.
+ *
+ * Built into synaptics_touchcom_func_touch.c. Each config is fetched
+ * through syna_tcm_preserve_touch_report_config(), as on a real device,
+ * and every report is parsed twice, once by the compiled table and once
+ * by the generic parser, which must agree.
+ */
+
+#include <kunit/test.h>
+#include <linux/prandom.h>
+
+#include "../touch_kunit.h"
+
+#define SYNA_DECODER_TEST_OBJECTS	MAX_NUM_OBJECTS
+#define SYNA_DECODER_TEST_ROUNDS	200
+
+struct syna_decoder_test_vector {
+	const char *name;
+	const unsigned char *config;
+	unsigned int config_size;
+	/* report size with every object present */
+	unsigned int report_size;
+	bool compiled;
+	/* byte holding the number of active objects, or -1 */
+	int active_objects_byte;
+};
+
+struct syna_decoder_test_ctx {
+	struct syna_hw_interface *hw_if;
+	struct tcm_dev *tcm_dev;
+	const struct syna_decoder_test_vector *vector;
+	struct tcm_touch_data_blob *compiled;
+	struct tcm_touch_data_blob *generic;
+};
+
+/* byte-aligned fields, every object reported */
+static const unsigned char syna_decoder_test_aligned[] = {
+	TOUCH_REPORT_TIMESTAMP, 32,
+	TOUCH_REPORT_FOREACH_OBJECT,
+	TOUCH_REPORT_OBJECT_N_CLASSIFICATION, 8,
+	TOUCH_REPORT_OBJECT_N_X_POSITION, 16,
+	TOUCH_REPORT_OBJECT_N_Y_POSITION, 16,
+	TOUCH_REPORT_OBJECT_N_Z, 8,
+	TOUCH_REPORT_OBJECT_N_X_WIDTH, 8,
+	TOUCH_REPORT_OBJECT_N_Y_WIDTH, 8,
+	TOUCH_REPORT_FOREACH_END,
+	TOUCH_REPORT_FRAME_RATE, 8,
+	TOUCH_REPORT_END,
+};
+
+/* packed fields of the active objects, each padded to a byte */
+static const unsigned char syna_decoder_test_active[] = {
+	TOUCH_REPORT_NUM_OF_ACTIVE_OBJECTS, 8,
+	TOUCH_REPORT_FOREACH_ACTIVE_OBJECT,
+	TOUCH_REPORT_OBJECT_N_CLASSIFICATION, 4,
+	TOUCH_REPORT_OBJECT_N_X_POSITION, 12,
+	TOUCH_REPORT_OBJECT_N_Y_POSITION, 12,
+	TOUCH_REPORT_OBJECT_N_Z, 8,
+	TOUCH_REPORT_OBJECT_N_X_WIDTH, 6,
+	TOUCH_REPORT_OBJECT_N_Y_WIDTH, 6,
+	TOUCH_REPORT_PAD_TO_NEXT_BYTE,
+	TOUCH_REPORT_FOREACH_END,
+	TOUCH_REPORT_TIMESTAMP, 32,
+	TOUCH_REPORT_END,
+};
+
+/* nothing byte-aligned past the first field */
+static const unsigned char syna_decoder_test_unaligned[] = {
+	TOUCH_REPORT_0D_BUTTONS_STATE, 3,
+	TOUCH_REPORT_FOREACH_OBJECT,
+	TOUCH_REPORT_OBJECT_N_CLASSIFICATION, 3,
+	TOUCH_REPORT_OBJECT_N_X_POSITION, 13,
+	TOUCH_REPORT_OBJECT_N_Y_POSITION, 13,
+	TOUCH_REPORT_OBJECT_N_Z, 7,
+	TOUCH_REPORT_FOREACH_END,
+	TOUCH_REPORT_NSM_STATE, 5,
+	TOUCH_REPORT_END,
+};
+
+/* padding an object which starts off a byte boundary is not compiled */
+static const unsigned char syna_decoder_test_fallback[] = {
+	TOUCH_REPORT_0D_BUTTONS_STATE, 3,
+	TOUCH_REPORT_FOREACH_OBJECT,
+	TOUCH_REPORT_OBJECT_N_X_POSITION, 12,
+	TOUCH_REPORT_PAD_TO_NEXT_BYTE,
+	TOUCH_REPORT_FOREACH_END,
+	TOUCH_REPORT_END,
+};
+
+static const struct syna_decoder_test_vector syna_decoder_test_vectors[] = {
+	{
+		.name = "aligned",
+		.config = syna_decoder_test_aligned,
+		.config_size = sizeof(syna_decoder_test_aligned),
+		.report_size = 4 + 8 * SYNA_DECODER_TEST_OBJECTS + 1,
+		.compiled = true,
+		.active_objects_byte = -1,
+	},
+	{
+		.name = "active",
+		.config = syna_decoder_test_active,
+		.config_size = sizeof(syna_decoder_test_active),
+		.report_size = 1 + 6 * SYNA_DECODER_TEST_OBJECTS + 4,
+		.compiled = true,
+		.active_objects_byte = 0,
+	},
+	{
+		.name = "unaligned",
+		.config = syna_decoder_test_unaligned,
+		.config_size = sizeof(syna_decoder_test_unaligned),
+		.report_size = (3 + 36 * SYNA_DECODER_TEST_OBJECTS + 5 + 7) / 8,
+		.compiled = true,
+		.active_objects_byte = -1,
+	},
+	{
+		.name = "fallback",
+		.config = syna_decoder_test_fallback,
+		.config_size = sizeof(syna_decoder_test_fallback),
+		.report_size = 3 * SYNA_DECODER_TEST_OBJECTS,
+		.compiled = false,
+		.active_objects_byte = -1,
+	},
+};
+
+/* the config being served to syna_tcm_preserve_touch_report_config() */
+static const struct syna_decoder_test_vector *syna_decoder_test_current;
+
+static int syna_decoder_test_write_message(struct tcm_dev *tcm_dev,
+		unsigned char command, unsigned char *payload,
+		unsigned int length_total, unsigned int length,
+		unsigned char *resp_code, unsigned int delay_ms_resp)
+{
+	const struct syna_decoder_test_vector *vector =
+		syna_decoder_test_current;
+	int retval;
+
+	if (command != CMD_GET_TOUCH_REPORT_CONFIG || !vector)
+		return -ERR_INVAL;
+
+	retval = syna_tcm_buf_alloc(&tcm_dev->resp_buf, vector->config_size);
+	if (retval < 0)
+		return retval;
+
+	memcpy(tcm_dev->resp_buf.buf, vector->config, vector->config_size);
+	tcm_dev->resp_buf.data_length = vector->config_size;
+	*resp_code = STATUS_OK;
+
+	return 0;
+}
+
+/* the bus is never touched, the config comes from write_message */
+static int syna_decoder_test_no_io(struct syna_hw_interface *hw_if,
+		unsigned char *data, unsigned int len)
+{
+	return -EIO;
+}
+
+static int syna_decoder_test_init(struct kunit *test)
+{
+	struct syna_decoder_test_ctx *ctx;
+	struct tcm_dev *tcm_dev;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	test->priv = ctx;
+
+	ctx->compiled = kunit_kzalloc(test, sizeof(*ctx->compiled), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx->compiled);
+	ctx->generic = kunit_kzalloc(test, sizeof(*ctx->generic), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx->generic);
+
+	ctx->hw_if = kunit_kzalloc(test, sizeof(*ctx->hw_if), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx->hw_if);
+	ctx->hw_if->ops_read_data = syna_decoder_test_no_io;
+	ctx->hw_if->ops_write_data = syna_decoder_test_no_io;
+
+	KUNIT_ASSERT_EQ(test, syna_tcm_allocate_device(&ctx->tcm_dev,
+			ctx->hw_if, RESP_IN_ATTN), 0);
+
+	tcm_dev = ctx->tcm_dev;
+	tcm_dev->write_message = syna_decoder_test_write_message;
+	tcm_dev->dev_mode = MODE_APPLICATION_FIRMWARE;
+	tcm_dev->max_objects = SYNA_DECODER_TEST_OBJECTS;
+
+	return 0;
+}
+
+static void syna_decoder_test_exit(struct kunit *test)
+{
+	struct syna_decoder_test_ctx *ctx = test->priv;
+
+	syna_decoder_test_current = NULL;
+
+	if (ctx && ctx->tcm_dev)
+		syna_tcm_remove_device(ctx->tcm_dev);
+}
+
+static void syna_decoder_test_load(struct kunit *test,
+		const struct syna_decoder_test_vector *vector)
+{
+	struct syna_decoder_test_ctx *ctx = test->priv;
+
+	ctx->vector = vector;
+	syna_decoder_test_current = vector;
+
+	KUNIT_ASSERT_EQ(test,
+		syna_tcm_preserve_touch_report_config(ctx->tcm_dev), 0);
+	KUNIT_ASSERT_EQ_MSG(test, ctx->tcm_dev->touch_decoder.compiled,
+			vector->compiled, "config %s", vector->name);
+}
+
+/* parse by the compiled table, then by the generic parser */
+static void syna_decoder_test_compare(struct kunit *test,
+		unsigned char *report, unsigned int report_size)
+{
+	struct syna_decoder_test_ctx *ctx = test->priv;
+	struct tcm_dev *tcm_dev = ctx->tcm_dev;
+	bool compiled = tcm_dev->touch_decoder.compiled;
+	int ret_compiled, ret_generic;
+
+	memset(ctx->compiled, 0, sizeof(*ctx->compiled));
+	memset(ctx->generic, 0, sizeof(*ctx->generic));
+
+	ret_compiled = syna_tcm_parse_touch_report(tcm_dev, report,
+			report_size, ctx->compiled);
+
+	tcm_dev->touch_decoder.compiled = false;
+	ret_generic = syna_tcm_parse_touch_report(tcm_dev, report,
+			report_size, ctx->generic);
+	tcm_dev->touch_decoder.compiled = compiled;
+
+	KUNIT_EXPECT_EQ_MSG(test, ret_compiled, ret_generic,
+			"config %s", ctx->vector->name);
+	KUNIT_EXPECT_EQ_MSG(test, memcmp(ctx->compiled, ctx->generic,
+			sizeof(*ctx->compiled)), 0,
+			"config %s, report %*ph", ctx->vector->name,
+			min_t(int, report_size, 64), report);
+}
+
+static void syna_decoder_test_vectors_match(struct kunit *test)
+{
+	const struct syna_decoder_test_vector *vector;
+	struct rnd_state rnd;
+	unsigned char *report;
+	unsigned int i, n;
+
+	prandom_seed_state(&rnd, 0x5a5a0d1e);
+
+	for (i = 0; i < ARRAY_SIZE(syna_decoder_test_vectors); i++) {
+		vector = &syna_decoder_test_vectors[i];
+		syna_decoder_test_load(test, vector);
+
+		report = kunit_kzalloc(test, vector->report_size, GFP_KERNEL);
+		KUNIT_ASSERT_NOT_NULL(test, report);
+
+		/* an all-zero report, then random ones */
+		syna_decoder_test_compare(test, report, vector->report_size);
+
+		for (n = 0; n < SYNA_DECODER_TEST_ROUNDS; n++) {
+			prandom_bytes_state(&rnd, report, vector->report_size);
+			if (vector->active_objects_byte >= 0)
+				report[vector->active_objects_byte] =
+					prandom_u32_state(&rnd) %
+					(SYNA_DECODER_TEST_OBJECTS + 1);
+
+			syna_decoder_test_compare(test, report,
+					vector->report_size);
+		}
+	}
+}
+
+static void syna_decoder_test_aligned_values(struct kunit *test)
+{
+	struct syna_decoder_test_ctx *ctx = test->priv;
+	struct tcm_objects_data_blob *obj;
+	unsigned char *report;
+	unsigned int size = syna_decoder_test_vectors[0].report_size;
+
+	syna_decoder_test_load(test, &syna_decoder_test_vectors[0]);
+
+	report = kunit_kzalloc(test, size, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, report);
+
+	/* timestamp, then object 1 is a finger at (0x123, 0x456) */
+	report[0] = 0x78;
+	report[1] = 0x56;
+	report[2] = 0x34;
+	report[3] = 0x12;
+	report[4 + 8] = FINGER;
+	report[4 + 8 + 1] = 0x23;
+	report[4 + 8 + 2] = 0x01;
+	report[4 + 8 + 3] = 0x56;
+	report[4 + 8 + 4] = 0x04;
+	report[4 + 8 + 5] = 0x30;
+	report[size - 1] = 120;
+
+	KUNIT_ASSERT_GE(test, syna_tcm_parse_touch_report(ctx->tcm_dev,
+			report, size, ctx->compiled), 0);
+
+	obj = &ctx->compiled->object_data[1];
+	KUNIT_EXPECT_EQ(test, ctx->compiled->timestamp, 0x12345678U);
+	KUNIT_EXPECT_EQ(test, obj->status, (unsigned char)FINGER);
+	KUNIT_EXPECT_EQ(test, obj->x_pos, 0x123U);
+	KUNIT_EXPECT_EQ(test, obj->y_pos, 0x456U);
+	KUNIT_EXPECT_EQ(test, obj->z, 0x30U);
+	KUNIT_EXPECT_EQ(test, ctx->compiled->object_data[0].status,
+			(unsigned char)0);
+	KUNIT_EXPECT_EQ(test, ctx->compiled->frame_rate, 120U);
+}
+
+static void syna_decoder_test_no_active_objects(struct kunit *test)
+{
+	struct syna_decoder_test_ctx *ctx = test->priv;
+	unsigned char *report;
+	unsigned int size = syna_decoder_test_vectors[1].report_size;
+
+	syna_decoder_test_load(test, &syna_decoder_test_vectors[1]);
+
+	report = kunit_kzalloc(test, size, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, report);
+
+	/* no object, the timestamp follows the count directly */
+	report[0] = 0;
+	report[1] = 0xef;
+	report[2] = 0xbe;
+	report[3] = 0xad;
+	report[4] = 0xde;
+	memset(&report[5], 0xff, size - 5);
+
+	syna_decoder_test_compare(test, report, size);
+	KUNIT_EXPECT_EQ(test, ctx->compiled->num_of_active_objects, 0U);
+	KUNIT_EXPECT_EQ(test, ctx->compiled->timestamp, 0xdeadbeefU);
+}
+
+static struct kunit_case syna_decoder_test_cases[] = {
+	KUNIT_CASE(syna_decoder_test_vectors_match),
+	KUNIT_CASE(syna_decoder_test_aligned_values),
+	KUNIT_CASE(syna_decoder_test_no_active_objects),
+	{}
+};
+
+static struct kunit_suite syna_decoder_test_suite = {
+	.name = "syna_tcm2_touch_decoder",
+	.init = syna_decoder_test_init,
+	.exit = syna_decoder_test_exit,
+	.test_cases = syna_decoder_test_cases,
+};
+
+kunit_test_suite(syna_decoder_test_suite);
@@ -0,0 +1,387 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the MultiFunction command queue.
+ *
+ * Built into syna_xiaomi_driver.c. The same command sequence is sent once
+ * the serial way, one transaction per command, and once through the
+ * queue. A model of the IC replays what reached the mock spi controller
+ * and both runs must leave it in the same state.
+ */
+
+#include <kunit/test.h>
+
+#include "../touch_kunit.h"
+
+#ifdef TOUCH_THP_SUPPORT
+
+/* TouchComm v1 response framing, private to synaptics_touchcom_core_v1.c */
+#define SYNA_MF_TEST_MARKER 0xa5
+/* raw packet written without response, see syna_tcm_set_cmd_noresponse */
+#define SYNA_MF_TEST_RAW 0xC8
+
+/* register banks of the IC model */
+enum syna_mf_test_bank {
+	SYNA_MF_BANK_MF = 0,
+	/* ENTER_IDLE_MODE threshold variant, fills other fields than 0x43 */
+	SYNA_MF_BANK_IDLE_THRESHOLD,
+	SYNA_MF_BANK_RAW,
+	SYNA_MF_BANK_MAX,
+};
+
+struct syna_mf_test_ic {
+	bool set[SYNA_MF_BANK_MAX][256];
+	unsigned char reg[SYNA_MF_BANK_MAX][256][SYNA_MF_CMD_MAX_SIZE];
+};
+
+struct syna_mf_test_cmd {
+	bool no_resp;
+	unsigned char size;
+	unsigned char data[SYNA_MF_CMD_MAX_SIZE];
+};
+
+/* what syna_set_ic_mode() sends on a game mode switch, with overrides */
+static const struct syna_mf_test_cmd syna_mf_test_seq[] = {
+	/* report rate 120 */
+	{ false, 3, { 0x07, 120, 0x00 } },
+	/* idle enable */
+	{ false, 11, { 0x43, 0x01, 0x00, 25, 0x00, 0x00, 0x00, 0x47, 0x10 } },
+	/* doze wakeup threshold */
+	{ false, 3, { 0x39, 5, 0x00 } },
+	/* report rate 240, replaces the 120 */
+	{ false, 3, { 0x07, 240, 0x00 } },
+	/* idle threshold, must not replace the idle enable */
+	{ false, 11, { 0x43, 0x00, 0x01, 0x00, 0x00, 0x20, 0x00,
+			0x00, 0x00, 0x64, 0x00 } },
+	/* thp base on */
+	{ true, 6, { SYNA_MF_TEST_RAW, 0x03, 0x00, 0x3A, 0x04, 0x00 } },
+	/* glove thresholds */
+	{ true, 10, { SYNA_MF_TEST_RAW, 0x07, 0x00, 0x5c,
+			0x01, 0x00, 0x02, 0x00, 0x03, 0x00 } },
+	/* thp base off, replaces the on */
+	{ true, 6, { SYNA_MF_TEST_RAW, 0x03, 0x00, 0x3A, 0x03, 0x00 } },
+	/* update idle baseline */
+	{ false, 3, { 0x30, 0x01, 0x00 } },
+	/* doze wakeup threshold, replaces the 5 */
+	{ false, 3, { 0x39, 7, 0x00 } },
+};
+
+struct syna_mf_test_ctx {
+	struct touch_kunit_bus *bus;
+	struct touch_kunit_irq line;
+	struct work_struct attn_work;
+	struct syna_hw_interface hw_if;
+	struct syna_tcm *tcm;
+	bool queue_ready;
+};
+
+static int syna_mf_test_read(struct syna_hw_interface *hw_if,
+		unsigned char *rd_data, unsigned int rd_len)
+{
+	int retval;
+
+	retval = spi_read(hw_if->pdev, rd_data, rd_len);
+
+	return (retval < 0) ? retval : rd_len;
+}
+
+/* the IC answers every command but the raw packets with STATUS_OK */
+static int syna_mf_test_write(struct syna_hw_interface *hw_if,
+		unsigned char *wr_data, unsigned int wr_len)
+{
+	struct syna_mf_test_ctx *ctx =
+			container_of(hw_if, struct syna_mf_test_ctx, hw_if);
+	unsigned char resp[] = {
+		SYNA_MF_TEST_MARKER, STATUS_OK, 0x00, 0x00,
+	};
+	int retval;
+
+	retval = spi_write(hw_if->pdev, wr_data, wr_len);
+	if (retval < 0)
+		return retval;
+
+	if (wr_data[0] != SYNA_MF_TEST_RAW) {
+		retval = touch_kunit_bus_queue_frame(ctx->bus, resp,
+				sizeof(resp));
+		if (retval < 0)
+			return retval;
+		schedule_work(&ctx->attn_work);
+	}
+
+	return wr_len;
+}
+
+static irqreturn_t syna_mf_test_attn_thread(int irq, void *data)
+{
+	struct syna_tcm *tcm_hcd = data;
+	unsigned char code;
+
+	syna_tcm_get_event_data(tcm_hcd->tcm_dev, &code, NULL);
+
+	return IRQ_HANDLED;
+}
+
+static void syna_mf_test_attn_work(struct work_struct *work)
+{
+	struct syna_mf_test_ctx *ctx =
+			container_of(work, struct syna_mf_test_ctx, attn_work);
+
+	touch_kunit_irq_fire(&ctx->line);
+}
+
+/* replay the bytes written to the bus into the IC model */
+static int syna_mf_test_ic_replay(struct syna_mf_test_ic *ic,
+		const unsigned char *log, unsigned int len,
+		unsigned int *commands)
+{
+	const unsigned char *payload;
+	unsigned int offset = 0;
+	unsigned int plen;
+	unsigned int size;
+	unsigned int i;
+	int bank;
+
+	*commands = 0;
+
+	while (offset < len) {
+		if (offset + 3 > len)
+			return -EINVAL;
+
+		plen = log[offset + 1] | (log[offset + 2] << 8);
+		payload = &log[offset + 3];
+		if (offset + 3 + plen > len)
+			return -EINVAL;
+
+		if (log[offset] == CMD_MultiFunction) {
+			for (i = 0; i < plen; i += size) {
+				size = (payload[i] == 0x43) ? 11 : 3;
+				if (i + size > plen)
+					return -EINVAL;
+
+				bank = SYNA_MF_BANK_MF;
+				if (payload[i] == 0x43 && payload[i + 2])
+					bank = SYNA_MF_BANK_IDLE_THRESHOLD;
+				memcpy(ic->reg[bank][payload[i]], &payload[i], size);
+				ic->set[bank][payload[i]] = true;
+			}
+		} else if (log[offset] == SYNA_MF_TEST_RAW) {
+			if (plen == 0 || plen + 3 > SYNA_MF_CMD_MAX_SIZE)
+				return -EINVAL;
+
+			memcpy(ic->reg[SYNA_MF_BANK_RAW][payload[0]],
+					&log[offset], plen + 3);
+			ic->set[SYNA_MF_BANK_RAW][payload[0]] = true;
+		} else {
+			return -EINVAL;
+		}
+
+		(*commands)++;
+		offset += 3 + plen;
+	}
+
+	return 0;
+}
+
+static int syna_mf_test_init(struct kunit *test)
+{
+	struct syna_mf_test_ctx *ctx;
+	struct syna_tcm *tcm_hcd;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	test->priv = ctx;
+
+	INIT_WORK(&ctx->attn_work, syna_mf_test_attn_work);
+
+	ctx->bus = touch_kunit_spi_bus_create();
+	KUNIT_ASSERT_NOT_NULL(test, ctx->bus);
+
+	ctx->hw_if.pdev = ctx->bus->spi;
+	ctx->hw_if.ops_read_data = syna_mf_test_read;
+	ctx->hw_if.ops_write_data = syna_mf_test_write;
+	ctx->hw_if.bdata_attn.irq_gpio = -1;
+
+	tcm_hcd = kunit_kzalloc(test, sizeof(*tcm_hcd), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, tcm_hcd);
+	ctx->tcm = tcm_hcd;
+
+	tcm_hcd->hw_if = &ctx->hw_if;
+	tcm_hcd->pwr_state = PWR_ON;
+	mutex_init(&tcm_hcd->mf_queue.lock);
+	mutex_init(&tcm_hcd->mf_queue.flush_lock);
+	INIT_WORK(&tcm_hcd->mf_queue.work, syna_mf_queue_work);
+	ctx->queue_ready = true;
+
+	KUNIT_ASSERT_EQ(test, syna_tcm_allocate_device(&tcm_hcd->tcm_dev,
+			&ctx->hw_if, RESP_IN_ATTN), 0);
+	syna_tcm_v1_set_ops(tcm_hcd->tcm_dev);
+	tcm_hcd->tcm_dev->dev_mode = MODE_APPLICATION_FIRMWARE;
+
+	KUNIT_ASSERT_EQ(test, touch_kunit_irq_init(&ctx->line, NULL,
+			syna_mf_test_attn_thread, tcm_hcd), 0);
+
+	return 0;
+}
+
+static void syna_mf_test_exit(struct kunit *test)
+{
+	struct syna_mf_test_ctx *ctx = test->priv;
+
+	if (!ctx)
+		return;
+
+	if (ctx->queue_ready)
+		cancel_work_sync(&ctx->tcm->mf_queue.work);
+	cancel_work_sync(&ctx->attn_work);
+	touch_kunit_irq_release(&ctx->line);
+
+	if (ctx->tcm && ctx->tcm->tcm_dev)
+		syna_tcm_remove_device(ctx->tcm->tcm_dev);
+
+	touch_kunit_bus_destroy(ctx->bus);
+}
+
+/* one transaction per command, as before the queue */
+static void syna_mf_test_run_serial(struct kunit *test)
+{
+	struct syna_mf_test_ctx *ctx = test->priv;
+	unsigned char buf[SYNA_MF_CMD_MAX_SIZE];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(syna_mf_test_seq); i++) {
+		memcpy(buf, syna_mf_test_seq[i].data, sizeof(buf));
+		if (syna_mf_test_seq[i].no_resp)
+			KUNIT_ASSERT_GE(test, syna_tcm_set_cmd_noresponse(
+					ctx->tcm->tcm_dev, buf,
+					syna_mf_test_seq[i].size), 0);
+		else
+			KUNIT_ASSERT_GE(test, syna_tcm_set_touch_multi_function(
+					ctx->tcm->tcm_dev, buf,
+					syna_mf_test_seq[i].size), 0);
+	}
+}
+
+/* the whole sequence lands in the queue before the work gets to it */
+static void syna_mf_test_run_queued(struct kunit *test)
+{
+	struct syna_mf_test_ctx *ctx = test->priv;
+	struct syna_mf_queue *queue = &ctx->tcm->mf_queue;
+	unsigned char buf[SYNA_MF_CMD_MAX_SIZE];
+	int i;
+
+	mutex_lock(&queue->flush_lock);
+	for (i = 0; i < ARRAY_SIZE(syna_mf_test_seq); i++) {
+		memcpy(buf, syna_mf_test_seq[i].data, sizeof(buf));
+		syna_mf_queue_submit(ctx->tcm, buf, syna_mf_test_seq[i].size,
+				syna_mf_test_seq[i].no_resp);
+	}
+	mutex_unlock(&queue->flush_lock);
+
+	flush_work(&queue->work);
+}
+
+static void syna_mf_test_same_state(struct kunit *test)
+{
+	struct syna_mf_test_ctx *ctx = test->priv;
+	struct syna_mf_queue *queue = &ctx->tcm->mf_queue;
+	struct syna_mf_test_ic *serial, *queued;
+	unsigned int serial_cmds, queued_cmds;
+
+	serial = kunit_kzalloc(test, sizeof(*serial), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, serial);
+	queued = kunit_kzalloc(test, sizeof(*queued), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, queued);
+
+	syna_mf_test_run_serial(test);
+	KUNIT_ASSERT_EQ(test, syna_mf_test_ic_replay(serial,
+			ctx->bus->write_log, ctx->bus->write_len,
+			&serial_cmds), 0);
+	KUNIT_EXPECT_EQ(test, serial_cmds,
+			(unsigned int)ARRAY_SIZE(syna_mf_test_seq));
+
+	touch_kunit_bus_reset_log(ctx->bus);
+
+	syna_mf_test_run_queued(test);
+	KUNIT_ASSERT_EQ(test, syna_mf_test_ic_replay(queued,
+			ctx->bus->write_log, ctx->bus->write_len,
+			&queued_cmds), 0);
+
+	/* the IC ends up where the serial path left it */
+	KUNIT_EXPECT_EQ(test, memcmp(serial, queued, sizeof(*serial)), 0);
+	KUNIT_EXPECT_TRUE(test, queued->set[SYNA_MF_BANK_MF][0x43]);
+	KUNIT_EXPECT_TRUE(test, queued->set[SYNA_MF_BANK_IDLE_THRESHOLD][0x43]);
+	KUNIT_EXPECT_EQ(test, queued->reg[SYNA_MF_BANK_MF][0x07][1],
+			(unsigned char)240);
+	KUNIT_EXPECT_EQ(test, queued->reg[SYNA_MF_BANK_RAW][0x3A][4],
+			(unsigned char)0x03);
+
+	/* in fewer transactions: 0x07 0x43 0x39 0x43 packed, two raw, 0x30 */
+	KUNIT_EXPECT_EQ(test, queue->submitted,
+			(unsigned long long)ARRAY_SIZE(syna_mf_test_seq));
+	KUNIT_EXPECT_EQ(test, queue->merged, 3ULL);
+	KUNIT_EXPECT_EQ(test, queue->transactions, 4ULL);
+	KUNIT_EXPECT_EQ(test, queued_cmds, 4U);
+}
+
+static void syna_mf_test_power_off(struct kunit *test)
+{
+	struct syna_mf_test_ctx *ctx = test->priv;
+
+	ctx->tcm->pwr_state = LOW_PWR;
+	syna_mf_test_run_queued(test);
+
+	/* nothing reaches a suspended IC, nothing is left for the resume */
+	KUNIT_EXPECT_EQ(test, ctx->bus->write_len, 0U);
+	KUNIT_EXPECT_EQ(test, ctx->tcm->mf_queue.transactions, 0ULL);
+	KUNIT_EXPECT_FALSE(test, ctx->tcm->mf_queue.cmd[0].pending);
+}
+
+static void syna_mf_test_direct_after_queued(struct kunit *test)
+{
+	struct syna_mf_test_ctx *ctx = test->priv;
+	struct syna_mf_queue *queue = &ctx->tcm->mf_queue;
+	struct syna_mf_test_ic *ic;
+	unsigned char queued[] = { 0x07, 120, 0x00 };
+	unsigned char direct[] = { 0x07, 240, 0x00 };
+	unsigned int cmds;
+
+	ic = kunit_kzalloc(test, sizeof(*ic), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ic);
+
+	mutex_lock(&queue->flush_lock);
+	syna_mf_queue_submit(ctx->tcm, queued, sizeof(queued), false);
+	mutex_unlock(&queue->flush_lock);
+
+	/* a direct write after it, as syna_htc_ic_setModeValue() does */
+	syna_mf_queue_hold(ctx->tcm);
+	KUNIT_EXPECT_GE(test, syna_tcm_set_touch_multi_function(
+			ctx->tcm->tcm_dev, direct, sizeof(direct)), 0);
+	syna_mf_queue_release(ctx->tcm);
+	flush_work(&queue->work);
+
+	/* the older queued write reached the IC first */
+	KUNIT_ASSERT_EQ(test, syna_mf_test_ic_replay(ic, ctx->bus->write_log,
+			ctx->bus->write_len, &cmds), 0);
+	KUNIT_EXPECT_EQ(test, cmds, 2U);
+	KUNIT_EXPECT_EQ(test, ctx->bus->write_log[3], (unsigned char)0x07);
+	KUNIT_EXPECT_EQ(test, ctx->bus->write_log[4], (unsigned char)120);
+	KUNIT_EXPECT_EQ(test, ic->reg[SYNA_MF_BANK_MF][0x07][1],
+			(unsigned char)240);
+}
+
+static struct kunit_case syna_mf_test_cases[] = {
+	KUNIT_CASE(syna_mf_test_same_state),
+	KUNIT_CASE(syna_mf_test_power_off),
+	KUNIT_CASE(syna_mf_test_direct_after_queued),
+	{}
+};
+
+static struct kunit_suite syna_mf_test_suite = {
+	.name = "syna_tcm2_mf_queue",
+	.init = syna_mf_test_init,
+	.exit = syna_mf_test_exit,
+	.test_cases = syna_mf_test_cases,
+};
+
+kunit_test_suite(syna_mf_test_suite);
+
+#endif /* TOUCH_THP_SUPPORT */
@@ -0,0 +1,243 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * KUnit tests for the seqcount header of the xiaomi frame data ring.
+ *
+ * Built into xiaomi_touch_core.c. The frame data area and its header
+ * page are set up as register_touch_panel() would, and the readers
+ * follow the protocol documented for the HAL in xiaomi_touch_type_common.h.
+ */
+
+#include <kunit/test.h>
+#include <linux/kthread.h>
+
+#include "../touch_kunit.h"
+
+#define XIAOMI_RING_TEST_SLOTS		4
+#define XIAOMI_RING_TEST_SLOT_SIZE	256
+#define XIAOMI_RING_TEST_FRAMES		20000
+
+struct xiaomi_ring_test_ctx {
+	xiaomi_touch_data_t *data;
+	data_ring_header_t *ring;
+	struct completion writer_done;
+};
+
+static int xiaomi_ring_test_init(struct kunit *test)
+{
+	struct xiaomi_ring_test_ctx *ctx;
+	xiaomi_touch_data_t *data;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, ctx);
+	test->priv = ctx;
+
+	data = kunit_kzalloc(test, sizeof(*data), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, data);
+	ctx->data = data;
+
+	data->frame_data_size = XIAOMI_RING_TEST_SLOT_SIZE;
+	data->frame_data_buf_size = XIAOMI_RING_TEST_SLOTS;
+	atomic_set(&data->frame_data_buf_index, 0);
+	data->frame_data_mmap_base = kunit_kzalloc(test,
+			XIAOMI_RING_TEST_SLOTS * XIAOMI_RING_TEST_SLOT_SIZE,
+			GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, data->frame_data_mmap_base);
+
+	data->data_ring_header = kunit_kzalloc(test, PAGE_SIZE, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, data->data_ring_header);
+	data->data_ring_header->frame_data.slot_count = XIAOMI_RING_TEST_SLOTS;
+	ctx->ring = &data->data_ring_header->frame_data;
+
+	INIT_LIST_HEAD(&data->private_data_list);
+	spin_lock_init(&data->private_data_lock);
+	init_completion(&ctx->writer_done);
+
+	return 0;
+}
+
+static void xiaomi_ring_test_getter_pure(struct kunit *test)
+{
+	struct xiaomi_ring_test_ctx *ctx = test->priv;
+
+	KUNIT_EXPECT_PTR_EQ(test, get_frame_data_slot(ctx->data),
+			ctx->data->frame_data_mmap_base);
+	KUNIT_EXPECT_PTR_EQ(test, get_frame_data_slot(ctx->data),
+			ctx->data->frame_data_mmap_base);
+
+	/* fetching the base does not start a write */
+	KUNIT_EXPECT_EQ(test, ctx->ring->slots[0].seq, 0U);
+	KUNIT_EXPECT_EQ(test, ctx->ring->frame_number, 0ULL);
+}
+
+static void xiaomi_ring_test_publish(struct kunit *test)
+{
+	struct xiaomi_ring_test_ctx *ctx = test->priv;
+	data_ring_slot_t *slot = &ctx->ring->slots[0];
+
+	KUNIT_ASSERT_NOT_NULL(test, begin_frame_data_write(ctx->data));
+	KUNIT_EXPECT_EQ(test, slot->seq & 1, 1U);
+
+	/* a second begin on the slot being written keeps it odd */
+	begin_frame_data_write(ctx->data);
+	KUNIT_EXPECT_EQ(test, slot->seq, 1U);
+
+	publish_data_ring_slot(ctx->data, FRAME_DATA_NOTIFY);
+	KUNIT_EXPECT_EQ(test, slot->seq, 2U);
+	KUNIT_EXPECT_EQ(test, slot->frame_number, 1ULL);
+	KUNIT_EXPECT_NE(test, slot->timestamp_ns, 0LL);
+	KUNIT_EXPECT_EQ(test, ctx->ring->write_index, 1U);
+	KUNIT_EXPECT_EQ(test, atomic_read(&ctx->data->frame_data_buf_index), 1);
+}
+
+static void xiaomi_ring_test_cancel(struct kunit *test)
+{
+	struct xiaomi_ring_test_ctx *ctx = test->priv;
+	data_ring_slot_t *slot = &ctx->ring->slots[0];
+
+	begin_frame_data_write(ctx->data);
+	publish_data_ring_slot(ctx->data, FRAME_DATA_NOTIFY);
+	atomic_set(&ctx->data->frame_data_buf_index, 0);
+	WRITE_ONCE(ctx->ring->write_index, 0);
+
+	/* a frame given up halfway leaves no odd slot and no stale frame */
+	begin_frame_data_write(ctx->data);
+	cancel_frame_data_write(ctx->data);
+	KUNIT_EXPECT_EQ(test, slot->seq, 4U);
+	KUNIT_EXPECT_EQ(test, slot->frame_number, 0ULL);
+	KUNIT_EXPECT_EQ(test, ctx->ring->frame_number, 1ULL);
+	KUNIT_EXPECT_EQ(test, ctx->ring->write_index, 0U);
+
+	/* cancelling without a write in progress changes nothing */
+	cancel_frame_data_write(ctx->data);
+	KUNIT_EXPECT_EQ(test, slot->seq, 4U);
+
+	/* and the next frame goes to the same slot */
+	begin_frame_data_write(ctx->data);
+	publish_data_ring_slot(ctx->data, FRAME_DATA_NOTIFY);
+	KUNIT_EXPECT_EQ(test, slot->seq, 6U);
+	KUNIT_EXPECT_EQ(test, slot->frame_number, 2ULL);
+}
+
+static void xiaomi_ring_test_overrun(struct kunit *test)
+{
+	struct xiaomi_ring_test_ctx *ctx = test->priv;
+	private_data_t *client;
+
+	client = kunit_kzalloc(test, sizeof(*client), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, client);
+	/* the client is one slot behind, the next write overwrites it */
+	atomic_set(&client->frame_data_index, 1);
+	list_add_tail_rcu(&client->node, &ctx->data->private_data_list);
+
+	begin_frame_data_write(ctx->data);
+	publish_data_ring_slot(ctx->data, FRAME_DATA_NOTIFY);
+	KUNIT_EXPECT_EQ(test, ctx->ring->overrun_count, 1U);
+
+	atomic_set(&client->frame_data_index, 0);
+	begin_frame_data_write(ctx->data);
+	publish_data_ring_slot(ctx->data, FRAME_DATA_NOTIFY);
+	KUNIT_EXPECT_EQ(test, ctx->ring->overrun_count, 1U);
+
+	list_del_rcu(&client->node);
+	synchronize_rcu();
+}
+
+/* each frame fills its slot with the low byte of its frame number */
+static int xiaomi_ring_test_writer(void *priv)
+{
+	struct xiaomi_ring_test_ctx *ctx = priv;
+	unsigned char *base;
+	int i;
+
+	for (i = 1; i <= XIAOMI_RING_TEST_FRAMES; i++) {
+		base = begin_frame_data_write(ctx->data);
+		memset(base, i & 0xff, XIAOMI_RING_TEST_SLOT_SIZE);
+		publish_data_ring_slot(ctx->data, FRAME_DATA_NOTIFY);
+		if (!(i % 64))
+			cond_resched();
+	}
+
+	complete(&ctx->writer_done);
+	return 0;
+}
+
+static void xiaomi_ring_test_concurrent(struct kunit *test)
+{
+	struct xiaomi_ring_test_ctx *ctx = test->priv;
+	data_ring_header_t *ring = ctx->ring;
+	struct task_struct *writer;
+	unsigned char *copy;
+	unsigned int good = 0, torn = 0, bad = 0;
+	u64 last = 0, frame;
+	u32 seq, idx;
+	int i;
+
+	copy = kunit_kzalloc(test, XIAOMI_RING_TEST_SLOT_SIZE, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, copy);
+
+	writer = kthread_run(xiaomi_ring_test_writer, ctx, "xiaomi_ring_test");
+	KUNIT_ASSERT_FALSE(test, IS_ERR(writer));
+
+	while (!completion_done(&ctx->writer_done)) {
+		cond_resched();
+		idx = (READ_ONCE(ring->write_index) + XIAOMI_RING_TEST_SLOTS - 1) %
+			XIAOMI_RING_TEST_SLOTS;
+		seq = smp_load_acquire(&ring->slots[idx].seq);
+		if (seq & 1)
+			continue;
+
+		frame = READ_ONCE(ring->slots[idx].frame_number);
+		memcpy(copy, ctx->data->frame_data_mmap_base +
+				idx * XIAOMI_RING_TEST_SLOT_SIZE,
+				XIAOMI_RING_TEST_SLOT_SIZE);
+		smp_rmb();
+		if (READ_ONCE(ring->slots[idx].seq) != seq) {
+			torn++;
+			continue;
+		}
+		if (!frame)
+			continue;
+
+		/* a copy passing the seq check is never torn */
+		for (i = 0; i < XIAOMI_RING_TEST_SLOT_SIZE; i++) {
+			if (copy[i] != (frame & 0xff)) {
+				bad++;
+				break;
+			}
+		}
+		/*
+		 * frame numbers move forward, a frame may show up in its slot
+		 * just before write_index moves past it
+		 */
+		if (frame + 1 < last)
+			bad++;
+		last = frame;
+		good++;
+	}
+
+	wait_for_completion(&ctx->writer_done);
+
+	kunit_info(test, "reads: %u consistent, %u torn detected\n", good, torn);
+	KUNIT_EXPECT_EQ(test, bad, 0U);
+	KUNIT_EXPECT_GT(test, good, 0U);
+	KUNIT_EXPECT_EQ(test, ring->frame_number, (u64)XIAOMI_RING_TEST_FRAMES);
+	for (i = 0; i < XIAOMI_RING_TEST_SLOTS; i++)
+		KUNIT_EXPECT_EQ(test, ring->slots[i].seq & 1, 0U);
+}
+
+static struct kunit_case xiaomi_ring_test_cases[] = {
+	KUNIT_CASE(xiaomi_ring_test_getter_pure),
+	KUNIT_CASE(xiaomi_ring_test_publish),
+	KUNIT_CASE(xiaomi_ring_test_cancel),
+	KUNIT_CASE(xiaomi_ring_test_overrun),
+	KUNIT_CASE_SLOW(xiaomi_ring_test_concurrent),
+	{}
+};
+
+static struct kunit_suite xiaomi_ring_test_suite = {
+	.name = "xiaomi_touch_ring",
+	.init = xiaomi_ring_test_init,
+	.test_cases = xiaomi_ring_test_cases,
+};
+
+kunit_test_suite(xiaomi_ring_test_suite);
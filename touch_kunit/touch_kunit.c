@@ -0,0 +1,714 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ */
+
+#include <linux/module.h>
+#include <linux/delay.h>
+#include <linux/device.h>
+#include <linux/irq.h>
+#include <linux/slab.h>
+
+#include "touch_kunit.h"
+
+MODULE_DESCRIPTION("QTI touch driver KUnit mock bus harness");
+MODULE_LICENSE("GPL v2");
+
+#define DRIVER_NAME "touch_kunit"
+
+#if (KERNEL_VERSION(5, 15, 0) <= LINUX_VERSION_CODE)
+#define TOUCH_KUNIT_SPI_DELAY
+#endif
+
+static struct device *touch_kunit_root;
+
+static struct touch_kunit_frame *touch_kunit_bus_pop_frame(
+		struct touch_kunit_bus *bus)
+{
+	struct touch_kunit_frame *frame;
+
+	if (!bus->frame_count)
+		return NULL;
+
+	frame = &bus->frames[bus->frame_head];
+	bus->frame_head = (bus->frame_head + 1) % TOUCH_KUNIT_MAX_FRAMES;
+	bus->frame_count--;
+
+	return frame;
+}
+
+static void touch_kunit_bus_log_write(struct touch_kunit_bus *bus,
+		const unsigned char *data, unsigned int len)
+{
+	unsigned int size;
+
+	if (!data)
+		return;
+
+	size = min(len, TOUCH_KUNIT_WRITE_LOG_SIZE - bus->write_len);
+	memcpy(&bus->write_log[bus->write_len], data, size);
+	bus->write_len += size;
+}
+
+static void touch_kunit_bus_log_tx(struct touch_kunit_bus *bus,
+		const unsigned char *data, unsigned int len)
+{
+	unsigned int size;
+
+	size = min(len, TOUCH_KUNIT_MAX_FRAME_SIZE - bus->tx_len);
+	memcpy(&bus->tx_log[bus->tx_len], data, size);
+	bus->tx_len += size;
+}
+
+static void touch_kunit_bus_fill_read(struct touch_kunit_bus *bus,
+		struct touch_kunit_frame *frame, unsigned int offset,
+		unsigned char *data, unsigned int len)
+{
+	unsigned int i;
+
+	for (i = 0; i < len; i++, offset++) {
+		if (frame && offset < frame->len)
+			data[i] = frame->data[offset];
+		else
+			data[i] = bus->idle_byte;
+	}
+}
+
+static void touch_kunit_bus_wait(struct touch_kunit_bus *bus)
+{
+	if (bus->latency_us)
+		usleep_range(bus->latency_us, bus->latency_us + 10);
+}
+
+#ifdef TOUCH_KUNIT_SPI_DELAY
+static unsigned int touch_kunit_spi_delay_us(struct spi_delay *delay)
+{
+	switch (delay->unit) {
+	case SPI_DELAY_UNIT_USECS:
+		return delay->value;
+	case SPI_DELAY_UNIT_NSECS:
+		return DIV_ROUND_UP(delay->value, 1000);
+	default:
+		return 0;
+	}
+}
+#endif
+
+/*
+ * One spi message is one bus transaction: the rx side of all its
+ * transfers is served from the same canned frame, and the tx side of
+ * the transfers without an rx buffer is recorded as written data.
+ */
+static int touch_kunit_spi_transfer_one_message(struct spi_controller *ctlr,
+		struct spi_message *msg)
+{
+	struct touch_kunit_bus *bus = spi_controller_get_devdata(ctlr);
+	struct touch_kunit_frame *frame = NULL;
+	struct touch_kunit_xfer *rec;
+	struct spi_transfer *t;
+	unsigned int offset = 0;
+	bool popped = false;
+
+	mutex_lock(&bus->lock);
+
+	bus->xfer_count = 0;
+	bus->tx_len = 0;
+	bus->msg_count++;
+
+	list_for_each_entry(t, &msg->transfers, transfer_list) {
+		if (bus->xfer_count < TOUCH_KUNIT_MAX_XFERS) {
+			rec = &bus->xfers[bus->xfer_count++];
+			rec->len = t->len;
+			rec->cs_change = t->cs_change;
+			rec->tx = !!t->tx_buf;
+			rec->rx = !!t->rx_buf;
+#ifdef TOUCH_KUNIT_SPI_DELAY
+			rec->delay_us = touch_kunit_spi_delay_us(&t->delay);
+			rec->word_delay_us =
+				touch_kunit_spi_delay_us(&t->word_delay);
+#else
+			rec->delay_us = t->delay_usecs;
+			rec->word_delay_us = 0;
+#endif
+		}
+
+		if (t->tx_buf)
+			touch_kunit_bus_log_tx(bus, t->tx_buf, t->len);
+
+		if (t->rx_buf) {
+			if (!popped) {
+				frame = touch_kunit_bus_pop_frame(bus);
+				popped = true;
+			}
+			touch_kunit_bus_fill_read(bus, frame, offset,
+					t->rx_buf, t->len);
+		} else {
+			touch_kunit_bus_log_write(bus, t->tx_buf, t->len);
+		}
+
+		offset += t->len;
+		msg->actual_length += t->len;
+	}
+
+	mutex_unlock(&bus->lock);
+
+	touch_kunit_bus_wait(bus);
+
+	msg->status = 0;
+	spi_finalize_current_message(ctlr);
+
+	return 0;
+}
+
+static int touch_kunit_i2c_xfer(struct i2c_adapter *adap,
+		struct i2c_msg *msgs, int num)
+{
+	struct touch_kunit_bus *bus = i2c_get_adapdata(adap);
+	int i;
+
+	mutex_lock(&bus->lock);
+
+	bus->msg_count++;
+
+	for (i = 0; i < num; i++) {
+		if (msgs[i].flags & I2C_M_RD)
+			touch_kunit_bus_fill_read(bus,
+					touch_kunit_bus_pop_frame(bus), 0,
+					msgs[i].buf, msgs[i].len);
+		else
+			touch_kunit_bus_log_write(bus, msgs[i].buf,
+					msgs[i].len);
+	}
+
+	mutex_unlock(&bus->lock);
+
+	touch_kunit_bus_wait(bus);
+
+	return num;
+}
+
+static u32 touch_kunit_i2c_func(struct i2c_adapter *adap)
+{
+	return I2C_FUNC_I2C | I2C_FUNC_SMBUS_EMUL;
+}
+
+static const struct i2c_algorithm touch_kunit_i2c_algo = {
+	.master_xfer = touch_kunit_i2c_xfer,
+	.functionality = touch_kunit_i2c_func,
+};
+
+static struct touch_kunit_bus *touch_kunit_bus_alloc(void)
+{
+	struct touch_kunit_bus *bus;
+
+	if (!touch_kunit_root)
+		return NULL;
+
+	bus = kzalloc(sizeof(*bus), GFP_KERNEL);
+	if (!bus)
+		return NULL;
+
+	mutex_init(&bus->lock);
+	bus->parent = touch_kunit_root;
+	bus->idle_byte = 0xff;
+
+	return bus;
+}
+
+/*
+ * touch_kunit_spi_bus_create - register a mock spi controller with one
+ * spi_device on chip select 0. The device is not bound to any driver,
+ * tests hand bus->spi to the code under test directly.
+ */
+struct touch_kunit_bus *touch_kunit_spi_bus_create(void)
+{
+	struct spi_board_info info = {
+		.modalias = "touch-kunit",
+		.max_speed_hz = 1000000,
+		.chip_select = 0,
+		.mode = SPI_MODE_0,
+	};
+	struct touch_kunit_bus *bus;
+	struct spi_controller *ctlr;
+	int ret;
+
+	bus = touch_kunit_bus_alloc();
+	if (!bus)
+		return NULL;
+
+	ctlr = spi_alloc_master(bus->parent, 0);
+	if (!ctlr)
+		goto err_free_bus;
+
+	spi_controller_set_devdata(ctlr, bus);
+	ctlr->bus_num = -1;
+	ctlr->num_chipselect = 1;
+	ctlr->mode_bits = SPI_CPOL | SPI_CPHA | SPI_CS_HIGH;
+	ctlr->bits_per_word_mask = SPI_BPW_MASK(8);
+	ctlr->transfer_one_message = touch_kunit_spi_transfer_one_message;
+
+	ret = spi_register_controller(ctlr);
+	if (ret) {
+		pr_err("%s: spi controller register failed, ret = %d\n",
+				__func__, ret);
+		spi_controller_put(ctlr);
+		goto err_free_bus;
+	}
+	bus->ctlr = ctlr;
+
+	bus->spi = spi_new_device(ctlr, &info);
+	if (!bus->spi) {
+		pr_err("%s: spi device create failed\n", __func__);
+		spi_unregister_controller(ctlr);
+		goto err_free_bus;
+	}
+
+	return bus;
+
+err_free_bus:
+	kfree(bus);
+	return NULL;
+}
+EXPORT_SYMBOL_GPL(touch_kunit_spi_bus_create);
+
+/*
+ * touch_kunit_i2c_bus_create - register a mock i2c adapter with one
+ * client at addr.
+ */
+struct touch_kunit_bus *touch_kunit_i2c_bus_create(unsigned short addr)
+{
+	struct i2c_board_info info = {
+		I2C_BOARD_INFO("touch-kunit", addr),
+	};
+	struct touch_kunit_bus *bus;
+	int ret;
+
+	bus = touch_kunit_bus_alloc();
+	if (!bus)
+		return NULL;
+
+	bus->adap.owner = THIS_MODULE;
+	bus->adap.algo = &touch_kunit_i2c_algo;
+	bus->adap.dev.parent = bus->parent;
+	strscpy(bus->adap.name, DRIVER_NAME, sizeof(bus->adap.name));
+	i2c_set_adapdata(&bus->adap, bus);
+
+	ret = i2c_add_adapter(&bus->adap);
+	if (ret) {
+		pr_err("%s: i2c adapter register failed, ret = %d\n",
+				__func__, ret);
+		goto err_free_bus;
+	}
+
+	bus->client = i2c_new_client_device(&bus->adap, &info);
+	if (IS_ERR(bus->client)) {
+		pr_err("%s: i2c client create failed, ret = %ld\n",
+				__func__, PTR_ERR(bus->client));
+		bus->client = NULL;
+		i2c_del_adapter(&bus->adap);
+		goto err_free_bus;
+	}
+
+	return bus;
+
+err_free_bus:
+	kfree(bus);
+	return NULL;
+}
+EXPORT_SYMBOL_GPL(touch_kunit_i2c_bus_create);
+
+void touch_kunit_bus_destroy(struct touch_kunit_bus *bus)
+{
+	if (!bus)
+		return;
+
+	/* the spi device goes with its controller */
+	if (bus->ctlr)
+		spi_unregister_controller(bus->ctlr);
+
+	if (bus->client) {
+		i2c_unregister_device(bus->client);
+		i2c_del_adapter(&bus->adap);
+	}
+
+	kfree(bus);
+}
+EXPORT_SYMBOL_GPL(touch_kunit_bus_destroy);
+
+int touch_kunit_bus_queue_frame(struct touch_kunit_bus *bus,
+		const unsigned char *data, unsigned int len)
+{
+	struct touch_kunit_frame *frame;
+
+	if (len > TOUCH_KUNIT_MAX_FRAME_SIZE)
+		return -EINVAL;
+
+	mutex_lock(&bus->lock);
+
+	if (bus->frame_count == TOUCH_KUNIT_MAX_FRAMES) {
+		mutex_unlock(&bus->lock);
+		return -ENOSPC;
+	}
+
+	frame = &bus->frames[(bus->frame_head + bus->frame_count) %
+			TOUCH_KUNIT_MAX_FRAMES];
+	memcpy(frame->data, data, len);
+	frame->len = len;
+	bus->frame_count++;
+
+	mutex_unlock(&bus->lock);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(touch_kunit_bus_queue_frame);
+
+void touch_kunit_bus_set_latency(struct touch_kunit_bus *bus,
+		unsigned int latency_us)
+{
+	WRITE_ONCE(bus->latency_us, latency_us);
+}
+EXPORT_SYMBOL_GPL(touch_kunit_bus_set_latency);
+
+/* forget the recorded writes, transfers and the pending frames */
+void touch_kunit_bus_reset_log(struct touch_kunit_bus *bus)
+{
+	mutex_lock(&bus->lock);
+	bus->frame_head = 0;
+	bus->frame_count = 0;
+	bus->write_len = 0;
+	bus->tx_len = 0;
+	bus->xfer_count = 0;
+	bus->msg_count = 0;
+	mutex_unlock(&bus->lock);
+}
+EXPORT_SYMBOL_GPL(touch_kunit_bus_reset_log);
+
+static void touch_kunit_irq_noop(struct irq_data *data)
+{
+}
+
+static struct irq_chip touch_kunit_irq_chip = {
+	.name = DRIVER_NAME,
+	.irq_mask = touch_kunit_irq_noop,
+	.irq_unmask = touch_kunit_irq_noop,
+};
+
+static int touch_kunit_gpio_get(struct gpio_chip *gc, unsigned int offset)
+{
+	struct touch_kunit_irq *line = gpiochip_get_data(gc);
+
+	return READ_ONCE(line->level);
+}
+
+static int touch_kunit_gpio_get_direction(struct gpio_chip *gc,
+		unsigned int offset)
+{
+	return GPIO_LINE_DIRECTION_IN;
+}
+
+static int touch_kunit_gpio_direction_input(struct gpio_chip *gc,
+		unsigned int offset)
+{
+	return 0;
+}
+
+static int touch_kunit_gpio_to_irq(struct gpio_chip *gc, unsigned int offset)
+{
+	struct touch_kunit_irq *line = gpiochip_get_data(gc);
+
+	return line->irq;
+}
+
+static irqreturn_t touch_kunit_irq_primary(int irq, void *data)
+{
+	struct touch_kunit_irq *line = data;
+	irqreturn_t ret = IRQ_WAKE_THREAD;
+
+	if (line->handler)
+		ret = line->handler(irq, line->dev_id);
+
+	line->last_ret = ret;
+
+	return ret;
+}
+
+static irqreturn_t touch_kunit_irq_thread(int irq, void *data)
+{
+	struct touch_kunit_irq *line = data;
+	irqreturn_t ret;
+
+	atomic_inc(&line->threaded);
+	ret = line->thread_fn(irq, line->dev_id);
+	line->last_ret = ret;
+
+	return ret;
+}
+
+/* raised from hard irq context, as the gpio controller would */
+static void touch_kunit_irq_work(struct irq_work *work)
+{
+	struct touch_kunit_irq *line =
+		container_of(work, struct touch_kunit_irq, work);
+
+	generic_handle_irq(line->irq);
+}
+
+/*
+ * touch_kunit_irq_init - create a fake ATTN line and request its
+ * interrupt with the driver's handlers, oneshot like the drivers' own
+ * level triggered ATTN. The line reads high until fired.
+ */
+int touch_kunit_irq_init(struct touch_kunit_irq *line,
+		irq_handler_t handler, irq_handler_t thread_fn, void *dev_id)
+{
+	int ret;
+
+	if (!touch_kunit_root)
+		return -ENODEV;
+
+	memset(line, 0, sizeof(*line));
+	line->handler = handler;
+	line->thread_fn = thread_fn;
+	line->dev_id = dev_id;
+	line->level = 1;
+	line->gpio = -1;
+	line->work = IRQ_WORK_INIT_HARD(touch_kunit_irq_work);
+
+	line->irq = irq_alloc_desc(NUMA_NO_NODE);
+	if (line->irq < 0)
+		return line->irq;
+
+	irq_set_chip_and_handler(line->irq, &touch_kunit_irq_chip,
+			handle_level_irq);
+	irq_clear_status_flags(line->irq, IRQ_NOREQUEST | IRQ_NOPROBE);
+
+	line->gc.label = DRIVER_NAME;
+	line->gc.parent = touch_kunit_root;
+	line->gc.owner = THIS_MODULE;
+	line->gc.base = -1;
+	line->gc.ngpio = 1;
+	line->gc.get = touch_kunit_gpio_get;
+	line->gc.get_direction = touch_kunit_gpio_get_direction;
+	line->gc.direction_input = touch_kunit_gpio_direction_input;
+	line->gc.to_irq = touch_kunit_gpio_to_irq;
+
+	ret = gpiochip_add_data(&line->gc, line);
+	if (ret) {
+		pr_err("%s: gpio chip add failed, ret = %d\n", __func__, ret);
+		goto err_free_desc;
+	}
+	line->gpio = line->gc.base;
+
+	ret = request_threaded_irq(line->irq, touch_kunit_irq_primary,
+			thread_fn ? touch_kunit_irq_thread : NULL,
+			IRQF_ONESHOT, DRIVER_NAME, line);
+	if (ret) {
+		pr_err("%s: irq request failed, ret = %d\n", __func__, ret);
+		goto err_remove_chip;
+	}
+	line->requested = true;
+
+	return 0;
+
+err_remove_chip:
+	gpiochip_remove(&line->gc);
+	line->gpio = -1;
+err_free_desc:
+	irq_free_desc(line->irq);
+	line->irq = 0;
+	return ret;
+}
+EXPORT_SYMBOL_GPL(touch_kunit_irq_init);
+
+void touch_kunit_irq_release(struct touch_kunit_irq *line)
+{
+	if (!line->requested)
+		return;
+
+	irq_work_sync(&line->work);
+	free_irq(line->irq, line);
+	gpiochip_remove(&line->gc);
+	irq_free_desc(line->irq);
+	line->requested = false;
+}
+EXPORT_SYMBOL_GPL(touch_kunit_irq_release);
+
+/*
+ * touch_kunit_irq_fire - assert the line, deliver its interrupt and wait
+ * for the handlers, the threaded one included, before releasing it.
+ * Returns what the last handler that ran returned.
+ */
+irqreturn_t touch_kunit_irq_fire(struct touch_kunit_irq *line)
+{
+	if (!line->requested)
+		return IRQ_NONE;
+
+	line->last_ret = IRQ_NONE;
+	atomic_inc(&line->fired);
+	WRITE_ONCE(line->level, 0);
+
+	irq_work_queue(&line->work);
+	irq_work_sync(&line->work);
+	synchronize_irq(line->irq);
+
+	WRITE_ONCE(line->level, 1);
+
+	return line->last_ret;
+}
+EXPORT_SYMBOL_GPL(touch_kunit_irq_fire);
+
+static void touch_kunit_input_event(struct input_handle *handle,
+		unsigned int type, unsigned int code, int value)
+{
+	struct touch_kunit_input *cap = handle->private;
+
+	spin_lock(&cap->lock);
+	if (cap->count < TOUCH_KUNIT_MAX_EVENTS) {
+		cap->events[cap->count].type = type;
+		cap->events[cap->count].code = code;
+		cap->events[cap->count].value = value;
+		cap->count++;
+	} else {
+		cap->overflow++;
+	}
+	spin_unlock(&cap->lock);
+}
+
+static bool touch_kunit_input_match(struct input_handler *handler,
+		struct input_dev *dev)
+{
+	struct touch_kunit_input *cap =
+		container_of(handler, struct touch_kunit_input, handler);
+
+	return dev == cap->target;
+}
+
+static int touch_kunit_input_connect(struct input_handler *handler,
+		struct input_dev *dev, const struct input_device_id *id)
+{
+	struct touch_kunit_input *cap =
+		container_of(handler, struct touch_kunit_input, handler);
+	struct input_handle *handle = &cap->handle;
+	int ret;
+
+	handle->dev = dev;
+	handle->handler = handler;
+	handle->name = DRIVER_NAME;
+	handle->private = cap;
+
+	ret = input_register_handle(handle);
+	if (ret)
+		return ret;
+
+	ret = input_open_device(handle);
+	if (ret) {
+		input_unregister_handle(handle);
+		return ret;
+	}
+
+	cap->connected = true;
+
+	return 0;
+}
+
+static void touch_kunit_input_disconnect(struct input_handle *handle)
+{
+	struct touch_kunit_input *cap = handle->private;
+
+	input_close_device(handle);
+	input_unregister_handle(handle);
+	cap->connected = false;
+}
+
+static const struct input_device_id touch_kunit_input_ids[] = {
+	{ .driver_info = 1 },
+	{ },
+};
+
+/*
+ * touch_kunit_input_capture - record every event target reports. The
+ * handler only binds to target, other input devices are left alone.
+ */
+int touch_kunit_input_capture(struct touch_kunit_input *cap,
+		struct input_dev *target)
+{
+	int ret;
+
+	memset(cap, 0, sizeof(*cap));
+	spin_lock_init(&cap->lock);
+	cap->target = target;
+
+	cap->handler.event = touch_kunit_input_event;
+	cap->handler.match = touch_kunit_input_match;
+	cap->handler.connect = touch_kunit_input_connect;
+	cap->handler.disconnect = touch_kunit_input_disconnect;
+	cap->handler.name = DRIVER_NAME;
+	cap->handler.id_table = touch_kunit_input_ids;
+
+	ret = input_register_handler(&cap->handler);
+	if (ret)
+		return ret;
+
+	if (!cap->connected) {
+		input_unregister_handler(&cap->handler);
+		return -ENODEV;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(touch_kunit_input_capture);
+
+void touch_kunit_input_release(struct touch_kunit_input *cap)
+{
+	input_unregister_handler(&cap->handler);
+}
+EXPORT_SYMBOL_GPL(touch_kunit_input_release);
+
+unsigned int touch_kunit_input_count(struct touch_kunit_input *cap,
+		unsigned int type, unsigned int code)
+{
+	unsigned long flags;
+	unsigned int count = 0;
+	unsigned int i;
+
+	spin_lock_irqsave(&cap->lock, flags);
+	for (i = 0; i < cap->count; i++) {
+		if (cap->events[i].type == type && cap->events[i].code == code)
+			count++;
+	}
+	spin_unlock_irqrestore(&cap->lock, flags);
+
+	return count;
+}
+EXPORT_SYMBOL_GPL(touch_kunit_input_count);
+
+void touch_kunit_input_reset(struct touch_kunit_input *cap)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&cap->lock, flags);
+	cap->count = 0;
+	cap->overflow = 0;
+	spin_unlock_irqrestore(&cap->lock, flags);
+}
+EXPORT_SYMBOL_GPL(touch_kunit_input_reset);
+
+static int __init touch_kunit_init(void)
+{
+	touch_kunit_root = root_device_register(DRIVER_NAME);
+	if (IS_ERR(touch_kunit_root)) {
+		pr_err("%s: root device register failed\n", __func__);
+		return PTR_ERR(touch_kunit_root);
+	}
+
+	return 0;
+}
+
+static void __exit touch_kunit_exit(void)
+{
+	root_device_unregister(touch_kunit_root);
+	touch_kunit_root = NULL;
+}
+
+module_init(touch_kunit_init);
+module_exit(touch_kunit_exit);
@@ -0,0 +1,164 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ */
+
+#ifndef _TOUCH_KUNIT_H_
+#define _TOUCH_KUNIT_H_
+
+#include <linux/gpio/driver.h>
+#include <linux/i2c.h>
+#include <linux/input.h>
+#include <linux/interrupt.h>
+#include <linux/irq_work.h>
+#include <linux/mutex.h>
+#include <linux/spi/spi.h>
+#include <linux/spinlock.h>
+#include <linux/version.h>
+
+#if !IS_ENABLED(CONFIG_KUNIT)
+#error "CONFIG_TOUCHSCREEN_KUNIT_TEST depends on CONFIG_KUNIT"
+#endif
+
+/*
+ * The suites are built into the driver they cover, next to its own
+ * module_init(). Before 5.18 kunit_test_suite() defines a module_init()
+ * of its own, which clashes with it.
+ */
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5, 18, 0)
+#error "CONFIG_TOUCHSCREEN_KUNIT_TEST needs a 5.18 or later kernel"
+#endif
+
+/*
+ * Mock bus harness for the touch driver KUnit tests.
+ *
+ * A touch_kunit_bus stands in for the controller a touch IC hangs off:
+ * reads are served from canned frames queued by the test, writes and the
+ * shape of every SPI transfer are recorded for the test to check. The
+ * fake ATTN line is a one-line gpio chip with an interrupt of its own, and
+ * the input capture records what the driver reports to the input core.
+ */
+
+#define TOUCH_KUNIT_MAX_FRAMES		16
+#define TOUCH_KUNIT_MAX_FRAME_SIZE	512
+#define TOUCH_KUNIT_MAX_XFERS		64
+#define TOUCH_KUNIT_WRITE_LOG_SIZE	1024
+#define TOUCH_KUNIT_MAX_EVENTS		256
+
+/* layout of one spi_transfer as seen by the controller */
+struct touch_kunit_xfer {
+	unsigned int len;
+	/* delay after the transfer, in us */
+	unsigned int delay_us;
+	/* delay between words, in us */
+	unsigned int word_delay_us;
+	bool cs_change;
+	bool tx;
+	bool rx;
+};
+
+struct touch_kunit_frame {
+	unsigned int len;
+	unsigned char data[TOUCH_KUNIT_MAX_FRAME_SIZE];
+};
+
+struct touch_kunit_bus {
+	struct device *parent;
+
+	/* spi side */
+	struct spi_controller *ctlr;
+	struct spi_device *spi;
+
+	/* i2c side */
+	struct i2c_adapter adap;
+	struct i2c_client *client;
+
+	struct mutex lock;
+
+	/* canned frames, one per spi message or i2c read */
+	struct touch_kunit_frame frames[TOUCH_KUNIT_MAX_FRAMES];
+	unsigned int frame_head;
+	unsigned int frame_count;
+	/* pattern returned once the canned frames run out */
+	unsigned char idle_byte;
+	/* time spent on each message, in us */
+	unsigned int latency_us;
+
+	/* bytes written by the host, in order */
+	unsigned char write_log[TOUCH_KUNIT_WRITE_LOG_SIZE];
+	unsigned int write_len;
+
+	/* bytes clocked out in the last spi message, reads included */
+	unsigned char tx_log[TOUCH_KUNIT_MAX_FRAME_SIZE];
+	unsigned int tx_len;
+
+	/* transfers of the last spi message */
+	struct touch_kunit_xfer xfers[TOUCH_KUNIT_MAX_XFERS];
+	unsigned int xfer_count;
+	unsigned int msg_count;
+};
+
+/*
+ * fake ATTN line: an active low gpio whose interrupt is a real irq
+ * descriptor, so the driver's handlers run from the irq core, the
+ * threaded one in its own irq thread
+ */
+struct touch_kunit_irq {
+	struct gpio_chip gc;
+	struct irq_work work;
+	/* legacy gpio number and irq of the line */
+	int gpio;
+	int irq;
+	bool requested;
+	/* current level, 0 while asserted */
+	int level;
+
+	irq_handler_t handler;
+	irq_handler_t thread_fn;
+	void *dev_id;
+	irqreturn_t last_ret;
+	atomic_t fired;
+	atomic_t threaded;
+};
+
+struct touch_kunit_event {
+	unsigned int type;
+	unsigned int code;
+	int value;
+};
+
+struct touch_kunit_input {
+	struct input_handler handler;
+	struct input_handle handle;
+	struct input_dev *target;
+	bool connected;
+
+	spinlock_t lock;
+	struct touch_kunit_event events[TOUCH_KUNIT_MAX_EVENTS];
+	unsigned int count;
+	unsigned int overflow;
+};
+
+struct touch_kunit_bus *touch_kunit_spi_bus_create(void);
+struct touch_kunit_bus *touch_kunit_i2c_bus_create(unsigned short addr);
+void touch_kunit_bus_destroy(struct touch_kunit_bus *bus);
+
+int touch_kunit_bus_queue_frame(struct touch_kunit_bus *bus,
+		const unsigned char *data, unsigned int len);
+void touch_kunit_bus_set_latency(struct touch_kunit_bus *bus,
+		unsigned int latency_us);
+void touch_kunit_bus_reset_log(struct touch_kunit_bus *bus);
+
+int touch_kunit_irq_init(struct touch_kunit_irq *line,
+		irq_handler_t handler, irq_handler_t thread_fn, void *dev_id);
+void touch_kunit_irq_release(struct touch_kunit_irq *line);
+irqreturn_t touch_kunit_irq_fire(struct touch_kunit_irq *line);
+
+int touch_kunit_input_capture(struct touch_kunit_input *cap,
+		struct input_dev *target);
+void touch_kunit_input_release(struct touch_kunit_input *cap);
+unsigned int touch_kunit_input_count(struct touch_kunit_input *cap,
+		unsigned int type, unsigned int code);
+void touch_kunit_input_reset(struct touch_kunit_input *cap);
+
+#endif /* _TOUCH_KUNIT_H_ */
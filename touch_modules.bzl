@@ -94,6 +94,15 @@ module_entry(
     ]
 )
 
+#define ddk_module() for touch_kunit
+module_entry(
+    name = "touch_kunit",
+    config_option = "CONFIG_TOUCHSCREEN_KUNIT_TEST",
+    srcs = [
+            "touch_kunit/touch_kunit.c"
+    ]
+)
+
 #define ddk_module() for glink_interface_ts
 module_entry(
     name = "glink_comm",
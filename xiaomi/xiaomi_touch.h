@@ -5,6 +5,8 @@
 #include <linux/module.h>
 #include <linux/types.h>
 #include <linux/wait.h>
+#include <linux/eventfd.h>
+#include <linux/mutex.h>
 #include <asm/atomic.h>
 #include <linux/workqueue.h>
 #include <linux/kernel.h>
@@ -139,12 +141,6 @@ extern enum MI_TP_LOG_LEVEL current_log_level;
 			tm.tm_hour, tm.tm_min, tm.tm_sec, ts.tv_nsec/1000); \
 	} while(0)
 
-enum poll_notify_type {
-	COMMON_DATA_NOTIFY = 0,
-	FRAME_DATA_NOTIFY,
-	RAW_DATA_NOTIFY,
-};
-
 typedef struct private_data {
 	struct list_head node;
 	u8 mmap_area;
@@ -153,6 +149,9 @@ typedef struct private_data {
 	wait_queue_head_t poll_wait_queue_head_for_cmd;
 	wait_queue_head_t poll_wait_queue_head_for_frame;
 	wait_queue_head_t poll_wait_queue_head_for_raw;
+	/* eventfd signaled instead of the poll wait queues, per notify type */
+	struct eventfd_ctx __rcu *eventfd[POLL_NOTIFY_TYPE_MAX];
+	struct mutex eventfd_lock;
 
 	atomic_t common_data_index;
 	atomic_t frame_data_index;
@@ -174,6 +173,9 @@ typedef struct xiaomi_touch_data {
 	void *raw_data_mmap_base;
 	dma_addr_t raw_data_mmap_phy_base;
 
+	data_ring_header_page_t *data_ring_header;
+	dma_addr_t data_ring_header_phy_base;
+
 	struct list_head private_data_list;
 	spinlock_t private_data_lock;
 
@@ -230,6 +232,7 @@ typedef struct hardware_operation {
 
 	int (*ic_resume_suspend)(bool is_resume, u8 gesture_type);
 	void (*ic_set_charge_state)(int status);
+	void (*ic_set_panel_fps)(int fps);
 	void (*ic_set_fod_value)(s32 value[], int length);
 #ifdef TOUCH_FOD_SUPPORT
 	void (*xiaomi_touch_fod_test)(int value);
@@ -288,7 +291,9 @@ int update_fod_press_status(int value);
 struct class *get_xiaomi_touch_class(void);
 int update_palm_sensor_value(int value);
 void *get_raw_data_base(s8 touch_id);
+void *begin_raw_data_update(s8 touch_id);
 void notify_raw_data_update(s8 touch_id);
+void cancel_raw_data_update(s8 touch_id);
 void add_common_data_to_buf(s8 touch_id, enum common_data_cmd cmd, enum common_data_mode mode, int length, int *data);
 int register_touch_panel(struct device *dev, s8 touch_id, hardware_param_t *hardware_param, hardware_operation_t *hardware_operation);
 void unregister_touch_panel(s8 touch_id);
@@ -315,6 +320,7 @@ void update_knock_data(u8 *buf, int size, int frame_id);
 void knock_data_notify(void);
 #endif
 void notify_xiaomi_touch(xiaomi_touch_data_t *xiaomi_touch_data, enum poll_notify_type type);
+void publish_data_ring_slot(xiaomi_touch_data_t *xiaomi_touch_data, enum poll_notify_type type);
 void update_get_ic_current_value(common_data_t *common_data);
 void schedule_resume_suspend_work(s8 touch_id, bool resume_work);
 
@@ -20,6 +20,7 @@
 #endif
 #endif
 #include <linux/power_supply.h>
+#include <linux/version.h>
 #include <net/sock.h>
 #include <net/netlink.h>
 
@@ -173,11 +174,23 @@ xiaomi_touch_driver_param_t *get_xiaomi_touch_driver_param(s8 touch_id)
 void notify_xiaomi_touch(xiaomi_touch_data_t *xiaomi_touch_data, enum poll_notify_type type)
 {
 	private_data_t *client_private_data = NULL;
-	if (!xiaomi_touch_data)
+	struct eventfd_ctx *eventfd = NULL;
+	if (!xiaomi_touch_data || type < 0 || type >= POLL_NOTIFY_TYPE_MAX)
 		return;
-	spin_lock(&xiaomi_touch_data->private_data_lock);
+	rcu_read_lock();
 	list_for_each_entry_rcu(client_private_data, &xiaomi_touch_data->private_data_list, node) {
 		LOG_DEBUG("notify xiaomi-touch data update, client private data is %p", client_private_data);
+		eventfd = rcu_dereference(client_private_data->eventfd[type]);
+		if (eventfd) {
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 8, 0)
+			eventfd_signal(eventfd);
+#else
+			eventfd_signal(eventfd, 1);
+#endif
+			continue;
+		}
+		if (type == KNOCK_DATA_NOTIFY)
+			continue;
 		wake_up_all(&client_private_data->poll_wait_queue_head);
 		if (type == COMMON_DATA_NOTIFY) {
 			wake_up_all(&client_private_data->poll_wait_queue_head_for_cmd);
@@ -187,7 +200,7 @@ void notify_xiaomi_touch(xiaomi_touch_data_t *xiaomi_touch_data, enum poll_notif
 			wake_up_all(&client_private_data->poll_wait_queue_head_for_raw);
 		}
 	}
-	spin_unlock(&xiaomi_touch_data->private_data_lock);
+	rcu_read_unlock();
 }
 
 void add_common_data_to_buf(s8 touch_id, enum common_data_cmd cmd, enum common_data_mode mode, int length, int *data)
@@ -218,6 +231,138 @@ void add_common_data_to_buf(s8 touch_id, enum common_data_cmd cmd, enum common_d
 EXPORT_SYMBOL_GPL(add_common_data_to_buf);
 
 
+static data_ring_slot_t *get_data_ring_slot(data_ring_header_t *ring, int index)
+{
+	/* the header page is shared with userspace, don't trust slot_count */
+	if (index < 0 || index >= min_t(u32, READ_ONCE(ring->slot_count), DATA_RING_MAX_SLOTS))
+		return NULL;
+
+	return &ring->slots[index];
+}
+
+/* the slot is being written, seq becomes odd */
+static void data_ring_write_begin(data_ring_header_t *ring, int index)
+{
+	data_ring_slot_t *slot = get_data_ring_slot(ring, index);
+
+	if (!slot || (READ_ONCE(slot->seq) & 1))
+		return;
+
+	WRITE_ONCE(slot->seq, slot->seq + 1);
+	smp_wmb();
+}
+
+/* the slot is complete, seq becomes even */
+static void data_ring_write_end(data_ring_header_t *ring, int index)
+{
+	data_ring_slot_t *slot = get_data_ring_slot(ring, index);
+
+	if (!slot)
+		return;
+
+	ring->frame_number++;
+	slot->frame_number = ring->frame_number;
+	slot->timestamp_ns = ktime_get_ns();
+	smp_wmb();
+	WRITE_ONCE(slot->seq, (slot->seq | 1) + 1);
+}
+
+/* the write is given up, the slot holds no frame any more */
+static void data_ring_write_cancel(data_ring_header_t *ring, int index)
+{
+	data_ring_slot_t *slot = get_data_ring_slot(ring, index);
+
+	if (!slot || !(READ_ONCE(slot->seq) & 1))
+		return;
+
+	slot->frame_number = 0;
+	slot->timestamp_ns = 0;
+	smp_wmb();
+	WRITE_ONCE(slot->seq, slot->seq + 1);
+}
+
+/*
+ * Publish the slot at current buf index of frame data or raw data area,
+ * then move the buf index to the next slot.
+ */
+void publish_data_ring_slot(xiaomi_touch_data_t *xiaomi_touch_data, enum poll_notify_type type)
+{
+	private_data_t *client_private_data = NULL;
+	data_ring_header_t *ring = NULL;
+	atomic_t *buf_index = NULL;
+	u8 buf_size = 0;
+	int index = 0;
+	int next = 0;
+
+	if (type == FRAME_DATA_NOTIFY) {
+		buf_index = &xiaomi_touch_data->frame_data_buf_index;
+		buf_size = xiaomi_touch_data->frame_data_buf_size;
+		if (xiaomi_touch_data->data_ring_header)
+			ring = &xiaomi_touch_data->data_ring_header->frame_data;
+	} else if (type == RAW_DATA_NOTIFY) {
+		buf_index = &xiaomi_touch_data->raw_data_buf_index;
+		buf_size = xiaomi_touch_data->raw_data_buf_size;
+		if (xiaomi_touch_data->data_ring_header)
+			ring = &xiaomi_touch_data->data_ring_header->raw_data;
+	} else {
+		return;
+	}
+
+	index = atomic_read(buf_index);
+	next = index + 1;
+	if (next >= buf_size)
+		next = 0;
+
+	if (ring) {
+		data_ring_write_end(ring, index);
+
+		/* a client which hasn't fetched the next slot is going to lose it */
+		rcu_read_lock();
+		list_for_each_entry_rcu(client_private_data, &xiaomi_touch_data->private_data_list, node) {
+			if ((type == FRAME_DATA_NOTIFY &&
+					atomic_read(&client_private_data->frame_data_index) == next) ||
+					(type == RAW_DATA_NOTIFY &&
+					atomic_read(&client_private_data->raw_data_index) == next)) {
+				ring->overrun_count++;
+				break;
+			}
+		}
+		rcu_read_unlock();
+
+		smp_wmb();
+		WRITE_ONCE(ring->write_index, next);
+	}
+
+	atomic_set(buf_index, next);
+}
+
+static void *get_frame_data_slot(xiaomi_touch_data_t *xiaomi_touch_data)
+{
+	if (!xiaomi_touch_data->frame_data_mmap_base)
+		return NULL;
+
+	return xiaomi_touch_data->frame_data_mmap_base +
+		atomic_read(&xiaomi_touch_data->frame_data_buf_index) * xiaomi_touch_data->frame_data_size;
+}
+
+/* mark the current frame data slot as being written and return it */
+static void *begin_frame_data_write(xiaomi_touch_data_t *xiaomi_touch_data)
+{
+	void *base = get_frame_data_slot(xiaomi_touch_data);
+
+	if (base && xiaomi_touch_data->data_ring_header)
+		data_ring_write_begin(&xiaomi_touch_data->data_ring_header->frame_data,
+			atomic_read(&xiaomi_touch_data->frame_data_buf_index));
+	return base;
+}
+
+static void cancel_frame_data_write(xiaomi_touch_data_t *xiaomi_touch_data)
+{
+	if (xiaomi_touch_data->data_ring_header)
+		data_ring_write_cancel(&xiaomi_touch_data->data_ring_header->frame_data,
+			atomic_read(&xiaomi_touch_data->frame_data_buf_index));
+}
+
 void *get_raw_data_base(s8 touch_id)
 {
 	xiaomi_touch_data_t *xiaomi_touch_data = get_xiaomi_touch_data(touch_id);
@@ -226,29 +371,54 @@ void *get_raw_data_base(s8 touch_id)
 	if (!xiaomi_touch_data)
 		return NULL;
 
-	if (!xiaomi_touch_data->frame_data_mmap_base) {
+	base = get_frame_data_slot(xiaomi_touch_data);
+	if (!base)
 		LOG_ERROR("touch id %d copy data failed, xiaomi_touch_data %p, base %p",
 			touch_id, xiaomi_touch_data, xiaomi_touch_data->frame_data_mmap_base);
+	return base;
+}
+EXPORT_SYMBOL_GPL(get_raw_data_base);
+
+/*
+ * Start writing a frame to the current raw data slot. The write shall end
+ * with notify_raw_data_update() to publish the frame, or with
+ * cancel_raw_data_update() if the frame is given up.
+ */
+void *begin_raw_data_update(s8 touch_id)
+{
+	xiaomi_touch_data_t *xiaomi_touch_data = get_xiaomi_touch_data(touch_id);
+	void *base = NULL;
+
+	if (!xiaomi_touch_data)
 		return NULL;
-	}
 
-	base = xiaomi_touch_data->frame_data_mmap_base +
-		atomic_read(&xiaomi_touch_data->frame_data_buf_index) * xiaomi_touch_data->frame_data_size;
+	base = begin_frame_data_write(xiaomi_touch_data);
+	if (!base)
+		LOG_ERROR("touch id %d copy data failed, xiaomi_touch_data %p, base %p",
+			touch_id, xiaomi_touch_data, xiaomi_touch_data->frame_data_mmap_base);
 	return base;
 }
-EXPORT_SYMBOL_GPL(get_raw_data_base);
+EXPORT_SYMBOL_GPL(begin_raw_data_update);
 
-void notify_raw_data_update(s8 touch_id)
+void cancel_raw_data_update(s8 touch_id)
 {
 	xiaomi_touch_data_t *xiaomi_touch_data = get_xiaomi_touch_data(touch_id);
 
 	if (!xiaomi_touch_data)
 		return;
 
-	atomic_inc(&xiaomi_touch_data->frame_data_buf_index);
-	if (atomic_read(&xiaomi_touch_data->frame_data_buf_index) >= xiaomi_touch_data->frame_data_buf_size)
-		atomic_set(&xiaomi_touch_data->frame_data_buf_index, 0);
+	cancel_frame_data_write(xiaomi_touch_data);
+}
+EXPORT_SYMBOL_GPL(cancel_raw_data_update);
+
+void notify_raw_data_update(s8 touch_id)
+{
+	xiaomi_touch_data_t *xiaomi_touch_data = get_xiaomi_touch_data(touch_id);
+
+	if (!xiaomi_touch_data)
+		return;
 
+	publish_data_ring_slot(xiaomi_touch_data, FRAME_DATA_NOTIFY);
 
 	notify_xiaomi_touch(xiaomi_touch_data, FRAME_DATA_NOTIFY);
 }
@@ -439,6 +609,19 @@ int register_touch_panel(struct device *dev, s8 touch_id, hardware_param_t *hard
 		xiaomi_touch_data->raw_data_mmap_phy_base = virt_to_phys(xiaomi_touch_data->raw_data_mmap_base);
 	}
 
+	BUILD_BUG_ON(sizeof(data_ring_header_page_t) > PAGE_SIZE);
+	xiaomi_touch_data->data_ring_header_phy_base = 0;
+	xiaomi_touch_data->data_ring_header = kzalloc_retry(PAGE_SIZE, 3);
+	if (!xiaomi_touch_data->data_ring_header) {
+		LOG_ERROR("touch id %d alloc data ring header failed!", touch_id);
+		return -1;
+	}
+	xiaomi_touch_data->data_ring_header->frame_data.slot_count =
+		min_t(u32, xiaomi_touch_data->frame_data_buf_size, DATA_RING_MAX_SLOTS);
+	xiaomi_touch_data->data_ring_header->raw_data.slot_count =
+		min_t(u32, xiaomi_touch_data->raw_data_buf_size, DATA_RING_MAX_SLOTS);
+	xiaomi_touch_data->data_ring_header_phy_base = virt_to_phys(xiaomi_touch_data->data_ring_header);
+
 	xiaomi_touch_data->event_wq = alloc_workqueue("xiaomi-touch-event-queue",
 		WQ_UNBOUND | WQ_HIGHPRI | WQ_CPU_INTENSIVE, 1);
 	if (!xiaomi_touch_data->event_wq) {
@@ -525,6 +708,10 @@ void unregister_touch_panel(s8 touch_id)
 		kzalloc_free(xiaomi_touch_data->raw_data_mmap_base);
 		xiaomi_touch_data->raw_data_mmap_base = NULL;
 		xiaomi_touch_data->raw_data_mmap_phy_base = 0;
+
+		kzalloc_free(xiaomi_touch_data->data_ring_header);
+		xiaomi_touch_data->data_ring_header = NULL;
+		xiaomi_touch_data->data_ring_header_phy_base = 0;
 	}
 
 	/* remove proc node */
@@ -675,6 +862,17 @@ static void xiaomi_drm_panel_notifier_callback(enum xring_panel_event_tag tag,
 		LOG_INFO("notification complete");
 }
 #else
+static void xiaomi_touch_panel_fps_change(s8 touch_id, int fps)
+{
+	xiaomi_touch_driver_param_t *xiaomi_touch_driver_param = get_xiaomi_touch_driver_param(touch_id);
+
+	if (!xiaomi_touch_driver_param || fps <= 0)
+		return;
+	LOG_INFO("touch id %d panel fps %d", touch_id, fps);
+	if (xiaomi_touch_driver_param->hardware_operation.ic_set_panel_fps)
+		xiaomi_touch_driver_param->hardware_operation.ic_set_panel_fps(fps);
+}
+
 static void xiaomi_drm_panel_notifier_callback(enum panel_event_notifier_tag tag,
 		struct panel_event_notification *notification, void *client_data)
 {
@@ -701,6 +899,7 @@ static void xiaomi_drm_panel_notifier_callback(enum panel_event_notifier_tag tag
 		}
 		break;
 	case DRM_PANEL_EVENT_FPS_CHANGE:
+		xiaomi_touch_panel_fps_change((s8)touch_id, notification->notif_data.new_fps);
 		break;
 	default:
 		LOG_ERROR("notification serviced :%d", notification->notif_type);
@@ -988,3 +1187,7 @@ MODULE_LICENSE("GPL");
 
 module_init(xiaomi_touch_init);
 module_exit(xiaomi_touch_exit);
+
+#if IS_ENABLED(CONFIG_TOUCHSCREEN_KUNIT_TEST)
+#include "../touch_kunit/tests/xiaomi_touch_ring_test.c"
+#endif
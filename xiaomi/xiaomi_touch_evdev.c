@@ -9,11 +9,13 @@
 #include <linux/proc_fs.h>
 #include <linux/seq_file.h>
 #include <linux/string.h>
+#include <linux/spinlock.h>
 #include "xiaomi_touch.h"
 
 #define LAST_TOUCH_EVENTS_MAX	(512)
 
 #define INPUT_EVENT_TIME_LINE_BUF_SIZE  (120)
+#define INPUT_EVENT_TIME_LINE_MEM_SIZE  (PAGE_SIZE * 45)
 #define NO_EVENT_TIME_BUF_SIZE  (20)
 #define CHANNEL_COUNT    10
 #define APP_NAME_SIZE    64
@@ -41,8 +43,28 @@ typedef struct input_event_time_line {
 	int64_t gpuCompletedTime;
 	int64_t presentTime;
 } input_event_time_line_t;
+
+/*
+ * Placed right after the time line array in the same mmap area.
+ * The no event time arrays of each time line are rings, the oldest entry
+ * is at noEventTimeHead. seq is odd while the time line is being updated.
+ * magic and version are set once the area is allocated, a reader that
+ * doesn't find the values it knows shall not parse the header.
+ * Kernel keeps its own copy of the heads and counts and only publishes
+ * them here, whatever is written to the area from userspace is ignored.
+ */
+typedef struct input_event_time_line_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t seq;
+	int32_t writeIndex;
+	int8_t noEventTimeHead[INPUT_EVENT_TIME_LINE_BUF_SIZE];
+} input_event_time_line_header_t;
 #pragma pack()
 
+#define INPUT_EVENT_TIME_LINE_MAGIC     (0x4c544958)	/* "XITL" */
+#define INPUT_EVENT_TIME_LINE_VERSION   (1)
+
 enum touch_state {
 	EVENT_INIT,
 	EVENT_DOWN,
@@ -62,7 +84,12 @@ struct last_touch_event {
 };
 
 static int input_event_time_line_index = 0;
+/* kernel copy of noEventTimeHead and noEventTimeCount of each time line */
+static int8_t no_event_time_head[INPUT_EVENT_TIME_LINE_BUF_SIZE];
+static int8_t no_event_time_count[INPUT_EVENT_TIME_LINE_BUF_SIZE];
 static input_event_time_line_t *input_event_time_line_base = NULL;
+static input_event_time_line_header_t *input_event_time_line_header = NULL;
+static DEFINE_SPINLOCK(input_event_time_line_lock);
 static xiaomi_touch_t *xiaomi_touch;
 static struct proc_dir_entry *last_touch_events_pde = NULL;
 static struct last_touch_event last_touch_events;
@@ -165,52 +192,78 @@ const struct seq_operations last_touch_events_seq_ops = {
 	.show = event_show,
 };
 
+static inline int no_event_time_pos(int head, int index)
+{
+	index += head;
+	return index >= NO_EVENT_TIME_BUF_SIZE ? index - NO_EVENT_TIME_BUF_SIZE : index;
+}
+
+static inline void input_event_time_line_write_begin(void)
+{
+	WRITE_ONCE(input_event_time_line_header->seq, input_event_time_line_header->seq + 1);
+	smp_wmb();
+}
+
+static inline void input_event_time_line_write_end(void)
+{
+	smp_wmb();
+	WRITE_ONCE(input_event_time_line_header->seq, input_event_time_line_header->seq + 1);
+}
+
 void add_input_event_timeline_before_event_time(int type, u64 frame_count, s64 start_time, s64 end_time)
 {
 	static u64 old_frame_count = -1;
 	input_event_time_line_t *input_event_time_line = NULL;
+	unsigned long flags;
+	int8_t *head = NULL;
+	int8_t *count = NULL;
 	int index = 0;
-	int i = 0;
+	int pos = 0;
 
 	if (!input_event_time_line_base)
 		return;
+
+	spin_lock_irqsave(&input_event_time_line_lock, flags);
 	input_event_time_line = &input_event_time_line_base[input_event_time_line_index];
+	head = &no_event_time_head[input_event_time_line_index];
+	count = &no_event_time_count[input_event_time_line_index];
 	if (type == 0) { /* irq start and end time */
-		if (input_event_time_line->noEventTimeCount >= NO_EVENT_TIME_BUF_SIZE) {
-			for (i = 1; i < NO_EVENT_TIME_BUF_SIZE; i++) {
-				input_event_time_line->startInterruptTime[i - 1] = input_event_time_line->startInterruptTime[i];
-				input_event_time_line->endInterruptTime[i - 1] = input_event_time_line->endInterruptTime[i];
-				input_event_time_line->startThpTime[i - 1] = input_event_time_line->startThpTime[i];
-				input_event_time_line->endThpTime[i - 1] = input_event_time_line->endThpTime[i];
-			}
-			index = NO_EVENT_TIME_BUF_SIZE - 1;
+		input_event_time_line_write_begin();
+		if (*count >= NO_EVENT_TIME_BUF_SIZE) {
+			/* overwrite the oldest one */
+			pos = *head;
+			*head = no_event_time_pos(*head, 1);
 		} else {
-			index = input_event_time_line->noEventTimeCount;
+			pos = no_event_time_pos(*head, *count);
+			(*count)++;
 		}
 		old_frame_count = frame_count;
-		input_event_time_line->startInterruptTime[index] = start_time;
-		input_event_time_line->endInterruptTime[index] = end_time;
-		input_event_time_line->startThpTime[index] = 0;
-		input_event_time_line->endThpTime[index] = 0;
-		input_event_time_line->noEventTimeCount++;
-		if (input_event_time_line->noEventTimeCount >= NO_EVENT_TIME_BUF_SIZE) {
-			input_event_time_line->noEventTimeCount = NO_EVENT_TIME_BUF_SIZE;
-		}
+		input_event_time_line->startInterruptTime[pos] = start_time;
+		input_event_time_line->endInterruptTime[pos] = end_time;
+		input_event_time_line->startThpTime[pos] = 0;
+		input_event_time_line->endThpTime[pos] = 0;
+		input_event_time_line->noEventTimeCount = *count;
+		input_event_time_line_header->noEventTimeHead[input_event_time_line_index] = *head;
+		input_event_time_line_write_end();
 	} else { /* thp start and end time */
-		index = input_event_time_line->noEventTimeCount;
-		if (frame_count > old_frame_count) {
-			return;
-		}
+		index = *count;
+		if (frame_count > old_frame_count)
+			goto exit;
 		index--;
 		index -= (old_frame_count - frame_count);
 		if (index >= NO_EVENT_TIME_BUF_SIZE || index < 0) {
 			LOG_ERROR("type %d has error index %d", type, index);
-			return;
+			goto exit;
 		}
-		input_event_time_line->startThpTime[index] = start_time;
-		input_event_time_line->endThpTime[index] = end_time;
+		pos = no_event_time_pos(*head, index);
+		input_event_time_line_write_begin();
+		input_event_time_line->startThpTime[pos] = start_time;
+		input_event_time_line->endThpTime[pos] = end_time;
+		input_event_time_line_write_end();
 	}
 
+exit:
+	spin_unlock_irqrestore(&input_event_time_line_lock, flags);
 }
 EXPORT_SYMBOL_GPL(add_input_event_timeline_before_event_time);
 
@@ -219,6 +272,7 @@ static void add_input_event_event_time(struct input_handle *handle)
 	static s64 old_event_time = 0;
 	s64 event_time = handle->dev->timestamp[INPUT_CLK_MONO];
 	input_event_time_line_t *input_event_time_line = NULL;
+	unsigned long flags;
 
 	if (!input_event_time_line_base)
 		return;
@@ -233,11 +287,14 @@ static void add_input_event_event_time(struct input_handle *handle)
 
 	old_event_time = event_time;
 	event_time = event_time  / 1000 * 1000;
+
+	spin_lock_irqsave(&input_event_time_line_lock, flags);
 	input_event_time_line = &input_event_time_line_base[input_event_time_line_index];
 
-	if (input_event_time_line->noEventTimeCount >= NO_EVENT_TIME_BUF_SIZE) {
+	if (no_event_time_count[input_event_time_line_index] >= NO_EVENT_TIME_BUF_SIZE) {
 		LOG_ERROR("no point irq count is more than buf, maybe lose data!");
 	}
+	input_event_time_line_write_begin();
 	input_event_time_line->eventTime  = event_time;
 	input_event_time_line->eventId = -1;
 	input_event_time_line->appCount = 0;
@@ -250,7 +307,13 @@ static void add_input_event_event_time(struct input_handle *handle)
 	if (input_event_time_line_index >= INPUT_EVENT_TIME_LINE_BUF_SIZE) {
 		input_event_time_line_index = 0;
 	}
+	no_event_time_count[input_event_time_line_index] = 0;
+	no_event_time_head[input_event_time_line_index] = 0;
 	input_event_time_line_base[input_event_time_line_index].noEventTimeCount = 0;
+	input_event_time_line_header->noEventTimeHead[input_event_time_line_index] = 0;
+	input_event_time_line_header->writeIndex = input_event_time_line_index;
+	input_event_time_line_write_end();
+	spin_unlock_irqrestore(&input_event_time_line_lock, flags);
 }
 
 static void xiaomitouch_input_event(struct input_handle *handle,
@@ -345,14 +408,23 @@ bool init_input_event_timeline(void)
 	if (input_event_time_line_base)
 		return true;
 
+	BUILD_BUG_ON(sizeof(input_event_time_line_t) * INPUT_EVENT_TIME_LINE_BUF_SIZE +
+			sizeof(input_event_time_line_header_t) > INPUT_EVENT_TIME_LINE_MEM_SIZE);
+
 	xiaomi_touch->input_event_time_line_phy_base = 0;
-	xiaomi_touch->input_event_time_line_mmap_base = kzalloc_retry(PAGE_SIZE * 45, 3);
+	xiaomi_touch->input_event_time_line_mmap_base = kzalloc_retry(INPUT_EVENT_TIME_LINE_MEM_SIZE, 3);
 	if (!xiaomi_touch->input_event_time_line_mmap_base) {
 		LOG_ERROR("alloc input event time line memory failed!");
 		return false;
 	} else {
 		LOG_INFO("init input event time line base %p", xiaomi_touch->input_event_time_line_mmap_base);
 		input_event_time_line_base = (input_event_time_line_t *)(xiaomi_touch->input_event_time_line_mmap_base);
+		input_event_time_line_header = (input_event_time_line_header_t *)
+			&input_event_time_line_base[INPUT_EVENT_TIME_LINE_BUF_SIZE];
+		memset(no_event_time_head, 0, sizeof(no_event_time_head));
+		memset(no_event_time_count, 0, sizeof(no_event_time_count));
+		input_event_time_line_header->magic = INPUT_EVENT_TIME_LINE_MAGIC;
+		input_event_time_line_header->version = INPUT_EVENT_TIME_LINE_VERSION;
 		xiaomi_touch->input_event_time_line_phy_base = virt_to_phys(xiaomi_touch->input_event_time_line_mmap_base);
 	}
 	return true;
@@ -367,6 +439,7 @@ void release_input_event_timeline(void)
 	xiaomi_touch->input_event_time_line_phy_base = 0;
 	xiaomi_touch->input_event_time_line_mmap_base = NULL;
 	input_event_time_line_base = NULL;
+	input_event_time_line_header = NULL;
 	input_event_time_line_index = 0;
 	LOG_INFO("input event time line base release");
 }
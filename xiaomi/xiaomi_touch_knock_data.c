@@ -42,6 +42,8 @@ static struct knock_data knock_data = {
  */
 void knock_data_notify(void) {
 	wake_up_all(&(knock_data.wait_data_complete_queue_head));
+	/* knock data belongs to touch id 0, see knock_data_write() */
+	notify_xiaomi_touch(get_xiaomi_touch_data(0), KNOCK_DATA_NOTIFY);
 }
 EXPORT_SYMBOL_GPL(knock_data_notify);
 
@@ -29,6 +29,7 @@ static int xiaomi_touch_dev_open(struct inode *inode, struct file *file)
 	init_waitqueue_head(&client_private_data->poll_wait_queue_head_for_cmd);
 	init_waitqueue_head(&client_private_data->poll_wait_queue_head_for_frame);
 	init_waitqueue_head(&client_private_data->poll_wait_queue_head_for_raw);
+	mutex_init(&client_private_data->eventfd_lock);
 
 	file->private_data = client_private_data;
 	LOG_DEBUG("open xiaomi_touch sucess! private data is %p, open count %d", client_private_data, xiaomi_touch->use_count);
@@ -39,6 +40,8 @@ static int xiaomi_touch_dev_release(struct inode *inode, struct file *file)
 {
 	private_data_t *client_private_data = file->private_data;
 	xiaomi_touch_data_t *xiaomi_touch_data = get_xiaomi_touch_data(client_private_data->touch_id);
+	struct eventfd_ctx *eventfd = NULL;
+	int i = 0;
 	if (!xiaomi_touch_data) {
 		goto release_end;
 	}
@@ -49,6 +52,12 @@ static int xiaomi_touch_dev_release(struct inode *inode, struct file *file)
 	synchronize_rcu();
 
 release_end:
+	for (i = 0; i < POLL_NOTIFY_TYPE_MAX; i++) {
+		eventfd = rcu_dereference_protected(client_private_data->eventfd[i], true);
+		if (eventfd)
+			eventfd_ctx_put(eventfd);
+	}
+	mutex_destroy(&client_private_data->eventfd_lock);
 	xiaomi_touch->use_count--;
 	LOG_DEBUG("close xiaomi_touch sucess! private data is %p, open count %d", client_private_data, xiaomi_touch->use_count);
 	kzalloc_free(client_private_data);
@@ -194,6 +203,9 @@ static int xiaomi_touch_dev_mmap(struct file *file, struct vm_area_struct *vma)
 	} else if (client_private_data->mmap_area == 4) {
 		LOG_INFO("mmap report point buf mmap");
 		temp_phy_bas = get_report_point_info_phy_addr();
+	} else if (client_private_data->mmap_area == 5) {
+		LOG_INFO("mmap data ring header mmap");
+		temp_phy_bas = xiaomi_touch_data->data_ring_header_phy_base;
 	}
 	if (!temp_phy_bas) {
 		LOG_ERROR("phy bas is NULL, return!");
@@ -210,6 +222,42 @@ static int xiaomi_touch_dev_mmap(struct file *file, struct vm_area_struct *vma)
 	return 0;
 }
 
+static int xiaomi_touch_set_eventfd(private_data_t *client_private_data, unsigned long arg)
+{
+	eventfd_param_t eventfd_param;
+	struct eventfd_ctx *eventfd = NULL;
+	struct eventfd_ctx *old_eventfd = NULL;
+
+	if (copy_from_user(&eventfd_param, (void __user *)arg, sizeof(eventfd_param))) {
+		LOG_ERROR("copy eventfd param failed!");
+		return -EFAULT;
+	}
+	if (eventfd_param.notify_type < 0 || eventfd_param.notify_type >= POLL_NOTIFY_TYPE_MAX) {
+		LOG_ERROR("error notify type %d, return!", eventfd_param.notify_type);
+		return -EINVAL;
+	}
+	if (eventfd_param.fd >= 0) {
+		eventfd = eventfd_ctx_fdget(eventfd_param.fd);
+		if (IS_ERR(eventfd)) {
+			LOG_ERROR("get eventfd %d failed!", eventfd_param.fd);
+			return PTR_ERR(eventfd);
+		}
+	}
+
+	mutex_lock(&client_private_data->eventfd_lock);
+	old_eventfd = rcu_dereference_protected(client_private_data->eventfd[eventfd_param.notify_type],
+		lockdep_is_held(&client_private_data->eventfd_lock));
+	rcu_assign_pointer(client_private_data->eventfd[eventfd_param.notify_type], eventfd);
+	mutex_unlock(&client_private_data->eventfd_lock);
+
+	if (old_eventfd) {
+		synchronize_rcu();
+		eventfd_ctx_put(old_eventfd);
+	}
+	LOG_INFO("%s eventfd for notify type %d", eventfd ? "set" : "clear", eventfd_param.notify_type);
+	return 0;
+}
+
 static long xiaomi_touch_dev_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 {
 	private_data_t *client_private_data = file->private_data;
@@ -229,9 +277,7 @@ static long xiaomi_touch_dev_ioctl(struct file *file, unsigned int cmd, unsigned
 			return -1;
 		if (_IOC_DIR(cmd) == _IOC_WRITE) {
 			LOG_DEBUG("raw data update, buf index is %d", atomic_read(&xiaomi_touch_data->raw_data_buf_index));
-			atomic_inc(&xiaomi_touch_data->raw_data_buf_index);
-			if (atomic_read(&xiaomi_touch_data->raw_data_buf_index) >= xiaomi_touch_data->raw_data_buf_size)
-				atomic_set(&xiaomi_touch_data->raw_data_buf_index, 0);
+			publish_data_ring_slot(xiaomi_touch_data, RAW_DATA_NOTIFY);
 			notify_xiaomi_touch(xiaomi_touch_data, RAW_DATA_NOTIFY);
 			return 0;
 		} else if (_IOC_DIR(cmd) == _IOC_READ) {
@@ -304,6 +350,12 @@ static long xiaomi_touch_dev_ioctl(struct file *file, unsigned int cmd, unsigned
 		return -1;
 	case COMMON_DATA_CMD:
 		return xiaomi_touch_mode(client_private_data, user_size, arg);
+	case SET_EVENTFD_CMD:
+		if (user_size != sizeof(eventfd_param_t)) {
+			LOG_ERROR("error eventfd param size %d %lu, return!", user_size, sizeof(eventfd_param_t));
+			return -EINVAL;
+		}
+		return xiaomi_touch_set_eventfd(client_private_data, arg);
 	default:
 		LOG_ERROR("unrecognize user cmd, magic number is %d, cmd is %d, size is %d, return!", user_magic_number, user_cmd, user_size);
 		return -EINVAL;
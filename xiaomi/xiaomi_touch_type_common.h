@@ -91,6 +91,15 @@ enum ioctl_cmd {
 	GET_FRAME_DATA_INDEX,
 	RAW_DATA_INDEX,
 	UPDATE_REPORT_POINT,
+	SET_EVENTFD_CMD,
+};
+
+enum poll_notify_type {
+	COMMON_DATA_NOTIFY = 0,
+	FRAME_DATA_NOTIFY,
+	RAW_DATA_NOTIFY,
+	KNOCK_DATA_NOTIFY,
+	POLL_NOTIFY_TYPE_MAX,
 };
 
 enum common_data_cmd {
@@ -294,6 +303,50 @@ typedef struct hardware_param {
 	u8 temp_change_value;
 } hardware_param_t;
 
+/*
+ * Header page shared with userspace for the frame data and raw data areas,
+ * mapped through mmap area 5.
+ *
+ * A reader of slot i shall load slots[i].seq, retry if it is odd, copy the
+ * data, then check slots[i].seq is unchanged; otherwise the slot was being
+ * overwritten and the copy is torn. frame_number tells whether frames were
+ * skipped, a frame_number of 0 means the slot holds no frame. overrun_count
+ * is increased by the writer whenever it overwrites a slot which a
+ * registered client has not fetched yet.
+ */
+#define DATA_RING_MAX_SLOTS	64
+
+typedef struct data_ring_slot {
+	u32 seq;
+	u32 reserved;
+	u64 frame_number;
+	s64 timestamp_ns;
+} data_ring_slot_t;
+
+typedef struct data_ring_header {
+	u32 slot_count;
+	u32 write_index;
+	u64 frame_number;
+	u32 overrun_count;
+	u32 reserved;
+	data_ring_slot_t slots[DATA_RING_MAX_SLOTS];
+} data_ring_header_t;
+
+typedef struct data_ring_header_page {
+	data_ring_header_t frame_data;
+	data_ring_header_t raw_data;
+} data_ring_header_page_t;
+
+/*
+ * Argument of SET_EVENTFD_CMD. Once an eventfd is set for a notify type,
+ * the client gets it signaled for that type instead of the poll wakeup.
+ * An fd < 0 removes it and the client falls back to poll.
+ */
+typedef struct eventfd_param {
+	s32 notify_type;
+	s32 fd;
+} eventfd_param_t;
+
 enum touch_dump_type {
 	DUMP_OFF = 0,
 	DUMP_ON = 1,